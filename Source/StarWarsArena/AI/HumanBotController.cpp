@@ -0,0 +1,509 @@
+#include "HumanBotController.h"
+#include "HumanBotManager.h"
+#include "MoveSet.h"
+#include "Objects/Saber.h"
+
+AHumanBotController::AHumanBotController() :
+	AttackRange( 180.f ),
+	PreferredRange( 400.f ),
+	DefendRange( 300.f ),
+	MinThrowRange( 600.f ),
+	MaxThrowRange( 1500.f ),
+	TurnRate( 360.f ),
+	Commitment( 0.15f ),
+	DecisionNoise( 0.1f ),
+	PressGap( 0.1f ),
+	MaxActionTime( 3.f ),
+	m_bCombosBuilt( false ),
+	m_TargetLocation( FVector::ZeroVector ),
+	m_Action( EBotAction::Idle ),
+	m_ActionStartTime( 0.0 ),
+	m_NextThinkTime( 0.0 ),
+	m_PressIndex( 0 ),
+	m_bPressing( false ),
+	m_PressTime( 0.0 ),
+	m_bDefendHeld( false ),
+	m_bThrowHeld( false ),
+	m_StrafeSign( 1.f ),
+	m_Aggression( 1.f )
+{
+	bWantsPlayerState = true;
+	bReplicates = false;
+
+	/* Executed by AHumanBotManager */
+	PrimaryActorTick.bCanEverTick = false;
+}
+
+void AHumanBotController::BeginPlay()
+{
+	Super::BeginPlay();
+
+	m_Random.Initialize( GetUniqueID() );
+	m_Aggression = m_Random.FRandRange( 0.7f, 1.3f );
+	m_StrafeSign = m_Random.FRand() < 0.5f ? -1.f : 1.f;
+
+	if( AHumanBotManager * Manager = AHumanBotManager::Get( GetWorld() ) )
+		Manager->RegisterBot( this );
+}
+
+void AHumanBotController::EndPlay( const EEndPlayReason::Type EndPlayReason )
+{
+	if( AHumanBotManager * Manager = AHumanBotManager::Get( GetWorld(), false ) )
+		Manager->UnregisterBot( this );
+
+	Super::EndPlay( EndPlayReason );
+}
+
+void AHumanBotController::Possess( APawn * InPawn )
+{
+	Super::Possess( InPawn );
+
+	/* New pawn may have another move set, nothing is held on it yet */
+	m_bCombosBuilt = false;
+	m_bPressing = false;
+	m_bDefendHeld = false;
+	m_bThrowHeld = false;
+	m_Action = EBotAction::Idle;
+	m_Target = nullptr;
+	m_NextThinkTime = 0.0;
+}
+
+AHuman * AHumanBotController::GetHuman() const
+{
+	return Cast<AHuman>( GetPawn() );
+}
+
+const TCHAR * AHumanBotController::ActionName( EBotAction Action )
+{
+	switch( Action )
+	{
+		case EBotAction::Idle :			return TEXT( "Idle" );
+		case EBotAction::Approach :		return TEXT( "Approach" );
+		case EBotAction::Retreat :		return TEXT( "Retreat" );
+		case EBotAction::Strafe :		return TEXT( "Strafe" );
+		case EBotAction::Attack :		return TEXT( "Attack" );
+		case EBotAction::Defend :		return TEXT( "Defend" );
+		case EBotAction::Throw :		return TEXT( "Throw" );
+		default :						break;
+	}
+
+	return TEXT( "Unknown" );
+}
+
+void AHumanBotController::BuildCombos( AHuman * Human )
+{
+	m_Combos.Reset();
+	m_bCombosBuilt = true;
+
+	const UMoveSet * MoveSet = Human->GetMoveSet();
+	if( !MoveSet )
+		return;
+
+	/* Short press plays a weak follow up, long press a strong one */
+	const float ShortHold = MoveSet->GetLongPressDuration() * 0.5f;
+	const float LongHold = MoveSet->GetLongPressDuration() * 1.5f;
+
+	/* Opening depends on movement direction, so the costliest one is assumed */
+	FBotCombo Opening;
+	Opening.Holds.Add( ShortHold );
+
+	for( const FAttackMontage & Attack : MoveSet->GetOpeningAttacks() )
+	{
+		Opening.StaminaRequired = FMath::Max( Opening.StaminaRequired, Attack.StaminaRequired );
+		Opening.ForceRequired = FMath::Max( Opening.ForceRequired, Attack.ForceRequired );
+		Opening.DealtDamage = FMath::Max( Opening.DealtDamage, Attack.DealtDamage );
+	}
+
+	m_Combos.Add( Opening );
+
+	static const TCHAR * FollowUps[] = { TEXT( "Weak" ), TEXT( "Strong" ), TEXT( "WeakWeak" ), TEXT( "WeakStrong" ), TEXT( "StrongWeak" ), TEXT( "StrongStrong" ) };
+
+	for( const TCHAR * FollowUp : FollowUps )
+	{
+		const FAttackMontage * Attack = MoveSet->FindFurtherAttack( FollowUp );
+		if( !Attack )
+			continue;
+
+		/* Every Weak or Strong of the name is one more press */
+		FBotCombo Combo = Opening;
+		for( const TCHAR * Press = FollowUp; *Press; )
+		{
+			const bool bStrong = *Press == TEXT( 'S' );
+			Combo.Holds.Add( bStrong ? LongHold : ShortHold );
+			Press += bStrong ? 6 : 4;
+		}
+
+		Combo.StaminaRequired += Attack->StaminaRequired;
+		Combo.ForceRequired += Attack->ForceRequired;
+		Combo.DealtDamage += Attack->DealtDamage;
+		m_Combos.Add( Combo );
+	}
+}
+
+const FBotCombo * AHumanBotController::PickCombo( AHuman * Human, float & OutScore )
+{
+	OutScore = 0.f;
+
+	const FHumanStats Stats = Human->GetCurrentStats();
+	const FHumanStats MaxStats = Human->GetMaxStats();
+
+	int32 MaxDamage = 1;
+	for( const FBotCombo & Combo : m_Combos )
+		MaxDamage = FMath::Max( MaxDamage, Combo.DealtDamage );
+
+	/* Damage against the share of stamina it eats, plus noise so bots vary their combos */
+	const FBotCombo * Best = nullptr;
+	for( const FBotCombo & Combo : m_Combos )
+	{
+		if( Combo.StaminaRequired > Stats.HS_Stamina || Combo.ForceRequired > Stats.HS_Force )
+			continue;
+
+		const float StaminaShare = MaxStats.HS_Stamina > 0 ? float( Combo.StaminaRequired ) / MaxStats.HS_Stamina : 0.f;
+		const float Score = FMath::Clamp( float( Combo.DealtDamage ) / MaxDamage - 0.3f * StaminaShare + m_Random.FRandRange( 0.f, DecisionNoise ), 0.f, 1.f );
+
+		if( !Best || Score > OutScore )
+		{
+			Best = &Combo;
+			OutScore = Score;
+		}
+	}
+
+	return Best;
+}
+
+float AHumanBotController::ScoreAction( EBotAction Action, AHuman * Human, const FBotTarget & Target, float Distance, float ComboScore ) const
+{
+	const FHumanStats Stats = Human->GetCurrentStats();
+	const FHumanStats MaxStats = Human->GetMaxStats();
+
+	const float Stamina = MaxStats.HS_Stamina > 0 ? float( Stats.HS_Stamina ) / MaxStats.HS_Stamina : 1.f;
+	const float Health = MaxStats.HS_Health > 0 ? float( Stats.HS_Health ) / MaxStats.HS_Health : 1.f;
+
+	const EHumanState State = Human->GetState();
+	const bool bFree = State == EHumanState::EHS_Free;
+
+	switch( Action )
+	{
+		case EBotAction::Idle :
+			return 0.05f;
+
+		case EBotAction::Approach :
+			if( Distance <= AttackRange )
+				return 0.f;
+
+			return FMath::Clamp( ( Distance - AttackRange ) / PreferredRange, 0.f, 1.f ) * ( 0.4f + 0.6f * Stamina ) * m_Aggression;
+
+		case EBotAction::Retreat :
+			if( Distance >= PreferredRange )
+				return 0.f;
+
+			return ( 1.f - Stamina ) * ( 1.f - Distance / PreferredRange ) * 1.2f;
+
+		case EBotAction::Strafe :
+			return Distance <= PreferredRange ? 0.3f * Stamina : 0.f;
+
+		case EBotAction::Attack :
+		{
+			if( !bFree || ComboScore < 0.f || Distance > AttackRange )
+				return 0.f;
+
+			/* Defending target blocks most of it */
+			const float TargetScale = Target.State == EHumanState::EHS_Defending ? 0.5f : 1.f;
+
+			return ( 0.2f + 0.8f * ComboScore ) * ( 0.6f + 0.4f * Stamina ) * TargetScale * m_Aggression;
+		}
+
+		case EBotAction::Defend :
+			if( Target.State != EHumanState::EHS_Attacking || Distance > DefendRange || ( !bFree && State != EHumanState::EHS_Defending ) )
+				return 0.f;
+
+			return 0.7f + 0.3f * ( 1.f - Health );
+
+		case EBotAction::Throw :
+		{
+			ASaber * Saber = Human->GetSaber();
+			if( !bFree || !Saber || Saber->GetSaberState() != ESaberState::ESS_Opened || Distance < MinThrowRange || Distance > MaxThrowRange )
+				return 0.f;
+
+			return 0.45f * m_Aggression;
+		}
+
+		default :
+			break;
+	}
+
+	return 0.f;
+}
+
+void AHumanBotController::Think( double Now, const TArray<FBotTarget> & Targets )
+{
+	AHuman * Human = GetHuman();
+	if( !Human || Human->GetCurrentStats().HS_Health <= 0 )
+		return;
+
+	if( !m_bCombosBuilt )
+		BuildCombos( Human );
+
+	/* Saber has to be out before anything else */
+	if( !Human->IsInCombat() )
+	{
+		if( Human->GetState() == EHumanState::EHS_Free )
+			Human->ToggleCombat();
+
+		return;
+	}
+
+	/* Nearest human still alive */
+	const FVector Location = Human->GetActorLocation();
+	const FBotTarget * Target = nullptr;
+	float BestDistSq = MAX_flt;
+
+	for( const FBotTarget & Candidate : Targets )
+	{
+		if( Candidate.Human.Get() == Human || Candidate.Health <= 0 )
+			continue;
+
+		const float DistSq = FVector::DistSquared( Candidate.Location, Location );
+		if( DistSq < BestDistSq )
+		{
+			BestDistSq = DistSq;
+			Target = &Candidate;
+		}
+	}
+
+	if( !Target )
+	{
+		m_Target = nullptr;
+		if( m_Action != EBotAction::Idle )
+			StartAction( EBotAction::Idle, Now );
+
+		return;
+	}
+
+	m_Target = Target->Human;
+	m_TargetLocation = Target->Location;
+
+	/* Attacks and throws are played to their end, Execute asks for a think then */
+	if( m_Action == EBotAction::Attack || m_Action == EBotAction::Throw )
+		return;
+
+	float ComboScore = 0.f;
+	const FBotCombo * Combo = PickCombo( Human, ComboScore );
+
+	const float Distance = FVector::Dist2D( Target->Location, Location );
+
+	EBotAction BestAction = EBotAction::Idle;
+	float BestScore = -1.f;
+
+	for( int32 i = 0; i < int32( EBotAction::Count ); ++i )
+	{
+		const EBotAction Action = EBotAction( i );
+
+		float Score = ScoreAction( Action, Human, *Target, Distance, Combo ? ComboScore : -1.f );
+		if( Score <= 0.f )
+			continue;
+
+		Score += m_Random.FRandRange( 0.f, DecisionNoise );
+		if( Action == m_Action )
+			Score += Commitment;
+
+		if( Score > BestScore )
+		{
+			BestScore = Score;
+			BestAction = Action;
+		}
+	}
+
+	if( BestAction == m_Action )
+		return;
+
+	if( BestAction == EBotAction::Attack )
+		m_Combo = *Combo;
+
+	StartAction( BestAction, Now );
+}
+
+void AHumanBotController::StartAction( EBotAction Action, double Now )
+{
+	ReleaseButtons();
+
+	m_Action = Action;
+	m_ActionStartTime = Now;
+
+	AHuman * Human = GetHuman();
+	if( !Human )
+		return;
+
+	switch( Action )
+	{
+		case EBotAction::Attack :
+			m_PressIndex = 0;
+			m_PressTime = Now;
+			break;
+
+		case EBotAction::Defend :
+			Human->SwitchDefending();
+			m_bDefendHeld = true;
+			break;
+
+		case EBotAction::Throw :
+			Human->ThrowSaber();
+			m_bThrowHeld = true;
+			break;
+
+		case EBotAction::Strafe :
+			if( m_Random.FRand() < 0.3f )
+				m_StrafeSign = -m_StrafeSign;
+			break;
+
+		default :
+			break;
+	}
+}
+
+void AHumanBotController::EndAction( double Now )
+{
+	ReleaseButtons();
+
+	m_Action = EBotAction::Idle;
+	m_NextThinkTime = Now;
+}
+
+void AHumanBotController::ReleaseButtons()
+{
+	if( AHuman * Human = GetHuman() )
+	{
+		if( m_bPressing )
+			Human->StopAttack();
+
+		if( m_bDefendHeld )
+			Human->SwitchDefending();
+
+		if( m_bThrowHeld )
+			Human->StopThrowingSaber();
+	}
+
+	m_bPressing = false;
+	m_bDefendHeld = false;
+	m_bThrowHeld = false;
+}
+
+bool AHumanBotController::ExecuteAttack( AHuman * Human, double Now )
+{
+	const bool bAttacking = Human->GetState() == EHumanState::EHS_Attacking;
+
+	if( m_PressIndex < m_Combo.Holds.Num() )
+	{
+		/* Interrupted between two presses, by an impact or a clash */
+		if( m_PressIndex > 0 && !m_bPressing && !bAttacking )
+			return false;
+
+		if( Now >= m_PressTime )
+		{
+			if( m_bPressing )
+			{
+				Human->StopAttack();
+				m_bPressing = false;
+				m_PressTime = Now + PressGap;
+				++m_PressIndex;
+			}
+			else
+			{
+				Human->Attack();
+				m_bPressing = true;
+				m_PressTime = Now + m_Combo.Holds[ m_PressIndex ];
+			}
+		}
+
+		return true;
+	}
+
+	/* Everything pressed, wait for the attack to play out */
+	return bAttacking || Now < m_PressTime;
+}
+
+void AHumanBotController::Execute( double Now, float DeltaTime )
+{
+	AHuman * Human = GetHuman();
+	if( !Human || m_Action == EBotAction::Idle )
+		return;
+
+	if( Human->GetCurrentStats().HS_Health <= 0 )
+	{
+		EndAction( Now );
+		return;
+	}
+
+	/* Think saw the target up to ThinkInterval ago, aim and distance use where it is now */
+	if( const AHuman * Target = m_Target.Get() )
+		m_TargetLocation = Target->GetActorLocation();
+
+	const FVector ToTarget = m_TargetLocation - Human->GetActorLocation();
+	const float Distance = ToTarget.Size2D();
+
+	/* Movement axes are relative to aim, as they are for a player */
+	if( m_Target.IsValid() )
+	{
+		SetControlRotation( FMath::RInterpConstantTo( GetControlRotation(), ToTarget.Rotation(), DeltaTime, TurnRate ) );
+		Human->FaceRotation( GetControlRotation(), DeltaTime );
+	}
+
+	float Forward = 0.f;
+	float Right = 0.f;
+	bool bDone = Now - m_ActionStartTime > MaxActionTime;
+
+	switch( m_Action )
+	{
+		case EBotAction::Approach :
+			Forward = 1.f;
+			bDone |= Distance <= AttackRange;
+			break;
+
+		case EBotAction::Retreat :
+			Forward = -1.f;
+			bDone |= Distance >= PreferredRange;
+			break;
+
+		case EBotAction::Strafe :
+			Right = m_StrafeSign;
+			Forward = Distance > AttackRange ? 0.5f : Distance < AttackRange * 0.5f ? -0.5f : 0.f;
+			break;
+
+		case EBotAction::Attack :
+			Forward = Distance > AttackRange * 0.75f ? 0.5f : 0.f;
+			bDone |= !ExecuteAttack( Human, Now );
+			break;
+
+		case EBotAction::Defend :
+		{
+			/* Held a little past the attack, so a late swing is blocked too */
+			AHuman * Target = m_Target.Get();
+			bDone |= Now - m_ActionStartTime > PressGap * 3.f && ( !Target || Target->GetState() != EHumanState::EHS_Attacking );
+			break;
+		}
+
+		case EBotAction::Throw :
+		{
+			/* Released once the blade passed the target or hit something, saber comes back on release */
+			ASaber * Saber = Human->GetSaber();
+			if( m_bThrowHeld && Now - m_ActionStartTime > PressGap &&
+				( !Saber || !Saber->IsThrown() || FVector::Dist( Saber->GetActorLocation(), Human->GetActorLocation() ) >= Distance ) )
+			{
+				Human->StopThrowingSaber();
+				m_bThrowHeld = false;
+			}
+
+			bDone |= !m_bThrowHeld && Human->GetState() != EHumanState::EHS_ThrowingSaber;
+			break;
+		}
+
+		default :
+			break;
+	}
+
+	Human->MoveForward( Forward );
+	Human->MoveRight( Right );
+
+	if( bDone )
+		EndAction( Now );
+}
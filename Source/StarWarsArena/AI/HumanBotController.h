@@ -0,0 +1,169 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Controller.h"
+#include "Human.h"
+#include "HumanBotController.generated.h"
+
+/* What a bot is doing between two decisions */
+enum class EBotAction : uint8
+{
+	Idle,
+	/* Close the distance to the target */
+	Approach,
+	/* Back off to regain stamina */
+	Retreat,
+	/* Circle the target at attack range */
+	Strafe,
+	Attack,
+	Defend,
+	Throw,
+	Count
+};
+
+/* Human the bots know about, gathered once per frame by AHumanBotManager */
+struct FBotTarget
+{
+	TWeakObjectPtr<AHuman>				Human;
+	FVector								Location = FVector::ZeroVector;
+	EHumanState							State = EHumanState::EHS_Free;
+	int32								Health = 0;
+};
+
+/* Opening attack and an optional follow up chosen by the holds of one or two presses during it */
+struct FBotCombo
+{
+	/* Attack button hold of every press, the first one opens */
+	TArray<float, TInlineAllocator<3>>	Holds;
+
+	int32								StaminaRequired = 0;
+	int32								ForceRequired = 0;
+	int32								DealtDamage = 0;
+};
+
+/**
+* Native opponent for practice and load tests. Possesses a human on server and presses the same
+* input handlers as a player: Attack, StopAttack, SwitchDefending, ThrowSaber, movement axes.
+* Decisions are made by a utility scorer in Think, which AHumanBotManager time slices across frames
+* under a global budget. Execute runs for every bot every frame and only plays the chosen action.
+* Bots do not tick on their own and do not replicate.
+*/
+UCLASS( NotPlaceable, Transient, Config = Game )
+class STARWARSARENA_API AHumanBotController : public AController
+{
+	GENERATED_BODY()
+
+public:
+	AHumanBotController();
+
+	virtual void						Possess( APawn * InPawn ) override;
+
+	/* Picks a target and scores every action, starting the best one. Time sliced */
+	void								Think( double Now, const TArray<FBotTarget> & Targets );
+
+	/* Feeds movement, turns towards the target and presses buttons of the current action. Every frame */
+	void								Execute( double Now, float DeltaTime );
+
+	/* Bots are thought about again after ThinkInterval, or right away when their action ends */
+	double								GetNextThinkTime() const									{ return m_NextThinkTime; }
+
+	void								SetNextThinkTime( double Time )								{ m_NextThinkTime = Time; }
+
+	AHuman *							GetHuman() const;
+
+	EBotAction							GetAction() const											{ return m_Action; }
+
+	static const TCHAR *				ActionName( EBotAction Action );
+
+protected:
+	/* Distance to the target the bot attacks from */
+	UPROPERTY( Config )
+	float								AttackRange;
+
+	/* Target further than this is approached */
+	UPROPERTY( Config )
+	float								PreferredRange;
+
+	/* Attacking target this close is defended against */
+	UPROPERTY( Config )
+	float								DefendRange;
+
+	/* Saber is only thrown at targets in this distance band */
+	UPROPERTY( Config )
+	float								MinThrowRange;
+
+	UPROPERTY( Config )
+	float								MaxThrowRange;
+
+	/* Degrees per second the bot turns its aim */
+	UPROPERTY( Config )
+	float								TurnRate;
+
+	/* Score bonus of the current action, so bots do not flip between two close scores */
+	UPROPERTY( Config )
+	float								Commitment;
+
+	/* Random part of every score, bots of the same situation do not act in lockstep */
+	UPROPERTY( Config )
+	float								DecisionNoise;
+
+	/* Seconds between presses of a combo and after the last release */
+	UPROPERTY( Config )
+	float								PressGap;
+
+	/* Longest an action runs before the bot thinks again */
+	UPROPERTY( Config )
+	float								MaxActionTime;
+
+	virtual void						BeginPlay() override;
+	virtual void						EndPlay( const EEndPlayReason::Type EndPlayReason ) override;
+
+private:
+	/* One opening and its six follow ups, built from the move set on first think */
+	void								BuildCombos( AHuman * Human );
+
+	/* Best affordable combo and its score 0..1, null if none */
+	const FBotCombo *					PickCombo( AHuman * Human, float & OutScore );
+
+	/* Utility of the action now, 0 when it makes no sense. ComboScore is negative if no combo is affordable */
+	float								ScoreAction( EBotAction Action, AHuman * Human, const FBotTarget & Target, float Distance, float ComboScore ) const;
+
+	void								StartAction( EBotAction Action, double Now );
+
+	void								EndAction( double Now );
+
+	/* Releases whatever the action holds */
+	void								ReleaseButtons();
+
+	/* Presses and releases attack along m_Combo. True while presses remain or the attack plays */
+	bool								ExecuteAttack( AHuman * Human, double Now );
+
+	TArray<FBotCombo>					m_Combos;
+	bool								m_bCombosBuilt;
+
+	TWeakObjectPtr<AHuman>				m_Target;
+	FVector								m_TargetLocation;
+
+	EBotAction							m_Action;
+	double								m_ActionStartTime;
+	double								m_NextThinkTime;
+
+	/* Combo being played, press index and whether the button is down */
+	FBotCombo							m_Combo;
+	int32								m_PressIndex;
+	bool								m_bPressing;
+	double								m_PressTime;
+
+	bool								m_bDefendHeld;
+	bool								m_bThrowHeld;
+
+	/* Strafe direction, flipped every now and then */
+	float								m_StrafeSign;
+
+	/* Per bot multiplier of attack scores, some bots are more aggressive than others */
+	float								m_Aggression;
+
+	FRandomStream						m_Random;
+};
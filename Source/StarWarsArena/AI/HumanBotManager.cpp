@@ -0,0 +1,280 @@
+#include "HumanBotManager.h"
+#include "Human.h"
+#include "Diagnostics/HitchWatchdog.h"
+#include "Net/NetPacking.h"
+#include "GameFramework/GameModeBase.h"
+#include "GameFramework/PlayerState.h"
+#include "Engine/World.h"
+
+#include "EngineUtils.h"
+
+static FAutoConsoleCommandWithWorldAndArgs AddBotsCommand(
+	TEXT( "swa.AddBots" ),
+	TEXT( "Spawns N bots ( 1 by default ) at player starts. Server only." ),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda( []( const TArray<FString> & Args, UWorld * World )
+	{
+		if( AHumanBotManager * Manager = AHumanBotManager::Get( World ) )
+			Manager->SpawnBots( Args.Num() > 0 ? FCString::Atoi( *Args[ 0 ] ) : 1 );
+	} ) );
+
+static FAutoConsoleCommandWithWorldAndArgs RemoveBotsCommand(
+	TEXT( "swa.RemoveBots" ),
+	TEXT( "Destroys N bots and their humans, all of them by default." ),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda( []( const TArray<FString> & Args, UWorld * World )
+	{
+		if( AHumanBotManager * Manager = AHumanBotManager::Get( World, false ) )
+			Manager->RemoveBots( Args.Num() > 0 ? FCString::Atoi( *Args[ 0 ] ) : Manager->GetNumBots() );
+	} ) );
+
+static FAutoConsoleCommandWithWorld BotStatsCommand(
+	TEXT( "swa.BotStats" ),
+	TEXT( "Logs bot count, think time per frame and how late decisions were since the last call." ),
+	FConsoleCommandWithWorldDelegate::CreateLambda( []( UWorld * World )
+	{
+		if( AHumanBotManager * Manager = AHumanBotManager::Get( World, false ) )
+			Manager->LogStats();
+		else
+			UE_LOG( LogTemp, Display, TEXT( "No bots in this world" ) );
+	} ) );
+
+AHumanBotManager::AHumanBotManager() :
+	ThinkBudgetMs( 0.5f ),
+	ThinkInterval( 0.25f ),
+	m_ThinkCursor( 0 ),
+	m_NextBotNumber( 0 ),
+	m_NumFrames( 0 ),
+	m_NumThinks( 0 ),
+	m_NumBudgetFrames( 0 ),
+	m_ThinkCycles( 0 ),
+	m_MaxThinkMs( 0.f ),
+	m_MaxThinkDelay( 0.f )
+{
+	bReplicates = false;
+
+	PrimaryActorTick.bCanEverTick = true;
+}
+
+AHumanBotManager * AHumanBotManager::Get( UWorld * World, bool bSpawnIfMissing )
+{
+	if( !World || World->GetNetMode() == NM_Client )
+		return nullptr;
+
+	for( TActorIterator<AHumanBotManager> It( World ); It; ++It )
+	{
+		if( !It->IsPendingKill() )
+			return *It;
+	}
+
+	if( !bSpawnIfMissing )
+		return nullptr;
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	SpawnParams.ObjectFlags |= RF_Transient;
+
+	return World->SpawnActor<AHumanBotManager>( SpawnParams );
+}
+
+int32 AHumanBotManager::SpawnBots( int32 Count )
+{
+	AGameModeBase * GameMode = GetWorld()->GetAuthGameMode();
+	if( !GameMode )
+		return 0;
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	SpawnParams.ObjectFlags |= RF_Transient;
+
+	int32 NumSpawned = 0;
+	for( int32 i = 0; i < Count; ++i )
+	{
+		AHumanBotController * Bot = GetWorld()->SpawnActor<AHumanBotController>( SpawnParams );
+		if( !Bot )
+			break;
+
+		if( Bot->PlayerState )
+		{
+			Bot->PlayerState->bIsABot = true;
+			Bot->PlayerState->SetPlayerName( FString::Printf( TEXT( "Bot %d" ), ++m_NextBotNumber ) );
+		}
+
+		/* Same default pawn and player start choice as a player joining */
+		GameMode->RestartPlayer( Bot );
+
+		if( !Bot->GetPawn() )
+		{
+			UE_LOG( LogTemp, Warning, TEXT( "%s : game mode gave no pawn to a bot, no more bots are spawned." ), *GetName() );
+			Bot->Destroy();
+			break;
+		}
+
+		++NumSpawned;
+	}
+
+	UE_LOG( LogTemp, Log, TEXT( "%s : %d bots spawned, %d in the world." ), *GetName(), NumSpawned, m_Bots.Num() );
+
+	return NumSpawned;
+}
+
+void AHumanBotManager::RemoveBots( int32 Count )
+{
+	/* Destroy unregisters, so the bots are picked first */
+	TArray<AHumanBotController *> Removed;
+	for( int32 i = m_Bots.Num() - 1; i >= 0 && Removed.Num() < Count; --i )
+	{
+		if( AHumanBotController * Bot = m_Bots[ i ].Get() )
+			Removed.Add( Bot );
+	}
+
+	for( AHumanBotController * Bot : Removed )
+	{
+		if( APawn * Pawn = Bot->GetPawn() )
+			Pawn->Destroy();
+
+		Bot->Destroy();
+	}
+
+	UE_LOG( LogTemp, Log, TEXT( "%s : %d bots removed, %d left." ), *GetName(), Removed.Num(), m_Bots.Num() );
+}
+
+void AHumanBotManager::EndPlay( const EEndPlayReason::Type EndPlayReason )
+{
+	/* End of a bot soak, the last window and what packing saved over it */
+	if( m_NumFrames > 0 )
+		LogStats();
+
+	Super::EndPlay( EndPlayReason );
+}
+
+void AHumanBotManager::RegisterBot( AHumanBotController * Bot )
+{
+	m_Bots.AddUnique( Bot );
+}
+
+void AHumanBotManager::UnregisterBot( AHumanBotController * Bot )
+{
+	m_Bots.Remove( Bot );
+}
+
+void AHumanBotManager::GatherTargets()
+{
+	m_Targets.Reset();
+
+	for( TActorIterator<AHuman> It( GetWorld() ); It; ++It )
+	{
+		AHuman * Human = *It;
+		if( Human->IsPendingKill() )
+			continue;
+
+		FBotTarget Target;
+		Target.Human = Human;
+		Target.Location = Human->GetActorLocation();
+		Target.State = Human->GetState();
+		Target.Health = Human->GetCurrentStats().HS_Health;
+		m_Targets.Add( Target );
+	}
+}
+
+void AHumanBotManager::Tick( float DeltaTime )
+{
+	HITCH_TIMER( GetWorld(), EHitchTimer::Bots );
+
+	Super::Tick( DeltaTime );
+
+	const int32 NumBots = m_Bots.Num();
+	if( NumBots == 0 )
+		return;
+
+	const double Now = GetWorld()->GetTimeSeconds();
+
+	/* Thinks of due bots, round robin from where the last frame ran out of budget */
+	const uint32 StartCycles = FPlatformTime::Cycles();
+	const uint32 BudgetCycles = uint32( ThinkBudgetMs * 0.001 / FPlatformTime::GetSecondsPerCycle() );
+
+	bool bGathered = false;
+	int32 NumThinks = 0;
+	int32 NumVisited = 0;
+
+	for( ; NumVisited < NumBots; ++NumVisited )
+	{
+		if( NumThinks > 0 && FPlatformTime::Cycles() - StartCycles >= BudgetCycles )
+		{
+			++m_NumBudgetFrames;
+			break;
+		}
+
+		AHumanBotController * Bot = m_Bots[ ( m_ThinkCursor + NumVisited ) % NumBots ].Get();
+		if( !Bot || Bot->GetNextThinkTime() > Now )
+			continue;
+
+		if( !bGathered )
+		{
+			GatherTargets();
+			bGathered = true;
+		}
+
+		/* Fresh bots have no think time yet */
+		if( Bot->GetNextThinkTime() > 0.0 )
+			m_MaxThinkDelay = FMath::Max( m_MaxThinkDelay, float( Now - Bot->GetNextThinkTime() ) );
+
+		Bot->SetNextThinkTime( Now + ThinkInterval );
+		Bot->Think( Now, m_Targets );
+		++NumThinks;
+	}
+
+	m_ThinkCursor = ( m_ThinkCursor + NumVisited ) % NumBots;
+
+	const float ThinkMs = FPlatformTime::ToMilliseconds( FPlatformTime::Cycles() - StartCycles );
+	m_ThinkCycles += FPlatformTime::Cycles() - StartCycles;
+	m_MaxThinkMs = FMath::Max( m_MaxThinkMs, ThinkMs );
+	m_NumThinks += NumThinks;
+	++m_NumFrames;
+
+	/* Execution is cheap and every bot does it every frame, so actions play smoothly between thinks */
+	for( const TWeakObjectPtr<AHumanBotController> & Bot : m_Bots )
+	{
+		if( Bot.IsValid() )
+			Bot->Execute( Now, DeltaTime );
+	}
+}
+
+void AHumanBotManager::LogStats()
+{
+	TArray<int32> NumPerAction;
+	NumPerAction.SetNumZeroed( int32( EBotAction::Count ) );
+
+	for( const TWeakObjectPtr<AHumanBotController> & Bot : m_Bots )
+	{
+		if( Bot.IsValid() )
+			++NumPerAction[ int32( Bot->GetAction() ) ];
+	}
+
+	FString Actions;
+	for( int32 i = 0; i < NumPerAction.Num(); ++i )
+		Actions += FString::Printf( i > 0 ? TEXT( ", %s %d" ) : TEXT( "%s %d" ), AHumanBotController::ActionName( EBotAction( i ) ), NumPerAction[ i ] );
+
+	const int32 NumFrames = FMath::Max( m_NumFrames, 1 );
+
+	UE_LOG( LogTemp, Display, TEXT( "Bots: %d ( %s ). %d thinks in %d frames, %.1f per frame, %.3f ms per frame ( peak %.3f, budget %.2f ), budget ran out in %d frames, decisions up to %.0f ms late" ),
+			m_Bots.Num(),
+			*Actions,
+			m_NumThinks,
+			m_NumFrames,
+			float( m_NumThinks ) / NumFrames,
+			m_ThinkCycles * FPlatformTime::GetSecondsPerCycle() * 1000.0 / NumFrames,
+			m_MaxThinkMs,
+			ThinkBudgetMs,
+			m_NumBudgetFrames,
+			m_MaxThinkDelay * 1000.f );
+
+	/* Packed properties are counted where they are written, which is this server */
+	NetPacking::LogStats();
+	NetPacking::ResetStats();
+
+	m_NumFrames = 0;
+	m_NumThinks = 0;
+	m_NumBudgetFrames = 0;
+	m_ThinkCycles = 0;
+	m_MaxThinkMs = 0.f;
+	m_MaxThinkDelay = 0.f;
+}
@@ -0,0 +1,79 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "AI/HumanBotController.h"
+#include "HumanBotManager.generated.h"
+
+/**
+* Per-world server manager of bots.
+* Every frame each bot executes its current action, which is cheap: aim, movement axes, button timing.
+* Decisions are the expensive part and are time sliced: bots whose think is due are run round robin,
+* continuing where the last frame stopped, until ThinkBudgetMs is spent. Humans are gathered once per
+* frame for all of them. With many bots decisions get late instead of the frame getting long.
+* Not spawned on clients. swa.AddBots N, swa.RemoveBots N and swa.BotStats control it from the console.
+* BotStats and the end of play also log and reset the NetPacking counters, so a soak reports replication bytes.
+*/
+UCLASS( NotPlaceable, Transient, Config = Game )
+class STARWARSARENA_API AHumanBotManager : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	AHumanBotManager();
+
+	/* Returns manager of the world, spawning it on first use if bSpawnIfMissing is set. Null on clients */
+	static AHumanBotManager *			Get( UWorld * World, bool bSpawnIfMissing = true );
+
+	/* Spawns bots and lets the game mode give them pawns at player starts. Returns how many got a pawn */
+	int32								SpawnBots( int32 Count );
+
+	/* Destroys the last Count bots and their pawns */
+	void								RemoveBots( int32 Count );
+
+	void								RegisterBot( AHumanBotController * Bot );
+
+	void								UnregisterBot( AHumanBotController * Bot );
+
+	int32								GetNumBots() const											{ return m_Bots.Num(); }
+
+	virtual void						Tick( float DeltaTime ) override;
+
+	virtual void						EndPlay( const EEndPlayReason::Type EndPlayReason ) override;
+
+	/* Thinks, think time, how late decisions were and packed property bytes since the last call. Resets the window */
+	void								LogStats();
+
+protected:
+	/* Milliseconds all bots may think in one frame. One bot always thinks, so a frame is never empty */
+	UPROPERTY( Config )
+	float								ThinkBudgetMs;
+
+	/* Seconds between two thinks of a bot, unless its action ends sooner */
+	UPROPERTY( Config )
+	float								ThinkInterval;
+
+private:
+	/* Positions and states of every human, refreshed once per frame before the first think */
+	void								GatherTargets();
+
+	TArray<TWeakObjectPtr<AHumanBotController>>	m_Bots;
+
+	TArray<FBotTarget>					m_Targets;
+
+	/* Bot the next frame starts thinking with */
+	int32								m_ThinkCursor;
+
+	int32								m_NextBotNumber;
+
+	/* Stats window */
+	int32								m_NumFrames;
+	int32								m_NumThinks;
+	int32								m_NumBudgetFrames;
+	uint64								m_ThinkCycles;
+	float								m_MaxThinkMs;
+	/* Longest a due bot waited for its think, seconds */
+	float								m_MaxThinkDelay;
+};
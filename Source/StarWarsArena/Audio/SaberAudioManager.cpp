@@ -0,0 +1,188 @@
+#include "SaberAudioManager.h"
+#include "Components/AudioComponent.h"
+#include "Sound/SoundBase.h"
+#include "Engine/World.h"
+
+#include "EngineUtils.h"
+
+DECLARE_DWORD_COUNTER_STAT( TEXT( "Active voices" ), STAT_SaberAudioActiveVoices, STATGROUP_SaberAudio );
+DECLARE_DWORD_COUNTER_STAT( TEXT( "Plays" ), STAT_SaberAudioPlays, STATGROUP_SaberAudio );
+DECLARE_DWORD_COUNTER_STAT( TEXT( "Stolen voices" ), STAT_SaberAudioSteals, STATGROUP_SaberAudio );
+
+static FAutoConsoleCommandWithWorld SaberAudioStatsCommand(
+	TEXT( "swa.SaberAudioStats" ),
+	TEXT( "Logs plays, stolen voices and peak voice count of the saber audio pool." ),
+	FConsoleCommandWithWorldDelegate::CreateLambda( []( UWorld * World )
+	{
+		if( ASaberAudioManager * AudioManager = ASaberAudioManager::Get( World, false ) )
+			AudioManager->LogStats();
+	} ) );
+
+ASaberAudioManager::ASaberAudioManager() :
+	PoolSize( 24 ),
+	MaxSwingVoices( 6 ),
+	MaxClashVoices( 6 ),
+	MaxHitVoices( 4 ),
+	MaxPowerVoices( 4 ),
+	m_NumPlays( 0 ),
+	m_NumSteals( 0 ),
+	m_PeakVoices( 0 )
+{
+	bReplicates = false;
+	PrimaryActorTick.bCanEverTick = false;
+
+	RootComponent = CreateDefaultSubobject<USceneComponent>( TEXT( "Root" ) );
+}
+
+ASaberAudioManager * ASaberAudioManager::Get( UWorld * World, bool bSpawnIfMissing )
+{
+	if( !World || World->GetNetMode() == NM_DedicatedServer )
+		return nullptr;
+
+	for( TActorIterator<ASaberAudioManager> It( World ); It; ++It )
+	{
+		if( !It->IsPendingKill() )
+			return *It;
+	}
+
+	if( !bSpawnIfMissing )
+		return nullptr;
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	SpawnParams.ObjectFlags |= RF_Transient;
+
+	return World->SpawnActor<ASaberAudioManager>( SpawnParams );
+}
+
+void ASaberAudioManager::BeginPlay()
+{
+	Super::BeginPlay();
+
+	int32 SumOfLimits = 0;
+	for( int32 i = 0; i < int32( ESaberSoundCategory::ESSC_Count ); ++i )
+		SumOfLimits += FMath::Max( GetVoiceLimit( ESaberSoundCategory( i ) ), 0 );
+
+	if( PoolSize < SumOfLimits )
+		UE_LOG( LogTemp, Warning, TEXT( "%s : PoolSize %d is below the sum of voice limits %d, pool is grown to it." ), *GetName(), PoolSize, SumOfLimits );
+
+	/* The only place pool components are allocated */
+	m_Voices.SetNum( FMath::Max3( PoolSize, SumOfLimits, 1 ) );
+
+	for( FSaberVoice & Voice : m_Voices )
+	{
+		Voice.Component = NewObject<UAudioComponent>( this );
+		Voice.Component->bAutoActivate = false;
+		Voice.Component->bAutoDestroy = false;
+		Voice.Component->SetupAttachment( RootComponent );
+		Voice.Component->RegisterComponent();
+	}
+}
+
+void ASaberAudioManager::EndPlay( const EEndPlayReason::Type EndPlayReason )
+{
+	LogStats();
+
+	Super::EndPlay( EndPlayReason );
+}
+
+int32 ASaberAudioManager::GetVoiceLimit( ESaberSoundCategory Category ) const
+{
+	switch( Category )
+	{
+		case ESaberSoundCategory::ESSC_Swing :	return MaxSwingVoices;
+		case ESaberSoundCategory::ESSC_Clash :	return MaxClashVoices;
+		case ESaberSoundCategory::ESSC_Hit :	return MaxHitVoices;
+		case ESaberSoundCategory::ESSC_Power :	return MaxPowerVoices;
+		default :								return 1;
+	}
+}
+
+int32 ASaberAudioManager::FindVoice( ESaberSoundCategory Category ) const
+{
+	int32 FreeVoice = INDEX_NONE;
+	int32 OldestInCategory = INDEX_NONE;
+	int32 NumInCategory = 0;
+
+	for( int32 i = 0; i < m_Voices.Num(); ++i )
+	{
+		const FSaberVoice & Voice = m_Voices[ i ];
+
+		if( !Voice.Component->IsPlaying() )
+		{
+			if( FreeVoice == INDEX_NONE )
+				FreeVoice = i;
+
+			continue;
+		}
+
+		if( Voice.Category == Category )
+		{
+			++NumInCategory;
+
+			if( OldestInCategory == INDEX_NONE || Voice.StartTime < m_Voices[ OldestInCategory ].StartTime )
+				OldestInCategory = i;
+		}
+	}
+
+	/* Full category steals from itself, so clashes can not cut off power on/off sounds */
+	if( NumInCategory >= GetVoiceLimit( Category ) && OldestInCategory != INDEX_NONE )
+		return OldestInCategory;
+
+	/* Pool holds every category at its limit, so a category under its limit always finds a free voice */
+	return FreeVoice;
+}
+
+void ASaberAudioManager::Play( ESaberSoundCategory Category, USoundBase * Sound, const FVector & Location, USceneComponent * AttachTo, float VolumeMultiplier, float PitchMultiplier )
+{
+	if( !Sound || GetVoiceLimit( Category ) <= 0 )
+		return;
+
+	const int32 VoiceIndex = FindVoice( Category );
+	if( VoiceIndex == INDEX_NONE )
+		return;
+
+	FSaberVoice & Voice = m_Voices[ VoiceIndex ];
+	UAudioComponent * Component = Voice.Component;
+
+	if( Component->IsPlaying() )
+	{
+		Component->Stop();
+		++m_NumSteals;
+		INC_DWORD_STAT( STAT_SaberAudioSteals );
+	}
+
+	if( AttachTo )
+	{
+		Component->AttachToComponent( AttachTo, FAttachmentTransformRules::SnapToTargetNotIncludingScale );
+	}
+	else
+	{
+		Component->AttachToComponent( RootComponent, FAttachmentTransformRules::KeepWorldTransform );
+		Component->SetWorldLocation( Location );
+	}
+
+	Component->SetSound( Sound );
+	Component->SetVolumeMultiplier( VolumeMultiplier );
+	Component->SetPitchMultiplier( PitchMultiplier );
+	Component->Play();
+
+	Voice.Category = Category;
+	Voice.StartTime = GetWorld()->GetTimeSeconds();
+
+	++m_NumPlays;
+	INC_DWORD_STAT( STAT_SaberAudioPlays );
+
+	int32 NumActive = 0;
+	for( const FSaberVoice & Other : m_Voices )
+		NumActive += Other.Component->IsPlaying() ? 1 : 0;
+
+	m_PeakVoices = FMath::Max( m_PeakVoices, NumActive );
+	SET_DWORD_STAT( STAT_SaberAudioActiveVoices, NumActive );
+}
+
+void ASaberAudioManager::LogStats() const
+{
+	UE_LOG( LogTemp, Log, TEXT( "Saber audio : %d plays, %d stolen voices, peak %d of %d pooled voices, %d audio components allocated." ),
+			m_NumPlays, m_NumSteals, m_PeakVoices, m_Voices.Num(), m_Voices.Num() );
+}
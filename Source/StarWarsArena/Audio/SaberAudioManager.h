@@ -0,0 +1,96 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "SaberAudioManager.generated.h"
+
+class UAudioComponent;
+class USoundBase;
+class USceneComponent;
+
+DECLARE_STATS_GROUP( TEXT( "SaberAudio" ), STATGROUP_SaberAudio, STATCAT_Advanced );
+
+UENUM( BlueprintType )
+enum class ESaberSoundCategory : uint8
+{
+	ESSC_Swing				UMETA( DisplayName = "Swing" ),
+	ESSC_Clash				UMETA( DisplayName = "Clash" ),
+	ESSC_Hit				UMETA( DisplayName = "Hit" ),
+	ESSC_Power				UMETA( DisplayName = "Power" ),   // Turning blade on and off
+	ESSC_Count				UMETA( Hidden )
+};
+
+/* One pooled voice */
+USTRUCT()
+struct FSaberVoice
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	UAudioComponent *					Component = nullptr;
+
+	ESaberSoundCategory					Category = ESaberSoundCategory::ESSC_Swing;
+
+	/* World time the voice was started, oldest voice is stolen first */
+	float								StartTime = 0.f;
+};
+
+/**
+* Per-world pool of saber one-shot voices.
+* Audio components are created once in BeginPlay and reused, every category has its own voice limit -
+* a new sound of a full category steals its oldest voice instead of stacking another one.
+* The pool is at least the sum of the limits, so a category under its limit always has a free voice.
+* Not spawned on dedicated server, Get returns null there.
+*/
+UCLASS( NotPlaceable, Transient, Config = Game )
+class STARWARSARENA_API ASaberAudioManager : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	ASaberAudioManager();
+
+	/* Returns manager of the world, spawning it on first use. Null on dedicated server */
+	static ASaberAudioManager *			Get( UWorld * World, bool bSpawnIfMissing = true );
+
+	/* Plays sound on a pooled voice. If AttachTo is set voice follows it, otherwise stays at Location */
+	void								Play( ESaberSoundCategory Category, USoundBase * Sound, const FVector & Location, USceneComponent * AttachTo = nullptr, float VolumeMultiplier = 1.f, float PitchMultiplier = 1.f );
+
+	/* Plays, steals and allocations since the manager started */
+	void								LogStats() const;
+
+protected:
+	virtual void						BeginPlay() override;
+	virtual void						EndPlay( const EEndPlayReason::Type EndPlayReason ) override;
+
+	/* Number of preallocated audio components, grown to the sum of the voice limits if smaller */
+	UPROPERTY( Config )
+	int32								PoolSize;
+
+	UPROPERTY( Config )
+	int32								MaxSwingVoices;
+
+	UPROPERTY( Config )
+	int32								MaxClashVoices;
+
+	UPROPERTY( Config )
+	int32								MaxHitVoices;
+
+	UPROPERTY( Config )
+	int32								MaxPowerVoices;
+
+private:
+	int32								GetVoiceLimit( ESaberSoundCategory Category ) const;
+
+	/* Free voice, or the oldest voice of the requested category when it is full. INDEX_NONE only if the pool is empty */
+	int32								FindVoice( ESaberSoundCategory Category ) const;
+
+	UPROPERTY()
+	TArray<FSaberVoice>					m_Voices;
+
+	int32								m_NumPlays;
+	int32								m_NumSteals;
+	int32								m_PeakVoices;
+};
@@ -0,0 +1,156 @@
+#include "BladeClash.h"
+
+namespace
+{
+	/* Structure of arrays for one pass of the kernel. Lane i holds pair i of the batch */
+	MS_ALIGN( 16 ) struct FBladeClashLanes
+	{
+		float							P1X[ BladeClash::Lanes ], P1Y[ BladeClash::Lanes ], P1Z[ BladeClash::Lanes ];
+		float							Q1X[ BladeClash::Lanes ], Q1Y[ BladeClash::Lanes ], Q1Z[ BladeClash::Lanes ];
+		float							P2X[ BladeClash::Lanes ], P2Y[ BladeClash::Lanes ], P2Z[ BladeClash::Lanes ];
+		float							Q2X[ BladeClash::Lanes ], Q2Y[ BladeClash::Lanes ], Q2Z[ BladeClash::Lanes ];
+		float							RadiusSum[ BladeClash::Lanes ];
+
+		/* Output */
+		float							S[ BladeClash::Lanes ];
+		float							T[ BladeClash::Lanes ];
+		float							DistSquared[ BladeClash::Lanes ];
+	} GCC_ALIGN( 16 );
+
+	FORCEINLINE VectorRegister Clamp01( const VectorRegister & Value )
+	{
+		return VectorMin( VectorMax( Value, VectorZero() ), VectorOne() );
+	}
+
+	FORCEINLINE VectorRegister Dot3( const VectorRegister & AX, const VectorRegister & AY, const VectorRegister & AZ,
+									 const VectorRegister & BX, const VectorRegister & BY, const VectorRegister & BZ )
+	{
+		return VectorMultiplyAdd( AZ, BZ, VectorMultiplyAdd( AY, BY, VectorMultiply( AX, BX ) ) );
+	}
+
+	/**
+	* Closest points between segments P1Q1 and P2Q2 for all lanes ( Ericson, Real-Time Collision Detection 5.1.9 ).
+	* Branches of the scalar version are replaced with selects.
+	* Returns mask of lanes where capsules touch.
+	*/
+	int32 RunLanes( FBladeClashLanes & L )
+	{
+		const VectorRegister Epsilon = VectorSetFloat1( KINDA_SMALL_NUMBER );
+
+		const VectorRegister P1X = VectorLoadAligned( L.P1X ), P1Y = VectorLoadAligned( L.P1Y ), P1Z = VectorLoadAligned( L.P1Z );
+		const VectorRegister P2X = VectorLoadAligned( L.P2X ), P2Y = VectorLoadAligned( L.P2Y ), P2Z = VectorLoadAligned( L.P2Z );
+
+		const VectorRegister D1X = VectorSubtract( VectorLoadAligned( L.Q1X ), P1X );
+		const VectorRegister D1Y = VectorSubtract( VectorLoadAligned( L.Q1Y ), P1Y );
+		const VectorRegister D1Z = VectorSubtract( VectorLoadAligned( L.Q1Z ), P1Z );
+		const VectorRegister D2X = VectorSubtract( VectorLoadAligned( L.Q2X ), P2X );
+		const VectorRegister D2Y = VectorSubtract( VectorLoadAligned( L.Q2Y ), P2Y );
+		const VectorRegister D2Z = VectorSubtract( VectorLoadAligned( L.Q2Z ), P2Z );
+		const VectorRegister RX = VectorSubtract( P1X, P2X );
+		const VectorRegister RY = VectorSubtract( P1Y, P2Y );
+		const VectorRegister RZ = VectorSubtract( P1Z, P2Z );
+
+		/* Blades are never degenerate when extended, clamp lengths anyway to keep divisions finite */
+		const VectorRegister A = VectorMax( Dot3( D1X, D1Y, D1Z, D1X, D1Y, D1Z ), Epsilon );
+		const VectorRegister E = VectorMax( Dot3( D2X, D2Y, D2Z, D2X, D2Y, D2Z ), Epsilon );
+		const VectorRegister B = Dot3( D1X, D1Y, D1Z, D2X, D2Y, D2Z );
+		const VectorRegister C = Dot3( D1X, D1Y, D1Z, RX, RY, RZ );
+		const VectorRegister F = Dot3( D2X, D2Y, D2Z, RX, RY, RZ );
+
+		const VectorRegister InvA = VectorReciprocal( A );
+		const VectorRegister InvE = VectorReciprocal( E );
+
+		/* Parallel segments have zero denominator, any S works there - take 0 */
+		const VectorRegister Denom = VectorSubtract( VectorMultiply( A, E ), VectorMultiply( B, B ) );
+		const VectorRegister NotParallel = VectorCompareGT( Denom, Epsilon );
+		const VectorRegister SNumer = VectorSubtract( VectorMultiply( B, F ), VectorMultiply( C, E ) );
+		const VectorRegister SFree = Clamp01( VectorMultiply( SNumer, VectorReciprocal( VectorMax( Denom, Epsilon ) ) ) );
+		const VectorRegister S0 = VectorSelect( NotParallel, SFree, VectorZero() );
+
+		const VectorRegister T0 = VectorMultiply( VectorMultiplyAdd( B, S0, F ), InvE );
+
+		/* T outside of [0,1] - clamp it and recompute S for the clamped end */
+		const VectorRegister TBelow = VectorCompareGT( VectorZero(), T0 );
+		const VectorRegister TAbove = VectorCompareGT( T0, VectorOne() );
+		const VectorRegister SAtT0 = Clamp01( VectorMultiply( VectorNegate( C ), InvA ) );
+		const VectorRegister SAtT1 = Clamp01( VectorMultiply( VectorSubtract( B, C ), InvA ) );
+
+		const VectorRegister S = VectorSelect( TBelow, SAtT0, VectorSelect( TAbove, SAtT1, S0 ) );
+		const VectorRegister T = Clamp01( T0 );
+
+		const VectorRegister DiffX = VectorSubtract( VectorMultiplyAdd( D1X, S, P1X ), VectorMultiplyAdd( D2X, T, P2X ) );
+		const VectorRegister DiffY = VectorSubtract( VectorMultiplyAdd( D1Y, S, P1Y ), VectorMultiplyAdd( D2Y, T, P2Y ) );
+		const VectorRegister DiffZ = VectorSubtract( VectorMultiplyAdd( D1Z, S, P1Z ), VectorMultiplyAdd( D2Z, T, P2Z ) );
+		const VectorRegister DistSquared = Dot3( DiffX, DiffY, DiffZ, DiffX, DiffY, DiffZ );
+
+		const VectorRegister RadiusSum = VectorLoadAligned( L.RadiusSum );
+		const VectorRegister Touching = VectorCompareGE( VectorMultiply( RadiusSum, RadiusSum ), DistSquared );
+
+		VectorStoreAligned( S, L.S );
+		VectorStoreAligned( T, L.T );
+		VectorStoreAligned( DistSquared, L.DistSquared );
+
+		return VectorMaskBits( Touching );
+	}
+}
+
+void BladeClash::TestPairs( const TArray<FBladeCapsule> & Capsules,
+							const TArray<TPair<int32, int32>> & Pairs,
+							TArray<FBladeClashResult> & OutClashes )
+{
+	FBladeClashLanes L;
+
+	for( int32 First = 0; First < Pairs.Num(); First += Lanes )
+	{
+		const int32 Count = FMath::Min( Lanes, Pairs.Num() - First );
+
+		for( int32 Lane = 0; Lane < Lanes; ++Lane )
+		{
+			/* Tail of the last batch repeats its first pair, result of padded lanes is ignored */
+			const TPair<int32, int32> & Pair = Pairs[ First + ( Lane < Count ? Lane : 0 ) ];
+			const FBladeCapsule & CapsuleA = Capsules[ Pair.Key ];
+			const FBladeCapsule & CapsuleB = Capsules[ Pair.Value ];
+
+			L.P1X[ Lane ] = CapsuleA.Start.X;	L.P1Y[ Lane ] = CapsuleA.Start.Y;	L.P1Z[ Lane ] = CapsuleA.Start.Z;
+			L.Q1X[ Lane ] = CapsuleA.End.X;		L.Q1Y[ Lane ] = CapsuleA.End.Y;		L.Q1Z[ Lane ] = CapsuleA.End.Z;
+			L.P2X[ Lane ] = CapsuleB.Start.X;	L.P2Y[ Lane ] = CapsuleB.Start.Y;	L.P2Z[ Lane ] = CapsuleB.Start.Z;
+			L.Q2X[ Lane ] = CapsuleB.End.X;		L.Q2Y[ Lane ] = CapsuleB.End.Y;		L.Q2Z[ Lane ] = CapsuleB.End.Z;
+			L.RadiusSum[ Lane ] = CapsuleA.Radius + CapsuleB.Radius;
+		}
+
+		const int32 TouchingMask = RunLanes( L ) & ( ( 1 << Count ) - 1 );
+		if( !TouchingMask )
+			continue;
+
+		/* Contacts are rare, build them per lane */
+		for( int32 Lane = 0; Lane < Count; ++Lane )
+		{
+			if( !( TouchingMask & ( 1 << Lane ) ) )
+				continue;
+
+			const TPair<int32, int32> & Pair = Pairs[ First + Lane ];
+			const FBladeCapsule & CapsuleA = Capsules[ Pair.Key ];
+			const FBladeCapsule & CapsuleB = Capsules[ Pair.Value ];
+
+			const float S = L.S[ Lane ];
+			const float T = L.T[ Lane ];
+			const FVector ClosestA = FMath::Lerp( CapsuleA.Start, CapsuleA.End, S );
+			const FVector ClosestB = FMath::Lerp( CapsuleB.Start, CapsuleB.End, T );
+			const float Distance = FMath::Sqrt( L.DistSquared[ Lane ] );
+
+			FBladeClashResult & Clash = OutClashes[ OutClashes.AddDefaulted() ];
+			Clash.IndexA = Pair.Key;
+			Clash.IndexB = Pair.Value;
+
+			/* Crossing axes have no separation direction, fall back to the axes' cross product */
+			Clash.Normal = Distance > KINDA_SMALL_NUMBER
+				? ( ClosestA - ClosestB ) / Distance
+				: FVector::CrossProduct( CapsuleA.End - CapsuleA.Start, CapsuleB.End - CapsuleB.Start ).GetSafeNormal();
+
+			Clash.Penetration = CapsuleA.Radius + CapsuleB.Radius - Distance;
+			Clash.ContactPoint = ClosestB + Clash.Normal * ( CapsuleB.Radius - Clash.Penetration * 0.5f );
+			Clash.RelativeVelocity = FMath::Lerp( CapsuleA.StartVelocity, CapsuleA.EndVelocity, S )
+								   - FMath::Lerp( CapsuleB.StartVelocity, CapsuleB.EndVelocity, T );
+		}
+	}
+}
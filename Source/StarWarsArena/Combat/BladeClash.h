@@ -0,0 +1,49 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/* Blade modeled as a capsule: segment from hilt to tip plus radius */
+struct FBladeCapsule
+{
+	FVector								Start = FVector::ZeroVector;
+	FVector								End = FVector::ZeroVector;
+	float								Radius = 0.f;
+
+	/* Linear velocity of segment end points, blade velocity at any point is interpolated between them */
+	FVector								StartVelocity = FVector::ZeroVector;
+	FVector								EndVelocity = FVector::ZeroVector;
+};
+
+/* Contact between two blade capsules */
+struct FBladeClashResult
+{
+	int32								IndexA = INDEX_NONE;
+	int32								IndexB = INDEX_NONE;
+
+	/* Point between both blade surfaces */
+	FVector								ContactPoint = FVector::ZeroVector;
+	/* Points from blade B to blade A */
+	FVector								Normal = FVector::UpVector;
+	/* Velocity of blade A relative to blade B at contact point */
+	FVector								RelativeVelocity = FVector::ZeroVector;
+	float								Penetration = 0.f;
+};
+
+namespace BladeClash
+{
+	/* Number of pairs tested by one pass of the kernel */
+	static const int32					Lanes = 4;
+
+	/**
+	* Tests capsule pairs for contact. Closest points between segments are computed
+	* for four pairs at once with VectorRegister math, contact data is built only for touching pairs.
+	* @param Capsules - all blades of the frame
+	* @param Pairs - indices into Capsules to test
+	* @param OutClashes - a result is appended for every touching pair
+	*/
+	STARWARSARENA_API void				TestPairs( const TArray<FBladeCapsule> & Capsules,
+												   const TArray<TPair<int32, int32>> & Pairs,
+												   TArray<FBladeClashResult> & OutClashes );
+}
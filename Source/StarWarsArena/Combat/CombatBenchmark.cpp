@@ -0,0 +1,206 @@
+#include "CoreMinimal.h"
+#include "HAL/IConsoleManager.h"
+#include "Containers/Ticker.h"
+#include "CombatManager.h"
+#include "Human.h"
+#include "AI/HumanBotManager.h"
+#include "Engine/World.h"
+
+#include "EngineUtils.h"
+
+#if !UE_BUILD_SHIPPING
+
+namespace CombatBenchmark
+{
+	/* Frames for bots to spread out and blades to ignite after more humans joined */
+	static const int32					WarmupFrames = 90;
+	static const int32					MeasureFrames = 150;
+	static const int32					MaxHumans = 64;
+
+	/**
+	* Fills the world up to 2, 4 .. 64 humans with bots holding ignited sabers and times what the combat manager
+	* really does every frame: target hash update, gathering blade queries and running their scene sweeps.
+	* Every step is measured with the broadphase on and with every blade testing pawns, as without it.
+	* Runs over many frames, so it is driven by the core ticker. Bots it spawned are removed at the end.
+	*/
+	class FBroadphaseRun
+	{
+	public:
+		explicit FBroadphaseRun( UWorld * World ) :
+			m_World( World )
+		{
+			UE_LOG( LogTemp, Display, TEXT( "Combat broadphase benchmark, %d frames per measurement" ), MeasureFrames );
+			UE_LOG( LogTemp, Display, TEXT( "Humans | blades | broadphase ms/frame | pawn queries | no broadphase ms/frame | pawn queries" ) );
+
+			StartStep();
+		}
+
+		/* False once done or the world is gone */
+		bool Tick()
+		{
+			UWorld * World = m_World.Get();
+			ACombatManager * CombatManager = World ? ACombatManager::Get( World, false ) : nullptr;
+			if( !CombatManager )
+			{
+				UE_LOG( LogTemp, Warning, TEXT( "Combat broadphase benchmark : world or combat manager is gone, stopped." ) );
+				return false;
+			}
+
+			if( ++m_Frame < ( m_Phase == EPhase::Warmup ? WarmupFrames : MeasureFrames ) )
+				return true;
+
+			m_Frame = 0;
+
+			switch( m_Phase )
+			{
+				case EPhase::Warmup :
+				{
+					/* Bots may have put their blades away meanwhile */
+					IgniteSabers();
+					CombatManager->ResetQueryStats();
+					m_Phase = EPhase::Broadphase;
+					break;
+				}
+
+				case EPhase::Broadphase :
+				{
+					m_BroadphaseStats = CombatManager->GetQueryStats();
+					CombatManager->SetBroadphaseEnabled( false );
+					CombatManager->ResetQueryStats();
+					m_Phase = EPhase::NoBroadphase;
+					break;
+				}
+
+				case EPhase::NoBroadphase :
+				{
+					const FBladeQueryStats & Stats = CombatManager->GetQueryStats();
+					CombatManager->SetBroadphaseEnabled( true );
+
+					UE_LOG( LogTemp, Display, TEXT( "%6d | %6.1f | %19.4f | %12.1f | %22.4f | %12.1f" ),
+							m_NumHumans,
+							PerFrame( m_BroadphaseStats.NumQueries, m_BroadphaseStats ),
+							MsPerFrame( m_BroadphaseStats ),
+							PerFrame( m_BroadphaseStats.NumHumanQueries, m_BroadphaseStats ),
+							MsPerFrame( Stats ),
+							PerFrame( Stats.NumHumanQueries, Stats ) );
+
+					m_NumHumans *= 2;
+					if( m_NumHumans > MaxHumans )
+					{
+						Finish();
+						return false;
+					}
+
+					StartStep();
+					break;
+				}
+			}
+
+			return true;
+		}
+
+	private:
+		enum class EPhase : uint8
+		{
+			Warmup,
+			Broadphase,
+			NoBroadphase
+		};
+
+		static double MsPerFrame( const FBladeQueryStats & Stats )
+		{
+			return Stats.NumFrames > 0 ? Stats.Cycles * FPlatformTime::GetSecondsPerCycle() * 1000.0 / Stats.NumFrames : 0.0;
+		}
+
+		static float PerFrame( int32 Count, const FBladeQueryStats & Stats )
+		{
+			return Stats.NumFrames > 0 ? float( Count ) / Stats.NumFrames : 0.f;
+		}
+
+		int32 CountHumans() const
+		{
+			int32 NumHumans = 0;
+			for( TActorIterator<AHuman> It( m_World.Get() ); It; ++It )
+				NumHumans += It->IsPendingKill() ? 0 : 1;
+
+			return NumHumans;
+		}
+
+		void IgniteSabers()
+		{
+			for( TActorIterator<AHuman> It( m_World.Get() ); It; ++It )
+			{
+				if( !It->IsPendingKill() && !It->IsInCombat() )
+					It->ToggleCombat();
+			}
+		}
+
+		void StartStep()
+		{
+			const int32 Missing = m_NumHumans - CountHumans();
+			if( Missing > 0 )
+			{
+				if( AHumanBotManager * BotManager = AHumanBotManager::Get( m_World.Get() ) )
+					m_NumSpawned += BotManager->SpawnBots( Missing );
+			}
+
+			IgniteSabers();
+
+			m_Phase = EPhase::Warmup;
+			m_Frame = 0;
+		}
+
+		void Finish()
+		{
+			if( AHumanBotManager * BotManager = AHumanBotManager::Get( m_World.Get(), false ) )
+				BotManager->RemoveBots( m_NumSpawned );
+
+			UE_LOG( LogTemp, Display, TEXT( "Combat broadphase benchmark : done, %d bots removed." ), m_NumSpawned );
+		}
+
+		TWeakObjectPtr<UWorld>			m_World;
+		EPhase							m_Phase = EPhase::Warmup;
+		int32							m_Frame = 0;
+		int32							m_NumHumans = 2;
+		int32							m_NumSpawned = 0;
+		FBladeQueryStats				m_BroadphaseStats;
+	};
+
+	TUniquePtr<FBroadphaseRun>			GRun;
+
+	void Run( UWorld * World )
+	{
+		if( !World || World->GetNetMode() == NM_Client )
+		{
+			UE_LOG( LogTemp, Warning, TEXT( "Combat broadphase benchmark spawns bots, run it on the server." ) );
+			return;
+		}
+
+		if( GRun )
+		{
+			UE_LOG( LogTemp, Warning, TEXT( "Combat broadphase benchmark is already running." ) );
+			return;
+		}
+
+		/* Manager is created by the first saber, an empty world has nothing to measure yet */
+		ACombatManager::Get( World );
+
+		GRun = MakeUnique<FBroadphaseRun>( World );
+
+		FTicker::GetCoreTicker().AddTicker( FTickerDelegate::CreateLambda( []( float DeltaTime )
+		{
+			if( GRun && GRun->Tick() )
+				return true;
+
+			GRun.Reset();
+			return false;
+		} ) );
+	}
+}
+
+static FAutoConsoleCommandWithWorld CombatBroadphaseBenchmarkCommand(
+	TEXT( "swa.BenchmarkBroadphase" ),
+	TEXT( "Fills the world with bots up to 2..64 humans and measures blade query cost per frame with and without the broadphase. Server only, bots fight meanwhile, use a test map." ),
+	FConsoleCommandWithWorldDelegate::CreateStatic( &CombatBenchmark::Run ) );
+
+#endif // !UE_BUILD_SHIPPING
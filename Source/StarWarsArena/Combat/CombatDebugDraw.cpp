@@ -0,0 +1,245 @@
+#include "CombatDebugDraw.h"
+#include "CombatManager.h"
+#include "DrawDebugHelpers.h"
+#include "Engine/World.h"
+#include "HAL/FileManager.h"
+#include "Misc/Paths.h"
+
+#if ENABLE_COMBAT_DEBUG
+static TAutoConsoleVariable<int32> CVarCombatDebug(
+	TEXT( "swa.CombatDebug" ),
+	0,
+	TEXT( "Combat debug visualization.\n" )
+	TEXT( " 0: off\n" )
+	TEXT( " 1: draw saber paths, blade sweeps, hits, hit windows and state labels\n" )
+	TEXT( " 2: draw and dump all primitives to Saved/Logs/CombatDebug_<World>.log ( dedicated server always dumps )" ) );
+#endif
+
+namespace
+{
+	const TCHAR * ShapeName( ECombatDebugShape Shape )
+	{
+		switch( Shape )
+		{
+			case ECombatDebugShape::Line :		return TEXT( "Line" );
+			case ECombatDebugShape::Capsule :	return TEXT( "Capsule" );
+			case ECombatDebugShape::Point :		return TEXT( "Point" );
+			case ECombatDebugShape::Label :		return TEXT( "Label" );
+		}
+
+		return TEXT( "Unknown" );
+	}
+
+	const TCHAR * CategoryName( ECombatDebugCategory Category )
+	{
+		switch( Category )
+		{
+			case ECombatDebugCategory::SaberPath :	return TEXT( "SaberPath" );
+			case ECombatDebugCategory::BladeSweep :	return TEXT( "BladeSweep" );
+			case ECombatDebugCategory::Hit :		return TEXT( "Hit" );
+			case ECombatDebugCategory::HitWindow :	return TEXT( "HitWindow" );
+			case ECombatDebugCategory::State :		return TEXT( "State" );
+		}
+
+		return TEXT( "Unknown" );
+	}
+}
+
+FCombatDebugDraw::FCombatDebugDraw( UWorld * InWorld ) :
+	m_World( InWorld )
+{
+	m_Ring.SetNum( Capacity );
+}
+
+FCombatDebugDraw::~FCombatDebugDraw()
+{
+	delete m_DumpFile;
+}
+
+FCombatDebugDraw * FCombatDebugDraw::Get( UWorld * World )
+{
+#if ENABLE_COMBAT_DEBUG
+	if( CVarCombatDebug.GetValueOnGameThread() <= 0 )
+		return nullptr;
+
+	ACombatManager * CombatManager = ACombatManager::Get( World, false );
+
+	return CombatManager ? CombatManager->GetDebugDraw() : nullptr;
+#else
+	return nullptr;
+#endif
+}
+
+FCombatDebugPrimitive & FCombatDebugDraw::Add( ECombatDebugShape Shape, ECombatDebugCategory Category, const FColor & Color, float Lifetime )
+{
+	int32 Index;
+
+	/* Full ring overwrites its oldest primitive */
+	if( m_Count < Capacity )
+	{
+		Index = ( m_Head + m_Count ) % Capacity;
+		++m_Count;
+	}
+	else
+	{
+		Index = m_Head;
+		m_Head = ( m_Head + 1 ) % Capacity;
+	}
+
+	FCombatDebugPrimitive & Primitive = m_Ring[ Index ];
+	Primitive.Shape = Shape;
+	Primitive.Category = Category;
+	Primitive.Color = Color;
+	Primitive.Radius = 0.f;
+	Primitive.Label.Reset();
+	Primitive.Time = m_World ? m_World->GetTimeSeconds() : 0.f;
+	Primitive.Lifetime = Lifetime;
+	Primitive.Sequence = ++m_NextSequence;
+	Primitive.bDump = true;
+
+	return Primitive;
+}
+
+void FCombatDebugDraw::AddLine( ECombatDebugCategory Category, const FVector & Start, const FVector & End, const FColor & Color, float Lifetime )
+{
+	FCombatDebugPrimitive & Primitive = Add( ECombatDebugShape::Line, Category, Color, Lifetime );
+	Primitive.A = Start;
+	Primitive.B = End;
+}
+
+void FCombatDebugDraw::AddCapsule( ECombatDebugCategory Category, const FVector & Start, const FVector & End, float Radius, const FColor & Color, float Lifetime )
+{
+	FCombatDebugPrimitive & Primitive = Add( ECombatDebugShape::Capsule, Category, Color, Lifetime );
+	Primitive.A = Start;
+	Primitive.B = End;
+	Primitive.Radius = Radius;
+}
+
+void FCombatDebugDraw::AddPoint( ECombatDebugCategory Category, const FVector & Location, const FColor & Color, float Lifetime )
+{
+	FCombatDebugPrimitive & Primitive = Add( ECombatDebugShape::Point, Category, Color, Lifetime );
+	Primitive.A = Location;
+}
+
+void FCombatDebugDraw::AddLabel( ECombatDebugCategory Category, const FVector & Location, const FString & Text, const FColor & Color, float Lifetime, bool bDump )
+{
+	FCombatDebugPrimitive & Primitive = Add( ECombatDebugShape::Label, Category, Color, Lifetime );
+	Primitive.A = Location;
+	Primitive.Label = Text;
+	Primitive.bDump = bDump;
+}
+
+SIZE_T FCombatDebugDraw::GetAllocatedSize() const
+{
+	SIZE_T Size = m_Ring.GetAllocatedSize();
+
+	for( const FCombatDebugPrimitive & Primitive : m_Ring )
+		Size += Primitive.Label.GetAllocatedSize();
+
+	return Size;
+}
+
+bool FCombatDebugDraw::IsDrawing() const
+{
+	return m_World && m_World->GetNetMode() != NM_DedicatedServer;
+}
+
+void FCombatDebugDraw::Flush()
+{
+	if( !m_World )
+		return;
+
+#if ENABLE_COMBAT_DEBUG
+	const bool bDraw = IsDrawing();
+	const bool bDump = !bDraw || CVarCombatDebug.GetValueOnGameThread() >= 2;
+#else
+	const bool bDraw = false;
+	const bool bDump = false;
+#endif
+
+	const float Now = m_World->GetTimeSeconds();
+
+	for( int32 i = 0; i < m_Count; ++i )
+	{
+		const FCombatDebugPrimitive & Primitive = m_Ring[ ( m_Head + i ) % Capacity ];
+		const bool bNew = Primitive.Sequence > m_FlushedSequence;
+
+		if( bDump && bNew && Primitive.bDump )
+			Dump( Primitive );
+
+		/* Every primitive is drawn at least once, expired ones wait behind longer living ones without being drawn */
+		if( bDraw && ( bNew || Primitive.Time + Primitive.Lifetime > Now ) )
+			Draw( Primitive );
+	}
+
+	m_FlushedSequence = m_NextSequence;
+
+	/* Oldest primitives are at the head, drop them while expired */
+	while( m_Count > 0 && m_Ring[ m_Head ].Time + m_Ring[ m_Head ].Lifetime <= Now )
+	{
+		m_Head = ( m_Head + 1 ) % Capacity;
+		--m_Count;
+	}
+
+	if( m_DumpFile )
+		m_DumpFile->Flush();
+}
+
+void FCombatDebugDraw::Draw( const FCombatDebugPrimitive & Primitive ) const
+{
+	/* Negative lifetime and non persistent lines are drawn for one frame only, labels get one frame of duration */
+	switch( Primitive.Shape )
+	{
+		case ECombatDebugShape::Line :
+		{
+			DrawDebugLine( m_World, Primitive.A, Primitive.B, Primitive.Color, false, -1.f, 0, 2.f );
+			break;
+		}
+		case ECombatDebugShape::Capsule :
+		{
+			const FVector Axis = Primitive.B - Primitive.A;
+			DrawDebugCapsule( m_World, ( Primitive.A + Primitive.B ) * 0.5f, Axis.Size() * 0.5f + Primitive.Radius, Primitive.Radius,
+							  FRotationMatrix::MakeFromZ( Axis ).ToQuat(), Primitive.Color, false, -1.f );
+			break;
+		}
+		case ECombatDebugShape::Point :
+		{
+			DrawDebugPoint( m_World, Primitive.A, 8.f, Primitive.Color, false, -1.f );
+			break;
+		}
+		case ECombatDebugShape::Label :
+		{
+			/* Strings are not lines, a negative duration keeps them on the HUD forever. Flushed every frame, so one frame is enough */
+			DrawDebugString( m_World, Primitive.A, Primitive.Label, nullptr, Primitive.Color, FMath::Max( m_World->GetDeltaSeconds(), KINDA_SMALL_NUMBER ) );
+			break;
+		}
+	}
+}
+
+void FCombatDebugDraw::Dump( const FCombatDebugPrimitive & Primitive )
+{
+	if( !m_DumpFile )
+	{
+		const FString FileName = FPaths::ProjectLogDir() / FString::Printf( TEXT( "CombatDebug_%s.log" ), *m_World->GetName() );
+		m_DumpFile = IFileManager::Get().CreateFileWriter( *FileName, FILEWRITE_AllowRead );
+
+		if( !m_DumpFile )
+			return;
+
+		UE_LOG( LogTemp, Log, TEXT( "Dumping combat debug primitives to %s" ), *FileName );
+	}
+
+	const FString Line = FString::Printf( TEXT( "%.3f %s %s A=(%s) B=(%s) R=%.1f C=%s L=%.2f %s\n" ),
+										  Primitive.Time,
+										  CategoryName( Primitive.Category ),
+										  ShapeName( Primitive.Shape ),
+										  *Primitive.A.ToCompactString(),
+										  *Primitive.B.ToCompactString(),
+										  Primitive.Radius,
+										  *Primitive.Color.ToHex(),
+										  Primitive.Lifetime,
+										  *Primitive.Label );
+
+	const FTCHARToUTF8 Utf8( *Line );
+	m_DumpFile->Serialize( const_cast<ANSICHAR *>( Utf8.Get() ), Utf8.Length() );
+}
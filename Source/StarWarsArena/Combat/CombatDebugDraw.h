@@ -0,0 +1,111 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/* Combat debug drawing is compiled out of Shipping */
+#define ENABLE_COMBAT_DEBUG				!UE_BUILD_SHIPPING
+
+class UWorld;
+
+enum class ECombatDebugShape : uint8
+{
+	Line,
+	Capsule,
+	Point,
+	Label
+};
+
+enum class ECombatDebugCategory : uint8
+{
+	SaberPath,
+	BladeSweep,
+	Hit,
+	HitWindow,
+	State
+};
+
+struct FCombatDebugPrimitive
+{
+	ECombatDebugShape					Shape = ECombatDebugShape::Line;
+	ECombatDebugCategory				Category = ECombatDebugCategory::SaberPath;
+
+	/* Line and capsule ends, point and label location in A */
+	FVector								A = FVector::ZeroVector;
+	FVector								B = FVector::ZeroVector;
+	float								Radius = 0.f;
+	FColor								Color = FColor::White;
+	FString								Label;
+
+	/* World time primitive was added at and how long it lives. Zero lifetime lives one frame */
+	float								Time = 0.f;
+	float								Lifetime = 0.f;
+	uint64								Sequence = 0;
+
+	/* Per frame overlays are only drawn, never dumped */
+	bool								bDump = true;
+};
+
+/**
+* Fixed capacity ring buffer of combat debug primitives, one per world ( owned by ACombatManager ).
+* Primitives are redrawn every frame as one-frame debug lines, so nothing piles up in the line batcher.
+* When the oldest primitive is overwritten it is simply gone.
+* swa.CombatDebug 1 draws, 2 also dumps every primitive to Saved/Logs/CombatDebug_<World>.log.
+* Dedicated servers have nothing to draw to and always dump.
+*/
+class STARWARSARENA_API FCombatDebugDraw
+{
+public:
+	static const int32					Capacity = 4096;
+
+	explicit FCombatDebugDraw( UWorld * InWorld );
+	~FCombatDebugDraw();
+
+	/* Returns visualizer of the world, or null if swa.CombatDebug is off */
+	static FCombatDebugDraw *			Get( UWorld * World );
+
+	void								AddLine( ECombatDebugCategory Category, const FVector & Start, const FVector & End, const FColor & Color, float Lifetime = 0.f );
+
+	void								AddCapsule( ECombatDebugCategory Category, const FVector & Start, const FVector & End, float Radius, const FColor & Color, float Lifetime = 0.f );
+
+	void								AddPoint( ECombatDebugCategory Category, const FVector & Location, const FColor & Color, float Lifetime = 0.f );
+
+	void								AddLabel( ECombatDebugCategory Category, const FVector & Location, const FString & Text, const FColor & Color, float Lifetime = 0.f, bool bDump = true );
+
+	/* False on dedicated server, there is no viewport to draw to */
+	bool								IsDrawing() const;
+
+	/* Draws live primitives for this frame, dumps new ones and drops expired ones. Called by combat manager */
+	void								Flush();
+
+	/* Ring and label strings */
+	SIZE_T								GetAllocatedSize() const;
+
+private:
+	FCombatDebugPrimitive &				Add( ECombatDebugShape Shape, ECombatDebugCategory Category, const FColor & Color, float Lifetime );
+
+	void								Draw( const FCombatDebugPrimitive & Primitive ) const;
+
+	void								Dump( const FCombatDebugPrimitive & Primitive );
+
+	UWorld *							m_World;
+
+	TArray<FCombatDebugPrimitive>		m_Ring;
+	/* Index of the oldest primitive */
+	int32								m_Head = 0;
+	int32								m_Count = 0;
+
+	uint64								m_NextSequence = 0;
+	/* Primitives up to this one were already drawn or dumped */
+	uint64								m_FlushedSequence = 0;
+
+	FArchive *							m_DumpFile = nullptr;
+};
+
+/* Statement macro, wrapped so an if without braces around it keeps its else */
+#if ENABLE_COMBAT_DEBUG
+	#define COMBAT_DEBUG( World, Call )		do { if( FCombatDebugDraw * CombatDebug = FCombatDebugDraw::Get( World ) ) { CombatDebug->Call; } } while( 0 )
+#else
+	#define COMBAT_DEBUG( World, Call )		do { } while( 0 )
+#endif
@@ -0,0 +1,512 @@
+#include "CombatManager.h"
+#include "Objects/Saber.h"
+#include "Human.h"
+#include "Diagnostics/HitchWatchdog.h"
+#include "Diagnostics/CombatMemory.h"
+#include "Components/StaticMeshComponent.h"
+#include "Async/ParallelFor.h"
+
+#include "EngineUtils.h"
+
+static TAutoConsoleVariable<float> CVarCombatCellSize(
+	TEXT( "swa.CombatCellSize" ),
+	400.f,
+	TEXT( "Cell size of combat broadphase grid, in cm. Applied when combat manager starts." ) );
+
+/* Blade overlap to be reported to saber after the batch is merged */
+struct FBladeOverlapEvent
+{
+	TWeakObjectPtr<ASaber>				Saber;
+	TWeakObjectPtr<AActor>				OtherActor;
+	FHitResult							Hit;
+};
+
+ACombatManager::ACombatManager() :
+	m_bBroadphaseEnabled( true )
+{
+	bReplicates = false;
+
+	PrimaryActorTick.bCanEverTick = true;
+	/* Physics scene is not written after simulation, so workers query a stable scene */
+	PrimaryActorTick.TickGroup = TG_PostPhysics;
+}
+
+void ACombatManager::BeginPlay()
+{
+	Super::BeginPlay();
+
+	m_TargetHash.Reset( CVarCombatCellSize.GetValueOnGameThread() );
+	m_BladeHash.Reset( CVarCombatCellSize.GetValueOnGameThread() );
+}
+
+ACombatManager * ACombatManager::Get( UWorld * World, bool bSpawnIfMissing )
+{
+	if( !World )
+		return nullptr;
+
+	for( TActorIterator<ACombatManager> It( World ); It; ++It )
+	{
+		if( !It->IsPendingKill() )
+			return *It;
+	}
+
+	if( !bSpawnIfMissing )
+		return nullptr;
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	SpawnParams.ObjectFlags |= RF_Transient;
+
+	return World->SpawnActor<ACombatManager>( SpawnParams );
+}
+
+void ACombatManager::RegisterSaber( ASaber * Saber )
+{
+	if( !Saber )
+		return;
+
+	for( const FSaberCombatRecord & Record : m_Sabers )
+	{
+		if( Record.Saber.Get() == Saber )
+			return;
+	}
+
+	FSaberCombatRecord Record;
+	Record.Saber = Saber;
+	m_Sabers.Add( Record );
+}
+
+void ACombatManager::UnregisterSaber( ASaber * Saber )
+{
+	if( Saber )
+		m_BladeHash.Remove( Saber->GetUniqueID() );
+
+	/* RemoveAll keeps order of the rest, resolution order stays deterministic */
+	m_Sabers.RemoveAll( [ Saber ]( const FSaberCombatRecord & Record )
+	{
+		return !Record.Saber.IsValid() || Record.Saber.Get() == Saber;
+	} );
+}
+
+void ACombatManager::RegisterHuman( AHuman * Human )
+{
+	if( Human )
+		m_Targets.Add( Human->GetUniqueID(), Human );
+}
+
+void ACombatManager::UnregisterHuman( AHuman * Human )
+{
+	if( !Human )
+		return;
+
+	m_Targets.Remove( Human->GetUniqueID() );
+	m_TargetHash.Remove( Human->GetUniqueID() );
+}
+
+void ACombatManager::RegisterCombatTarget( UObject * WorldContextObject, AActor * Target )
+{
+	UWorld * World = GEngine->GetWorldFromContextObject( WorldContextObject, EGetWorldErrorMode::LogAndReturnNull );
+	ACombatManager * CombatManager = ACombatManager::Get( World );
+
+	if( CombatManager && Target )
+		CombatManager->m_Targets.Add( Target->GetUniqueID(), Target );
+}
+
+void ACombatManager::UnregisterCombatTarget( UObject * WorldContextObject, AActor * Target )
+{
+	UWorld * World = GEngine->GetWorldFromContextObject( WorldContextObject, EGetWorldErrorMode::LogAndReturnNull );
+	ACombatManager * CombatManager = ACombatManager::Get( World, false );
+
+	if( CombatManager && Target )
+	{
+		CombatManager->m_Targets.Remove( Target->GetUniqueID() );
+		CombatManager->m_TargetHash.Remove( Target->GetUniqueID() );
+	}
+}
+
+void ACombatManager::Tick( float DeltaTime )
+{
+	HITCH_TIMER( GetWorld(), EHitchTimer::CombatManager );
+	COMBAT_LLM_SCOPE( ECombatMemory::CombatManager );
+
+	Super::Tick( DeltaTime );
+
+	const uint32 StartCycles = FPlatformTime::Cycles();
+
+	UpdateTargetHash();
+	GatherBladeQueries( DeltaTime );
+	RunBladeQueries();
+
+	m_QueryStats.Cycles += FPlatformTime::Cycles() - StartCycles;
+	m_QueryStats.NumQueries += m_Queries.Num();
+	++m_QueryStats.NumFrames;
+
+	ResolveBladeQueries();
+	ResolveBladeClashes();
+
+#if ENABLE_COMBAT_DEBUG
+	DrawCombatDebug();
+
+	if( m_DebugDraw )
+		m_DebugDraw->Flush();
+#endif
+}
+
+SIZE_T ACombatManager::GetAllocatedSize() const
+{
+	SIZE_T Size = m_Sabers.GetAllocatedSize() + m_Queries.GetAllocatedSize() + m_Capsules.GetAllocatedSize() +
+				  m_ClashPairs.GetAllocatedSize() + m_Clashes.GetAllocatedSize() + m_ClashingSabers.GetAllocatedSize() +
+				  m_Targets.GetAllocatedSize() + m_BladeIdToQuery.GetAllocatedSize() + m_FoundIds.GetAllocatedSize() +
+				  m_TargetHash.GetAllocatedSize() + m_BladeHash.GetAllocatedSize();
+
+	for( const FSaberCombatRecord & Record : m_Sabers )
+		Size += Record.OverlappedActors.GetAllocatedSize();
+
+	for( const FBladeQuery & Query : m_Queries )
+		Size += Query.IgnoredActors.GetAllocatedSize() + Query.Hits.GetAllocatedSize();
+
+	return Size;
+}
+
+FCombatDebugDraw * ACombatManager::GetDebugDraw()
+{
+	if( !m_DebugDraw )
+	{
+		COMBAT_LLM_SCOPE( ECombatMemory::DebugDraw );
+		m_DebugDraw = MakeUnique<FCombatDebugDraw>( GetWorld() );
+	}
+
+	return m_DebugDraw.Get();
+}
+
+bool ACombatManager::GetBladeSweepPlane( const ASaber * Saber, FPlane & OutPlane ) const
+{
+	const int32 * QueryIndex = Saber ? m_BladeIdToQuery.Find( Saber->GetUniqueID() ) : nullptr;
+	if( !QueryIndex )
+		return false;
+
+	const FBladeCapsule & Capsule = m_Capsules[ *QueryIndex ];
+	const FVector Axis = ( Capsule.End - Capsule.Start ).GetSafeNormal();
+	const FVector Motion = ( Capsule.StartVelocity + Capsule.EndVelocity ) * 0.5f;
+
+	FVector Normal = Axis ^ Motion.GetSafeNormal();
+
+	/* Blade at rest or moving along itself, cut vertically through the blade */
+	if( Normal.SizeSquared() < KINDA_SMALL_NUMBER )
+		Normal = Axis ^ FVector::UpVector;
+	if( Normal.SizeSquared() < KINDA_SMALL_NUMBER )
+		Normal = Axis ^ FVector::ForwardVector;
+
+	OutPlane = FPlane( ( Capsule.Start + Capsule.End ) * 0.5f, Normal.GetSafeNormal() );
+	return true;
+}
+
+void ACombatManager::DrawCombatDebug()
+{
+	FCombatDebugDraw * DebugDraw = FCombatDebugDraw::Get( GetWorld() );
+	if( !DebugDraw )
+		return;
+
+	/* Red while the owner attacks, grey when broadphase found no human near the blade */
+	for( int32 i = 0; i < m_Capsules.Num(); ++i )
+	{
+		const ASaber * Saber = m_Queries[ i ].Saber.Get();
+		const bool bAttacking = Saber && Saber->m_pHuman && Saber->m_pHuman->GetState() == EHumanState::EHS_Attacking;
+
+		DebugDraw->AddCapsule( ECombatDebugCategory::BladeSweep, m_Capsules[ i ].Start, m_Capsules[ i ].End, m_Capsules[ i ].Radius,
+							   bAttacking ? FColor::Red : ( m_Queries[ i ].bQueryHumans ? FColor::Cyan : FColor::Silver ) );
+	}
+
+	/* Overhead labels are per frame overlays, state changes are dumped by AHuman */
+	if( !DebugDraw->IsDrawing() )
+		return;
+
+	static const UEnum * StateEnum = FindObject<UEnum>( ANY_PACKAGE, TEXT( "EHumanState" ) );
+
+	for( const auto & Target : m_Targets )
+	{
+		AHuman * Human = Cast<AHuman>( Target.Value.Get() );
+		if( !Human )
+			continue;
+
+		const FHumanStats Stats = Human->GetCurrentStats();
+		const FString Label = FString::Printf( TEXT( "%s\nH %d  S %d" ),
+											   StateEnum ? *StateEnum->GetDisplayNameTextByValue( int64( Human->GetState() ) ).ToString() : TEXT( "?" ),
+											   Stats.HS_Health,
+											   Stats.HS_Stamina );
+
+		DebugDraw->AddLabel( ECombatDebugCategory::State, Human->GetActorLocation() + FVector( 0.f, 0.f, 110.f ), Label, FColor::White, 0.f, false );
+	}
+}
+
+void ACombatManager::UpdateTargetHash()
+{
+	for( auto It = m_Targets.CreateIterator(); It; ++It )
+	{
+		AActor * Target = It.Value().Get();
+		if( !Target )
+		{
+			m_TargetHash.Remove( It.Key() );
+			It.RemoveCurrent();
+			continue;
+		}
+
+		/* Character bounds are capsule plus mesh, cheaper than walking all components */
+		if( AHuman * Human = Cast<AHuman>( Target ) )
+			m_TargetHash.Update( It.Key(), Human->GetRootComponent()->Bounds.GetBox() + Human->GetMesh()->Bounds.GetBox() );
+		else
+			m_TargetHash.Update( It.Key(), Target->GetComponentsBoundingBox() );
+	}
+}
+
+void ACombatManager::GatherBladeQueries( float DeltaTime )
+{
+	m_Queries.Reset();
+	m_Capsules.Reset();
+	m_BladeIdToQuery.Reset();
+
+	const float InvDeltaTime = DeltaTime > 0.f ? 1.f / DeltaTime : 0.f;
+
+	for( int32 i = 0; i < m_Sabers.Num(); ++i )
+	{
+		FSaberCombatRecord & Record = m_Sabers[ i ];
+		ASaber * Saber = Record.Saber.Get();
+
+		FVector Start, End;
+		float Radius;
+
+		if( !Saber || !Saber->GetBladeSegment( Start, End, Radius ) )
+		{
+			if( Saber )
+				m_BladeHash.Remove( Saber->GetUniqueID() );
+
+			Record.bHasPrevSegment = false;
+			Record.OverlappedActors.Reset();
+			continue;
+		}
+
+		const FVector Axis = End - Start;
+		const float HalfLength = Axis.Size() * 0.5f;
+		const FVector Center = ( Start + End ) * 0.5f;
+
+		FBladeQuery & Query = m_Queries[ m_Queries.AddDefaulted() ];
+		Query.RecordIndex = i;
+		Query.Saber = Saber;
+		Query.SweepStart = Record.bHasPrevSegment ? ( Record.PrevStart + Record.PrevEnd ) * 0.5f : Center;
+		Query.SweepEnd = Center;
+		/* Capsule is built along local Z, as is the blade mesh */
+		Query.Rotation = FRotationMatrix::MakeFromZ( Axis ).ToQuat();
+		Query.Radius = Radius;
+		Query.HalfHeight = HalfLength + Radius;
+
+		Query.IgnoredActors.Add( Saber );
+		if( Saber->GetHuman() )
+			Query.IgnoredActors.Add( Saber->GetHuman() );
+
+		FBox SweptBounds( Start, Start );
+		SweptBounds += End;
+		if( Record.bHasPrevSegment )
+		{
+			SweptBounds += Record.PrevStart;
+			SweptBounds += Record.PrevEnd;
+		}
+		Query.SweptBounds = SweptBounds.ExpandBy( Radius );
+
+		m_BladeHash.Update( Saber->GetUniqueID(), Query.SweptBounds );
+		m_BladeIdToQuery.Add( Saber->GetUniqueID(), m_Queries.Num() - 1 );
+
+		/* Pawns are only tested when someone else is near the blade, walls and Sliceable objects always are */
+		m_TargetHash.Query( Query.SweptBounds, m_FoundIds );
+
+		const int32 OwnerId = Saber->GetHuman() ? int32( Saber->GetHuman()->GetUniqueID() ) : INDEX_NONE;
+		Query.bQueryHumans = !m_bBroadphaseEnabled || m_FoundIds.Num() > 1 || ( m_FoundIds.Num() == 1 && m_FoundIds[ 0 ] != OwnerId );
+		m_QueryStats.NumHumanQueries += Query.bQueryHumans ? 1 : 0;
+
+		FBladeCapsule & Capsule = m_Capsules[ m_Capsules.AddDefaulted() ];
+		Capsule.Start = Start;
+		Capsule.End = End;
+		Capsule.Radius = Radius;
+		if( Record.bHasPrevSegment )
+		{
+			Capsule.StartVelocity = ( Start - Record.PrevStart ) * InvDeltaTime;
+			Capsule.EndVelocity = ( End - Record.PrevEnd ) * InvDeltaTime;
+		}
+
+		Record.PrevStart = Start;
+		Record.PrevEnd = End;
+		Record.bHasPrevSegment = true;
+	}
+}
+
+void ACombatManager::RunBladeQueries()
+{
+	UWorld * World = GetWorld();
+
+	/* Same scene query path the engine's async trace tasks use from worker threads */
+	ParallelFor( m_Queries.Num(), [ this, World ]( int32 Index )
+	{
+		FBladeQuery & Query = m_Queries[ Index ];
+
+		FCollisionQueryParams Params( FName( TEXT( "BladeQuery" ) ), false );
+		for( const AActor * IgnoredActor : Query.IgnoredActors )
+			Params.AddIgnoredActor( IgnoredActor );
+
+		/* Nobody near the blade, capsules and meshes of humans are skipped by the scene query itself */
+		FCollisionResponseParams ResponseParams;
+		if( !Query.bQueryHumans )
+			ResponseParams.CollisionResponse.SetResponse( ECC_Pawn, ECR_Ignore );
+
+		const FCollisionShape Shape = FCollisionShape::MakeCapsule( Query.Radius, Query.HalfHeight );
+
+		if( FVector::DistSquared( Query.SweepStart, Query.SweepEnd ) < KINDA_SMALL_NUMBER )
+		{
+			TArray<FOverlapResult> Overlaps;
+			World->OverlapMultiByChannel( Overlaps, Query.SweepEnd, Query.Rotation, BLADE_CHANNEL, Shape, Params, ResponseParams );
+
+			for( const FOverlapResult & Overlap : Overlaps )
+			{
+				FHitResult Hit( Overlap.GetActor(), Overlap.GetComponent(), Query.SweepEnd, FVector::ZeroVector );
+				Hit.Item = Overlap.ItemIndex;
+				Query.Hits.Add( Hit );
+			}
+		}
+		else
+		{
+			World->SweepMultiByChannel( Query.Hits, Query.SweepStart, Query.SweepEnd, Query.Rotation, BLADE_CHANNEL, Shape, Params, ResponseParams );
+		}
+
+		/* Blade against blade is handled by the clash kernel */
+		Query.Hits.RemoveAll( []( const FHitResult & Hit )
+		{
+			return Cast<ASaber>( Hit.GetActor() ) != nullptr;
+		} );
+	} );
+}
+
+void ACombatManager::ResolveBladeQueries()
+{
+	TArray<FBladeOverlapEvent> Events;
+
+	/* Queries are stored in registration order, hits are sorted by time and then by actor id */
+	for( FBladeQuery & Query : m_Queries )
+	{
+		FSaberCombatRecord & Record = m_Sabers[ Query.RecordIndex ];
+
+		Query.Hits.StableSort( []( const FHitResult & A, const FHitResult & B )
+		{
+			if( A.Time != B.Time )
+				return A.Time < B.Time;
+
+			const uint32 IdA = A.GetActor() ? A.GetActor()->GetUniqueID() : 0;
+			const uint32 IdB = B.GetActor() ? B.GetActor()->GetUniqueID() : 0;
+			return IdA < IdB;
+		} );
+
+		TArray<TWeakObjectPtr<AActor>> CurrentActors;
+
+		for( const FHitResult & Hit : Query.Hits )
+		{
+			AActor * OtherActor = Hit.GetActor();
+			if( !OtherActor || CurrentActors.Contains( OtherActor ) )
+				continue;
+
+			CurrentActors.Add( OtherActor );
+
+			if( !Record.OverlappedActors.Contains( OtherActor ) )
+			{
+				FBladeOverlapEvent Event;
+				Event.Saber = Record.Saber;
+				Event.OtherActor = OtherActor;
+				Event.Hit = Hit;
+				Events.Add( Event );
+			}
+		}
+
+		Record.OverlappedActors = MoveTemp( CurrentActors );
+	}
+
+	/* Sabers may unregister while handling overlaps, so records are not touched from here */
+	for( const FBladeOverlapEvent & Event : Events )
+	{
+		ASaber * Saber = Event.Saber.Get();
+		AActor * OtherActor = Event.OtherActor.Get();
+
+		if( !Saber || !OtherActor )
+			continue;
+
+		COMBAT_DEBUG( GetWorld(), AddPoint( ECombatDebugCategory::Hit, Event.Hit.ImpactPoint, FColor::Orange, 2.f ) );
+
+		Saber->BladeOverlap( Saber->Blade, OtherActor, Event.Hit.GetComponent(), Event.Hit.Item, true, Event.Hit );
+	}
+}
+
+void ACombatManager::ResolveBladeClashes()
+{
+	m_ClashPairs.Reset();
+	m_Clashes.Reset();
+
+	/* Only blades sharing cells are tested, pair ( i, j ) is added by the lower index */
+	for( int32 i = 0; i < m_Queries.Num(); ++i )
+	{
+		const ASaber * SaberA = m_Queries[ i ].Saber.Get();
+		if( !SaberA )
+			continue;
+
+		m_BladeHash.Query( m_Queries[ i ].SweptBounds, m_FoundIds );
+
+		for( int32 FoundId : m_FoundIds )
+		{
+			const int32 * j = m_BladeIdToQuery.Find( FoundId );
+			if( !j || *j <= i )
+				continue;
+
+			const ASaber * SaberB = m_Queries[ *j ].Saber.Get();
+			if( SaberB && SaberA->m_pHuman != SaberB->m_pHuman )
+				m_ClashPairs.Emplace( i, *j );
+		}
+	}
+
+	/* Found ids are sorted by saber id, keep pairs in capsule order */
+	m_ClashPairs.Sort( []( const TPair<int32, int32> & A, const TPair<int32, int32> & B )
+	{
+		return A.Key != B.Key ? A.Key < B.Key : A.Value < B.Value;
+	} );
+
+	BladeClash::TestPairs( m_Capsules, m_ClashPairs, m_Clashes );
+
+	TArray<TPair<TWeakObjectPtr<ASaber>, TWeakObjectPtr<ASaber>>> CurrentClashes;
+	TArray<FBladeClashResult> NewClashes;
+
+	for( const FBladeClashResult & Clash : m_Clashes )
+	{
+		TPair<TWeakObjectPtr<ASaber>, TWeakObjectPtr<ASaber>> SaberPair( m_Queries[ Clash.IndexA ].Saber, m_Queries[ Clash.IndexB ].Saber );
+
+		CurrentClashes.Add( SaberPair );
+
+		if( !m_ClashingSabers.Contains( SaberPair ) )
+			NewClashes.Add( Clash );
+	}
+
+	/* Pairs are ordered by capsule index, which follows registration order.
+	Overlap handlers may have unregistered sabers already, so only weak pointers of the queries are used */
+	for( const FBladeClashResult & Clash : NewClashes )
+	{
+		ASaber * SaberA = m_Queries[ Clash.IndexA ].Saber.Get();
+		ASaber * SaberB = m_Queries[ Clash.IndexB ].Saber.Get();
+
+		if( !SaberA || !SaberB )
+			continue;
+
+		COMBAT_DEBUG( GetWorld(), AddPoint( ECombatDebugCategory::Hit, Clash.ContactPoint, FColor::Magenta, 2.f ) );
+		COMBAT_DEBUG( GetWorld(), AddLine( ECombatDebugCategory::Hit, Clash.ContactPoint, Clash.ContactPoint + Clash.Normal * 20.f, FColor::Magenta, 2.f ) );
+
+		FBladeClashResult Mirrored = Clash;
+		Mirrored.Normal = -Clash.Normal;
+		Mirrored.RelativeVelocity = -Clash.RelativeVelocity;
+
+		SaberA->BladeClash( SaberB, Clash, true );
+		SaberB->BladeClash( SaberA, Mirrored, false );
+	}
+
+	m_ClashingSabers = MoveTemp( CurrentClashes );
+}
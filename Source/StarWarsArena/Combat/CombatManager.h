@@ -0,0 +1,170 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "BladeClash.h"
+#include "CombatSpatialHash.h"
+#include "CombatDebugDraw.h"
+#include "CombatManager.generated.h"
+
+class ASaber;
+class AHuman;
+class UPrimitiveComponent;
+
+/* Combat state of one registered saber, kept between frames */
+struct FSaberCombatRecord
+{
+	TWeakObjectPtr<ASaber>						Saber;
+
+	/* Blade segment from the previous frame, used to build the sweep */
+	FVector										PrevStart = FVector::ZeroVector;
+	FVector										PrevEnd = FVector::ZeroVector;
+	bool										bHasPrevSegment = false;
+
+	/* Actors the blade is currently touching. Only new ones are reported as overlaps */
+	TArray<TWeakObjectPtr<AActor>>				OverlappedActors;
+};
+
+/* One blade hit query of the frame batch. Filled on game thread, executed on a worker */
+struct FBladeQuery
+{
+	int32										RecordIndex = INDEX_NONE;
+	TWeakObjectPtr<ASaber>						Saber;
+
+	/* False when broadphase found no other human or target near the blade. Query then ignores pawns,
+	walls and Sliceable objects are always found by the scene query */
+	bool										bQueryHumans = true;
+	/* Blade volume of the frame, from previous to current segment */
+	FBox										SweptBounds;
+
+	FVector										SweepStart = FVector::ZeroVector;
+	FVector										SweepEnd = FVector::ZeroVector;
+	FQuat										Rotation = FQuat::Identity;
+	float										Radius = 0.f;
+	float										HalfHeight = 0.f;
+
+	TArray<const AActor *>						IgnoredActors;
+
+	/* Output of the worker */
+	TArray<FHitResult>							Hits;
+};
+
+/* Cost of building and running blade queries, what the broadphase is there to cut */
+struct FBladeQueryStats
+{
+	uint64								Cycles = 0;
+	int32								NumFrames = 0;
+	int32								NumQueries = 0;
+	/* Queries that had to test pawns */
+	int32								NumHumanQueries = 0;
+};
+
+/**
+* Per-world manager of saber combat collision.
+* Sabers register themselves in BeginPlay. Every frame the blade hit queries of all
+* active sabers are collected, executed as one parallel batch on task graph workers
+* and merged back on game thread in registration order, so AHuman resolution does not
+* depend on which worker finished first.
+* Manager is not replicated - every machine runs its own, same as overlap events did before.
+*/
+UCLASS( NotPlaceable, Transient )
+class STARWARSARENA_API ACombatManager : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	ACombatManager();
+
+	/* Returns manager of the world, spawning it on first use if bSpawnIfMissing is set */
+	static ACombatManager *				Get( UWorld * World, bool bSpawnIfMissing = true );
+
+	void								RegisterSaber( ASaber * Saber );
+
+	void								UnregisterSaber( ASaber * Saber );
+
+	void								RegisterHuman( AHuman * Human );
+
+	void								UnregisterHuman( AHuman * Human );
+
+	/* Registers non character actor blades should hit, like Sliceable objects.
+	Blades only test pawns when a human or target is in nearby cells, the rest of the scene is always queried */
+	UFUNCTION( BlueprintCallable, Category = "Combat", Meta = ( DisplayName = "RegisterCombatTarget", WorldContext = "WorldContextObject" ) )
+	static void							RegisterCombatTarget( UObject * WorldContextObject, AActor * Target );
+
+	UFUNCTION( BlueprintCallable, Category = "Combat", Meta = ( DisplayName = "UnregisterCombatTarget", WorldContext = "WorldContextObject" ) )
+	static void							UnregisterCombatTarget( UObject * WorldContextObject, AActor * Target );
+
+	virtual void						Tick( float DeltaTime ) override;
+
+	/* Plane through the blade containing its motion of this frame, the cut a swing makes. False if the blade is not extended */
+	bool								GetBladeSweepPlane( const ASaber * Saber, FPlane & OutPlane ) const;
+
+	/* Debug visualizer of the world, created on first use. Gameplay code goes through COMBAT_DEBUG instead */
+	FCombatDebugDraw *					GetDebugDraw();
+
+	/* Heap memory of queries, records and hashes, without the debug draw */
+	SIZE_T								GetAllocatedSize() const;
+
+	SIZE_T								GetDebugDrawAllocatedSize() const						{ return m_DebugDraw ? m_DebugDraw->GetAllocatedSize() : 0; }
+
+	/* Gather and run of blade queries since the last reset, swa.BenchmarkBroadphase reads it */
+	const FBladeQueryStats &			GetQueryStats() const									{ return m_QueryStats; }
+
+	void								ResetQueryStats()										{ m_QueryStats = FBladeQueryStats(); }
+
+	/* Off makes every blade query test pawns, as without the target hash. For measuring only */
+	void								SetBroadphaseEnabled( bool bEnabled )					{ m_bBroadphaseEnabled = bEnabled; }
+
+protected:
+	virtual void						BeginPlay() override;
+
+private:
+	/* Moves humans and targets in the target hash. Entries only change cells when they cross a cell border */
+	void								UpdateTargetHash();
+
+	/* Builds one query and one clash capsule per saber with an extended blade */
+	void								GatherBladeQueries( float DeltaTime );
+
+	/* Runs all queries of the frame on task graph workers */
+	void								RunBladeQueries();
+
+	/* Game thread pass: reports new overlaps to sabers in deterministic order */
+	void								ResolveBladeQueries();
+
+	/* Tests blade capsules of different humans against each other and reports new clashes */
+	void								ResolveBladeClashes();
+
+	/* Blade sweeps of the frame and state labels over humans */
+	void								DrawCombatDebug();
+
+	TArray<FSaberCombatRecord>			m_Sabers;
+
+	TArray<FBladeQuery>					m_Queries;
+
+	/* Capsule i belongs to m_Queries[ i ] */
+	TArray<FBladeCapsule>				m_Capsules;
+	TArray<TPair<int32, int32>>			m_ClashPairs;
+	TArray<FBladeClashResult>			m_Clashes;
+
+	/* Saber pairs clashing last frame. Clash is reported once, when blades start touching */
+	TArray<TPair<TWeakObjectPtr<ASaber>, TWeakObjectPtr<ASaber>>>	m_ClashingSabers;
+
+	/* Humans and combat targets, keyed by actor unique id */
+	TMap<int32, TWeakObjectPtr<AActor>>	m_Targets;
+	FCombatSpatialHash					m_TargetHash;
+
+	/* Extended blades, keyed by saber unique id */
+	FCombatSpatialHash					m_BladeHash;
+	TMap<int32, int32>					m_BladeIdToQuery;
+
+	/* Scratch array for hash queries */
+	TArray<int32>						m_FoundIds;
+
+	TUniquePtr<FCombatDebugDraw>		m_DebugDraw;
+
+	FBladeQueryStats					m_QueryStats;
+
+	bool								m_bBroadphaseEnabled;
+};
@@ -0,0 +1,238 @@
+#include "CombatSignificance.h"
+#include "Human.h"
+#include "Objects/Saber.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "GameFramework/PlayerController.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Engine/World.h"
+
+#include "EngineUtils.h"
+
+DECLARE_DWORD_COUNTER_STAT( TEXT( "Focus humans" ), STAT_SignificanceFocus, STATGROUP_CombatSignificance );
+DECLARE_DWORD_COUNTER_STAT( TEXT( "Near humans" ), STAT_SignificanceNear, STATGROUP_CombatSignificance );
+DECLARE_DWORD_COUNTER_STAT( TEXT( "Far humans" ), STAT_SignificanceFar, STATGROUP_CombatSignificance );
+DECLARE_DWORD_COUNTER_STAT( TEXT( "Hidden humans" ), STAT_SignificanceHidden, STATGROUP_CombatSignificance );
+
+static TAutoConsoleVariable<int32> CVarCombatSignificance(
+	TEXT( "swa.CombatSignificance" ),
+	1,
+	TEXT( "Significance based tick and animation budgeting of humans and sabers.\n" )
+	TEXT( " 0: everyone at full fidelity\n" )
+	TEXT( " 1: tiers by focus, distance and visibility" ) );
+
+static FAutoConsoleCommandWithWorld CombatSignificanceStatsCommand(
+	TEXT( "swa.CombatSignificanceStats" ),
+	TEXT( "Logs number of humans in every significance tier." ),
+	FConsoleCommandWithWorldDelegate::CreateLambda( []( UWorld * World )
+	{
+		if( ACombatSignificanceManager * SignificanceManager = ACombatSignificanceManager::Get( World, false ) )
+			SignificanceManager->LogStats();
+	} ) );
+
+ACombatSignificanceManager::ACombatSignificanceManager() :
+	UpdateInterval( 0.25f ),
+	NearDistance( 1500.f ),
+	FarDistance( 4000.f ),
+	DuelDistance( 400.f ),
+	VisibilityTolerance( 0.5f ),
+	FarTickInterval( 0.05f ),
+	HiddenTickInterval( 0.2f ),
+	m_TimeToUpdate( 0.f )
+{
+	bReplicates = false;
+	PrimaryActorTick.bCanEverTick = true;
+}
+
+ACombatSignificanceManager * ACombatSignificanceManager::Get( UWorld * World, bool bSpawnIfMissing )
+{
+	if( !World || World->GetNetMode() == NM_DedicatedServer )
+		return nullptr;
+
+	for( TActorIterator<ACombatSignificanceManager> It( World ); It; ++It )
+	{
+		if( !It->IsPendingKill() )
+			return *It;
+	}
+
+	if( !bSpawnIfMissing )
+		return nullptr;
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	SpawnParams.ObjectFlags |= RF_Transient;
+
+	return World->SpawnActor<ACombatSignificanceManager>( SpawnParams );
+}
+
+void ACombatSignificanceManager::RegisterHuman( AHuman * Human )
+{
+	const bool bRegistered = m_Humans.ContainsByPredicate( [ Human ]( const FSignificantHuman & Entry ) { return Entry.Human == Human; } );
+	if( !Human || bRegistered )
+		return;
+
+	FSignificantHuman Entry;
+	Entry.Human = Human;
+	m_Humans.Add( Entry );
+
+	/* Rate the newcomer right away instead of running it at full cost until the next update */
+	m_TimeToUpdate = 0.f;
+}
+
+void ACombatSignificanceManager::UnregisterHuman( AHuman * Human )
+{
+	m_Humans.RemoveAll( [ Human ]( const FSignificantHuman & Entry ) { return Entry.Human == Human; } );
+}
+
+ECombatSignificance ACombatSignificanceManager::GetSignificance( const AHuman * Human ) const
+{
+	const FSignificantHuman * Entry = m_Humans.FindByPredicate( [ Human ]( const FSignificantHuman & Other ) { return Other.Human == Human; } );
+
+	return Entry ? Entry->Significance : ECombatSignificance::Focus;
+}
+
+void ACombatSignificanceManager::Tick( float DeltaTime )
+{
+	Super::Tick( DeltaTime );
+
+	m_TimeToUpdate -= DeltaTime;
+	if( m_TimeToUpdate > 0.f )
+		return;
+
+	m_TimeToUpdate = UpdateInterval;
+	UpdateSignificance();
+}
+
+void ACombatSignificanceManager::UpdateSignificance()
+{
+	UWorld * World = GetWorld();
+
+	TArray<FVector> Viewpoints;
+	TArray<AHuman *> FocusHumans;
+
+	for( FConstPlayerControllerIterator It = World->GetPlayerControllerIterator(); It; ++It )
+	{
+		APlayerController * PlayerController = It->Get();
+		if( !PlayerController || !PlayerController->IsLocalController() )
+			continue;
+
+		FVector ViewLocation;
+		FRotator ViewRotation;
+		PlayerController->GetPlayerViewPoint( ViewLocation, ViewRotation );
+		Viewpoints.Add( ViewLocation );
+
+		/* Own pawn and the spectated duelist */
+		if( AHuman * Pawn = Cast<AHuman>( PlayerController->GetPawn() ) )
+			FocusHumans.AddUnique( Pawn );
+
+		if( AHuman * ViewTarget = Cast<AHuman>( PlayerController->GetViewTarget() ) )
+			FocusHumans.AddUnique( ViewTarget );
+	}
+
+	/* Opponents of focused humans, one level deep so a crowd does not pull everyone into focus */
+	const int32 NumDirectFocus = FocusHumans.Num();
+	for( int32 i = 0; i < NumDirectFocus; ++i )
+	{
+		for( const FSignificantHuman & Entry : m_Humans )
+		{
+			AHuman * Other = Entry.Human.Get();
+			if( Other && FVector::DistSquared( Other->GetActorLocation(), FocusHumans[ i ]->GetActorLocation() ) <= FMath::Square( DuelDistance ) )
+				FocusHumans.AddUnique( Other );
+		}
+	}
+
+	int32 NumPerTier[ int32( ECombatSignificance::Count ) ] = { 0 };
+
+	for( int32 i = m_Humans.Num() - 1; i >= 0; --i )
+	{
+		FSignificantHuman & Entry = m_Humans[ i ];
+		AHuman * Human = Entry.Human.Get();
+
+		if( !Human )
+		{
+			m_Humans.RemoveAtSwap( i );
+			continue;
+		}
+
+		const ECombatSignificance Significance = Evaluate( Human, Viewpoints, FocusHumans );
+		++NumPerTier[ int32( Significance ) ];
+
+		/* Tick intervals and mesh flags are only touched when the tier changes */
+		if( Significance != Entry.Significance )
+		{
+			Apply( Human, Significance );
+			Entry.Significance = Significance;
+		}
+	}
+
+	SET_DWORD_STAT( STAT_SignificanceFocus, NumPerTier[ int32( ECombatSignificance::Focus ) ] );
+	SET_DWORD_STAT( STAT_SignificanceNear, NumPerTier[ int32( ECombatSignificance::Near ) ] );
+	SET_DWORD_STAT( STAT_SignificanceFar, NumPerTier[ int32( ECombatSignificance::Far ) ] );
+	SET_DWORD_STAT( STAT_SignificanceHidden, NumPerTier[ int32( ECombatSignificance::Hidden ) ] );
+}
+
+ECombatSignificance ACombatSignificanceManager::Evaluate( AHuman * Human, const TArray<FVector> & Viewpoints, const TArray<AHuman *> & FocusHumans ) const
+{
+	if( CVarCombatSignificance.GetValueOnGameThread() <= 0 || Viewpoints.Num() == 0 || FocusHumans.Contains( Human ) )
+		return ECombatSignificance::Focus;
+
+	float MinDistanceSquared = MAX_flt;
+	for( const FVector & Viewpoint : Viewpoints )
+		MinDistanceSquared = FMath::Min( MinDistanceSquared, FVector::DistSquared( Viewpoint, Human->GetActorLocation() ) );
+
+	const USkeletalMeshComponent * Mesh = Human->GetMesh();
+	const bool bOnScreen = Mesh && GetWorld()->TimeSince( Mesh->LastRenderTimeOnScreen ) <= VisibilityTolerance;
+
+	if( !bOnScreen || MinDistanceSquared > FMath::Square( FarDistance ) )
+		return ECombatSignificance::Hidden;
+
+	if( MinDistanceSquared > FMath::Square( NearDistance ) )
+		return ECombatSignificance::Far;
+
+	return ECombatSignificance::Near;
+}
+
+void ACombatSignificanceManager::Apply( AHuman * Human, ECombatSignificance Significance ) const
+{
+	float TickInterval = 0.f;
+	if( Significance == ECombatSignificance::Far )
+		TickInterval = FarTickInterval;
+	else if( Significance == ECombatSignificance::Hidden )
+		TickInterval = HiddenTickInterval;
+
+	/* Autonomous and authority humans run gameplay in their tick, montage timers and stamina must not lag */
+	const bool bSimulatedProxy = Human->Role == ROLE_SimulatedProxy;
+
+	if( bSimulatedProxy )
+	{
+		Human->SetActorTickInterval( TickInterval );
+
+		if( UCharacterMovementComponent * Movement = Human->GetCharacterMovement() )
+			Movement->SetComponentTickInterval( TickInterval );
+	}
+
+	if( USkeletalMeshComponent * Mesh = Human->GetMesh() )
+	{
+		/* Bones of simulated humans are only cosmetic, blades of the rest are queried by combat manager every frame */
+		Mesh->bEnableUpdateRateOptimizations = bSimulatedProxy && Significance != ECombatSignificance::Focus;
+		Mesh->VisibilityBasedAnimTickOption = bSimulatedProxy && Significance != ECombatSignificance::Focus
+											  ? EMeshComponentUpdateFlag::OnlyTickPoseWhenRendered
+											  : EMeshComponentUpdateFlag::AlwaysTickPoseAndRefreshBones;
+	}
+
+	if( ASaber * Saber = Human->GetSaber() )
+		Saber->SetReducedFidelity( Significance == ECombatSignificance::Far || Significance == ECombatSignificance::Hidden, TickInterval );
+}
+
+void ACombatSignificanceManager::LogStats() const
+{
+	int32 NumPerTier[ int32( ECombatSignificance::Count ) ] = { 0 };
+	for( const FSignificantHuman & Entry : m_Humans )
+		++NumPerTier[ int32( Entry.Significance ) ];
+
+	UE_LOG( LogTemp, Log, TEXT( "Combat significance : %d humans, %d focus, %d near, %d far, %d hidden." ),
+			m_Humans.Num(),
+			NumPerTier[ int32( ECombatSignificance::Focus ) ],
+			NumPerTier[ int32( ECombatSignificance::Near ) ],
+			NumPerTier[ int32( ECombatSignificance::Far ) ],
+			NumPerTier[ int32( ECombatSignificance::Hidden ) ] );
+}
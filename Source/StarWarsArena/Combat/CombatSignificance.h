@@ -0,0 +1,99 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "CombatSignificance.generated.h"
+
+class AHuman;
+
+DECLARE_STATS_GROUP( TEXT( "CombatSignificance" ), STATGROUP_CombatSignificance, STATCAT_Advanced );
+
+enum class ECombatSignificance : uint8
+{
+	/* Local pawn, spectated view target and whoever they duel - full fidelity */
+	Focus,
+	/* On screen and close */
+	Near,
+	/* On screen but far away */
+	Far,
+	/* Not on screen lately or beyond far distance */
+	Hidden,
+	Count
+};
+
+/* Registered human and the tier last applied to it */
+struct FSignificantHuman
+{
+	TWeakObjectPtr<AHuman>				Human;
+	ECombatSignificance					Significance = ECombatSignificance::Focus;
+};
+
+/**
+* Per-world budget of human and saber update cost on machines that render.
+* A few times per second every registered human is rated against the local viewpoints and its tier is applied:
+* update rate optimization of the skeletal mesh for everyone out of focus, lower actor and movement tick rate
+* and no pose update when off screen for simulated proxies, saber blade interpolation and hum put to sleep.
+* Humans simulated by this machine keep their gameplay tick - only simulated proxies lose tick rate.
+* Not spawned on dedicated server, Get returns null there. swa.CombatSignificance 0 keeps everyone at full fidelity.
+*/
+UCLASS( NotPlaceable, Transient, Config = Game )
+class STARWARSARENA_API ACombatSignificanceManager : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	ACombatSignificanceManager();
+
+	/* Returns manager of the world, spawning it on first use. Null on dedicated server */
+	static ACombatSignificanceManager *	Get( UWorld * World, bool bSpawnIfMissing = true );
+
+	void								RegisterHuman( AHuman * Human );
+
+	void								UnregisterHuman( AHuman * Human );
+
+	/* Tier applied to the human, Focus if it is not registered */
+	ECombatSignificance					GetSignificance( const AHuman * Human ) const;
+
+	virtual void						Tick( float DeltaTime ) override;
+
+	/* Number of humans in every tier */
+	void								LogStats() const;
+
+protected:
+	/* Seconds between two ratings */
+	UPROPERTY( Config )
+	float								UpdateInterval;
+
+	UPROPERTY( Config )
+	float								NearDistance;
+
+	UPROPERTY( Config )
+	float								FarDistance;
+
+	/* Humans this close to a focused one are its duel opponents and stay in focus too */
+	UPROPERTY( Config )
+	float								DuelDistance;
+
+	/* Mesh not rendered on screen for this many seconds is hidden */
+	UPROPERTY( Config )
+	float								VisibilityTolerance;
+
+	UPROPERTY( Config )
+	float								FarTickInterval;
+
+	UPROPERTY( Config )
+	float								HiddenTickInterval;
+
+private:
+	void								UpdateSignificance();
+
+	ECombatSignificance					Evaluate( AHuman * Human, const TArray<FVector> & Viewpoints, const TArray<AHuman *> & FocusHumans ) const;
+
+	void								Apply( AHuman * Human, ECombatSignificance Significance ) const;
+
+	TArray<FSignificantHuman>			m_Humans;
+
+	float								m_TimeToUpdate;
+};
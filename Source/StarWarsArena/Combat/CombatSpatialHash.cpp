@@ -0,0 +1,133 @@
+#include "CombatSpatialHash.h"
+
+FCombatSpatialHash::FCombatSpatialHash( float InCellSize )
+{
+	Reset( InCellSize );
+}
+
+void FCombatSpatialHash::Reset( float NewCellSize )
+{
+	m_CellSize = FMath::Max( NewCellSize, 1.f );
+	m_InvCellSize = 1.f / m_CellSize;
+
+	m_Entries.Reset();
+	m_Cells.Reset();
+}
+
+FIntVector FCombatSpatialHash::ToCell( const FVector & Location ) const
+{
+	return FIntVector( FMath::FloorToInt( Location.X * m_InvCellSize ),
+					   FMath::FloorToInt( Location.Y * m_InvCellSize ),
+					   FMath::FloorToInt( Location.Z * m_InvCellSize ) );
+}
+
+uint64 FCombatSpatialHash::CellKey( int32 X, int32 Y, int32 Z )
+{
+	/* 21 bits per axis is enough for +-1M cells */
+	return ( uint64( X & 0x1FFFFF ) << 42 ) | ( uint64( Y & 0x1FFFFF ) << 21 ) | uint64( Z & 0x1FFFFF );
+}
+
+void FCombatSpatialHash::AddToCells( int32 Id, const FIntVector & MinCell, const FIntVector & MaxCell )
+{
+	for( int32 X = MinCell.X; X <= MaxCell.X; ++X )
+		for( int32 Y = MinCell.Y; Y <= MaxCell.Y; ++Y )
+			for( int32 Z = MinCell.Z; Z <= MaxCell.Z; ++Z )
+				m_Cells.FindOrAdd( CellKey( X, Y, Z ) ).Add( Id );
+}
+
+void FCombatSpatialHash::RemoveFromCells( int32 Id, const FIntVector & MinCell, const FIntVector & MaxCell )
+{
+	for( int32 X = MinCell.X; X <= MaxCell.X; ++X )
+		for( int32 Y = MinCell.Y; Y <= MaxCell.Y; ++Y )
+			for( int32 Z = MinCell.Z; Z <= MaxCell.Z; ++Z )
+			{
+				const uint64 Key = CellKey( X, Y, Z );
+				TArray<int32> * Cell = m_Cells.Find( Key );
+				if( !Cell )
+					continue;
+
+				Cell->RemoveSingleSwap( Id, false );
+				if( Cell->Num() == 0 )
+					m_Cells.Remove( Key );
+			}
+}
+
+void FCombatSpatialHash::Update( int32 Id, const FBox & Bounds )
+{
+	const FIntVector MinCell = ToCell( Bounds.Min );
+	const FIntVector MaxCell = ToCell( Bounds.Max );
+
+	FEntry * Entry = m_Entries.Find( Id );
+	if( !Entry )
+	{
+		FEntry NewEntry;
+		NewEntry.MinCell = MinCell;
+		NewEntry.MaxCell = MaxCell;
+		NewEntry.Bounds = Bounds;
+		m_Entries.Add( Id, NewEntry );
+
+		AddToCells( Id, MinCell, MaxCell );
+		return;
+	}
+
+	Entry->Bounds = Bounds;
+
+	if( Entry->MinCell == MinCell && Entry->MaxCell == MaxCell )
+		return;
+
+	RemoveFromCells( Id, Entry->MinCell, Entry->MaxCell );
+	AddToCells( Id, MinCell, MaxCell );
+
+	Entry->MinCell = MinCell;
+	Entry->MaxCell = MaxCell;
+}
+
+void FCombatSpatialHash::Remove( int32 Id )
+{
+	FEntry Entry;
+	if( !m_Entries.RemoveAndCopyValue( Id, Entry ) )
+		return;
+
+	RemoveFromCells( Id, Entry.MinCell, Entry.MaxCell );
+}
+
+SIZE_T FCombatSpatialHash::GetAllocatedSize() const
+{
+	SIZE_T Size = m_Entries.GetAllocatedSize() + m_Cells.GetAllocatedSize();
+
+	for( const auto & Cell : m_Cells )
+		Size += Cell.Value.GetAllocatedSize();
+
+	return Size;
+}
+
+void FCombatSpatialHash::Query( const FBox & Bounds, TArray<int32> & OutIds ) const
+{
+	OutIds.Reset();
+
+	const FIntVector MinCell = ToCell( Bounds.Min );
+	const FIntVector MaxCell = ToCell( Bounds.Max );
+
+	for( int32 X = MinCell.X; X <= MaxCell.X; ++X )
+		for( int32 Y = MinCell.Y; Y <= MaxCell.Y; ++Y )
+			for( int32 Z = MinCell.Z; Z <= MaxCell.Z; ++Z )
+			{
+				const TArray<int32> * Cell = m_Cells.Find( CellKey( X, Y, Z ) );
+				if( !Cell )
+					continue;
+
+				for( int32 Id : *Cell )
+				{
+					if( m_Entries.FindChecked( Id ).Bounds.Intersect( Bounds ) )
+						OutIds.Add( Id );
+				}
+			}
+
+	/* Entry spanning several cells is found once per cell */
+	OutIds.Sort();
+	for( int32 i = OutIds.Num() - 1; i > 0; --i )
+	{
+		if( OutIds[ i ] == OutIds[ i - 1 ] )
+			OutIds.RemoveAt( i, 1, false );
+	}
+}
@@ -0,0 +1,60 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+* Uniform grid of axis aligned boxes for combat broadphase.
+* Entries keep their cell range, so an update only touches cells when the range changes -
+* characters walking inside a cell cost one comparison per frame.
+* Ids are caller defined and must be unique inside one hash.
+*/
+class STARWARSARENA_API FCombatSpatialHash
+{
+public:
+	explicit FCombatSpatialHash( float InCellSize = 400.f );
+
+	/* Adds entry or moves it to new bounds */
+	void								Update( int32 Id, const FBox & Bounds );
+
+	void								Remove( int32 Id );
+
+	/* Removes all entries and sets new cell size */
+	void								Reset( float NewCellSize );
+
+	/* Collects ids of entries overlapping Bounds. Result is sorted and has no duplicates */
+	void								Query( const FBox & Bounds, TArray<int32> & OutIds ) const;
+
+	bool								Contains( int32 Id ) const								{ return m_Entries.Contains( Id ); }
+
+	float								GetCellSize() const										{ return m_CellSize; }
+
+	int32								GetNumEntries() const									{ return m_Entries.Num(); }
+
+	int32								GetNumCells() const										{ return m_Cells.Num(); }
+
+	SIZE_T								GetAllocatedSize() const;
+
+private:
+	struct FEntry
+	{
+		FIntVector						MinCell;
+		FIntVector						MaxCell;
+		FBox							Bounds;
+	};
+
+	FIntVector							ToCell( const FVector & Location ) const;
+
+	static uint64						CellKey( int32 X, int32 Y, int32 Z );
+
+	void								AddToCells( int32 Id, const FIntVector & MinCell, const FIntVector & MaxCell );
+
+	void								RemoveFromCells( int32 Id, const FIntVector & MinCell, const FIntVector & MaxCell );
+
+	float								m_CellSize;
+	float								m_InvCellSize;
+
+	TMap<int32, FEntry>					m_Entries;
+	TMap<uint64, TArray<int32>>			m_Cells;
+};
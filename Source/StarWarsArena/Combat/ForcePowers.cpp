@@ -0,0 +1,291 @@
+#include "ForcePowers.h"
+#include "Human.h"
+#include "Objects/Saber.h"
+#include "Diagnostics/HitchWatchdog.h"
+#include "Components/PrimitiveComponent.h"
+#include "Engine/World.h"
+
+#include "EngineUtils.h"
+
+static FAutoConsoleCommandWithWorld ForcePowerStatsCommand(
+	TEXT( "swa.ForceStats" ),
+	TEXT( "Logs force powers used, overlaps run and targets moved in this world." ),
+	FConsoleCommandWithWorldDelegate::CreateLambda( []( UWorld * World )
+	{
+		if( AForcePowerManager * Manager = AForcePowerManager::Get( World, false ) )
+			Manager->LogStats();
+		else
+			UE_LOG( LogTemp, Display, TEXT( "No force powers were used in this world" ) );
+	} ) );
+
+AForcePowerManager::AForcePowerManager() :
+	PushForceCost( 25 ),
+	PullForceCost( 25 ),
+	RecallForceCost( 10 ),
+	PushRadius( 600.f ),
+	PullRadius( 800.f ),
+	RecallRadius( 2000.f ),
+	ConeHalfAngle( 40.f ),
+	PushSpeed( 1200.f ),
+	PullSpeed( 900.f ),
+	EdgeStrengthScale( 0.5f ),
+	PushLiftSpeed( 250.f ),
+	DefendingStrengthScale( 0.25f ),
+	PhysicsSpeedScale( 1.f ),
+	MaxQueriesPerFrame( 4 ),
+	m_NumPowers( 0 ),
+	m_NumQueries( 0 ),
+	m_NumDropped( 0 ),
+	m_NumMovedHumans( 0 ),
+	m_NumMovedBodies( 0 ),
+	m_NumRecalledSabers( 0 ),
+	m_MaxPending( 0 )
+{
+	bReplicates = false;
+
+	PrimaryActorTick.bCanEverTick = true;
+}
+
+AForcePowerManager * AForcePowerManager::Get( UWorld * World, bool bSpawnIfMissing )
+{
+	if( !World )
+		return nullptr;
+
+	for( TActorIterator<AForcePowerManager> It( World ); It; ++It )
+	{
+		if( !It->IsPendingKill() )
+			return *It;
+	}
+
+	if( !bSpawnIfMissing )
+		return nullptr;
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	SpawnParams.ObjectFlags |= RF_Transient;
+
+	return World->SpawnActor<AForcePowerManager>( SpawnParams );
+}
+
+int32 AForcePowerManager::GetForceCost( EForcePower Power )
+{
+	const AForcePowerManager * Defaults = GetDefault<AForcePowerManager>();
+
+	switch( Power )
+	{
+		case EForcePower::EFP_Push :	return Defaults->PushForceCost;
+		case EForcePower::EFP_Pull :	return Defaults->PullForceCost;
+		case EForcePower::EFP_Recall :	return Defaults->RecallForceCost;
+	}
+
+	return 0;
+}
+
+float AForcePowerManager::GetRadius( EForcePower Power ) const
+{
+	switch( Power )
+	{
+		case EForcePower::EFP_Push :	return PushRadius;
+		case EForcePower::EFP_Pull :	return PullRadius;
+		case EForcePower::EFP_Recall :	return RecallRadius;
+	}
+
+	return 0.f;
+}
+
+void AForcePowerManager::RequestPower( AHuman * Caster, EForcePower Power, const FVector & Origin, const FVector & Direction )
+{
+	if( !Caster )
+		return;
+
+	FForcePowerRequest Request;
+	Request.Caster = Caster;
+	Request.Power = Power;
+	Request.Origin = Origin;
+	Request.Direction = Direction.GetSafeNormal();
+	m_Pending.Add( Request );
+
+	++m_NumPowers;
+	m_MaxPending = FMath::Max( m_MaxPending, m_Pending.Num() );
+}
+
+void AForcePowerManager::Tick( float DeltaTime )
+{
+	HITCH_TIMER( GetWorld(), EHitchTimer::ForcePowers );
+
+	Super::Tick( DeltaTime );
+
+	ResolvePowers();
+	IssueQueries();
+}
+
+void AForcePowerManager::IssueQueries()
+{
+	if( m_Pending.Num() == 0 )
+		return;
+
+	/* Characters, blades of sabers, Sliceable objects and debris */
+	FCollisionObjectQueryParams ObjectParams;
+	ObjectParams.AddObjectTypesToQuery( ECC_Pawn );
+	ObjectParams.AddObjectTypesToQuery( ECC_WorldDynamic );
+	ObjectParams.AddObjectTypesToQuery( ECC_PhysicsBody );
+
+	const int32 NumToIssue = FMath::Min( m_Pending.Num(), FMath::Max( MaxQueriesPerFrame, 1 ) );
+
+	for( int32 i = 0; i < NumToIssue; ++i )
+	{
+		FForcePowerRequest & Request = m_Pending[ i ];
+
+		if( !Request.Caster.IsValid() )
+			continue;
+
+		FCollisionQueryParams Params( FName( TEXT( "ForcePower" ) ), false, Request.Caster.Get() );
+
+		/* Runs on worker threads during this frame, result is taken next frame */
+		Request.Overlap = GetWorld()->AsyncOverlapByObjectType( Request.Origin, FQuat::Identity, ObjectParams,
+																FCollisionShape::MakeSphere( GetRadius( Request.Power ) ), Params );
+		m_Issued.Add( Request );
+		++m_NumQueries;
+	}
+
+	/* Waiting requests keep their order, oldest go first next frame */
+	m_Pending.RemoveAt( 0, NumToIssue, false );
+}
+
+void AForcePowerManager::ResolvePowers()
+{
+	if( m_Issued.Num() == 0 )
+		return;
+
+	UWorld * World = GetWorld();
+
+	/* Manager does not replicate, so it has authority everywhere. Characters and sabers belong to the server */
+	const bool bServer = GetNetMode() != NM_Client;
+
+	m_HumanVelocities.Reset();
+	m_BodyVelocities.Reset();
+	m_RecalledSabers.Reset();
+
+	for( const FForcePowerRequest & Request : m_Issued )
+	{
+		FOverlapDatum Datum;
+		if( !World->QueryOverlapData( Request.Overlap, Datum ) )
+		{
+			/* Overlap was dropped ( world paused or frame skipped ), force is spent anyway */
+			++m_NumDropped;
+			continue;
+		}
+
+		const AHuman * Caster = Request.Caster.Get();
+		if( !Caster )
+			continue;
+
+		for( const FOverlapResult & Overlap : Datum.OutOverlaps )
+		{
+			AActor * Actor = Overlap.GetActor();
+			UPrimitiveComponent * Component = Overlap.GetComponent();
+
+			if( !Actor || !Component || Actor == Caster )
+				continue;
+
+			/* Recall brings caster's own saber, push sends thrown sabers of others back to their owners */
+			if( ASaber * Saber = Cast<ASaber>( Actor ) )
+			{
+				const bool bOwnSaber = Saber->GetHuman() == Caster;
+				const bool bRecall = Request.Power == EForcePower::EFP_Recall ? bOwnSaber : Request.Power == EForcePower::EFP_Push && !bOwnSaber;
+
+				if( bServer && bRecall && Saber->IsThrown() )
+					m_RecalledSabers.AddUnique( Saber );
+
+				continue;
+			}
+
+			if( Request.Power == EForcePower::EFP_Recall )
+				continue;
+
+			if( AHuman * Human = Cast<AHuman>( Actor ) )
+			{
+				/* Capsule only, mesh of the same character is found too */
+				if( !bServer || Component != Human->GetRootComponent() )
+					continue;
+
+				const float Scale = Human->GetState() == EHumanState::EHS_Defending ? DefendingStrengthScale : 1.f;
+				const FVector Velocity = GetTargetVelocity( Request, Human->GetActorLocation() ) * Scale;
+
+				if( !Velocity.IsNearlyZero() )
+					m_HumanVelocities.FindOrAdd( Human ) += Velocity;
+			}
+			else if( Component->IsSimulatingPhysics() && ( bServer || !Actor->GetIsReplicated() ) )
+			{
+				const FVector Velocity = GetTargetVelocity( Request, Component->GetComponentLocation() ) * PhysicsSpeedScale;
+
+				if( !Velocity.IsNearlyZero() )
+					m_BodyVelocities.FindOrAdd( Component ) += Velocity;
+			}
+		}
+	}
+
+	m_Issued.Reset();
+
+	/* Everything found is moved once, a target caught by several powers gets their sum */
+	for( const TPair<TWeakObjectPtr<AHuman>, FVector> & Pair : m_HumanVelocities )
+	{
+		if( AHuman * Human = Pair.Key.Get() )
+		{
+			Human->LaunchCharacter( Pair.Value, false, false );
+			++m_NumMovedHumans;
+		}
+	}
+
+	for( const TPair<TWeakObjectPtr<UPrimitiveComponent>, FVector> & Pair : m_BodyVelocities )
+	{
+		if( UPrimitiveComponent * Component = Pair.Key.Get() )
+		{
+			Component->AddImpulse( Pair.Value, NAME_None, true );
+			++m_NumMovedBodies;
+		}
+	}
+
+	for( const TWeakObjectPtr<ASaber> & Saber : m_RecalledSabers )
+	{
+		if( Saber.IsValid() )
+		{
+			Saber->Recall();
+			++m_NumRecalledSabers;
+		}
+	}
+}
+
+FVector AForcePowerManager::GetTargetVelocity( const FForcePowerRequest & Request, const FVector & Location ) const
+{
+	const float Radius = GetRadius( Request.Power );
+	const FVector ToTarget = Location - Request.Origin;
+	const float Distance = ToTarget.Size();
+
+	if( Distance < KINDA_SMALL_NUMBER || Distance > Radius )
+		return FVector::ZeroVector;
+
+	const FVector Direction = ToTarget / Distance;
+	if( FVector::DotProduct( Direction, Request.Direction ) < FMath::Cos( FMath::DegreesToRadians( ConeHalfAngle ) ) )
+		return FVector::ZeroVector;
+
+	const float Strength = FMath::Lerp( 1.f, EdgeStrengthScale, Distance / Radius );
+
+	if( Request.Power == EForcePower::EFP_Push )
+		return ( Direction * PushSpeed + FVector::UpVector * PushLiftSpeed ) * Strength;
+
+	return -Direction * PullSpeed * Strength;
+}
+
+void AForcePowerManager::LogStats() const
+{
+	UE_LOG( LogTemp, Display, TEXT( "Force powers: %d used, %d overlaps, %d dropped, %d waiting ( peak %d ). Moved %d characters, %d bodies, recalled %d sabers" ),
+			m_NumPowers,
+			m_NumQueries,
+			m_NumDropped,
+			m_Pending.Num(),
+			m_MaxPending,
+			m_NumMovedHumans,
+			m_NumMovedBodies,
+			m_NumRecalledSabers );
+}
@@ -0,0 +1,146 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "WorldCollision.h"
+#include "ForcePowers.generated.h"
+
+class AHuman;
+class ASaber;
+class UPrimitiveComponent;
+
+UENUM( BlueprintType )
+enum class EForcePower : uint8
+{
+	EFP_Push				UMETA( DisplayName = "Push" ),		// Throws characters, thrown sabers and loose objects away in a cone
+	EFP_Pull				UMETA( DisplayName = "Pull" ),		// Drags characters and loose objects in a cone towards the caster
+	EFP_Recall				UMETA( DisplayName = "Recall" )		// Brings caster's thrown or stuck saber back
+};
+
+/* One power waiting for its overlap or for its overlap result */
+struct FForcePowerRequest
+{
+	TWeakObjectPtr<AHuman>				Caster;
+	EForcePower							Power = EForcePower::EFP_Push;
+
+	FVector								Origin = FVector::ZeroVector;
+	/* Caster's aim, unit length */
+	FVector								Direction = FVector::ForwardVector;
+
+	FTraceHandle						Overlap;
+};
+
+/**
+* Per-world manager of force powers.
+* A power does not touch the physics scene when it is used. Requests of the frame are turned into
+* asynchronous sphere overlaps, at most MaxQueriesPerFrame of them, the rest wait for the next frame.
+* Next frame all finished overlaps are resolved in one pass: cone filter, then the velocity every
+* target gets from all powers that found it is summed and applied once.
+* Every machine runs its own manager. Characters and sabers are only moved on authority, physics bodies
+* of actors that do not replicate ( slice debris, local props ) are moved everywhere.
+*/
+UCLASS( NotPlaceable, Transient, Config = Game )
+class STARWARSARENA_API AForcePowerManager : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	AForcePowerManager();
+
+	/* Returns manager of the world, spawning it on first use if bSpawnIfMissing is set */
+	static AForcePowerManager *			Get( UWorld * World, bool bSpawnIfMissing = true );
+
+	/* Force the power costs, from class defaults so clients check it the same way as server */
+	static int32						GetForceCost( EForcePower Power );
+
+	/* Queues the power, it takes effect one or more frames later */
+	void								RequestPower( AHuman * Caster, EForcePower Power, const FVector & Origin, const FVector & Direction );
+
+	virtual void						Tick( float DeltaTime ) override;
+
+	/* Powers, overlaps and moved targets since the manager started */
+	void								LogStats() const;
+
+protected:
+	UPROPERTY( Config )
+	int32								PushForceCost;
+
+	UPROPERTY( Config )
+	int32								PullForceCost;
+
+	UPROPERTY( Config )
+	int32								RecallForceCost;
+
+	UPROPERTY( Config )
+	float								PushRadius;
+
+	UPROPERTY( Config )
+	float								PullRadius;
+
+	/* Caster's saber further than this is out of reach */
+	UPROPERTY( Config )
+	float								RecallRadius;
+
+	/* Half angle of push and pull cone around caster's aim, degrees */
+	UPROPERTY( Config )
+	float								ConeHalfAngle;
+
+	/* Launch speed of a character at the caster, falls off linearly to EdgeStrengthScale at the radius */
+	UPROPERTY( Config )
+	float								PushSpeed;
+
+	UPROPERTY( Config )
+	float								PullSpeed;
+
+	UPROPERTY( Config )
+	float								EdgeStrengthScale;
+
+	/* Upward launch speed added to pushed characters, so ground friction does not eat the push */
+	UPROPERTY( Config )
+	float								PushLiftSpeed;
+
+	/* Speed scale of defending characters */
+	UPROPERTY( Config )
+	float								DefendingStrengthScale;
+
+	/* Velocity change of physics bodies relative to characters */
+	UPROPERTY( Config )
+	float								PhysicsSpeedScale;
+
+	/* Overlaps started per frame. Requests above it wait, so a crowd using powers at once is spread over frames */
+	UPROPERTY( Config )
+	int32								MaxQueriesPerFrame;
+
+private:
+	float								GetRadius( EForcePower Power ) const;
+
+	/* Takes results of overlaps started last frame and moves everything they found */
+	void								ResolvePowers();
+
+	/* Starts overlaps of waiting requests, up to MaxQueriesPerFrame */
+	void								IssueQueries();
+
+	/* Speed Request gives to something at Location, zero when outside the cone */
+	FVector								GetTargetVelocity( const FForcePowerRequest & Request, const FVector & Location ) const;
+
+	TArray<FForcePowerRequest>			m_Pending;
+
+	/* Requests with an overlap in flight, resolved next frame */
+	TArray<FForcePowerRequest>			m_Issued;
+
+	/* Summed velocities of the resolve pass, reused between frames */
+	TMap<TWeakObjectPtr<AHuman>, FVector>				m_HumanVelocities;
+	TMap<TWeakObjectPtr<UPrimitiveComponent>, FVector>	m_BodyVelocities;
+	TArray<TWeakObjectPtr<ASaber>>		m_RecalledSabers;
+
+	int32								m_NumPowers;
+	int32								m_NumQueries;
+	int32								m_NumDropped;
+	int32								m_NumMovedHumans;
+	int32								m_NumMovedBodies;
+	int32								m_NumRecalledSabers;
+	/* Longest the queue got, requests waiting for their overlap */
+	int32								m_MaxPending;
+};
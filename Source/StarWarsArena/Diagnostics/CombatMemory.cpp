@@ -0,0 +1,240 @@
+#include "CombatMemory.h"
+#include "Human.h"
+#include "MoveSet.h"
+#include "Objects/Saber.h"
+#include "Combat/CombatManager.h"
+#include "Slicing/SliceManager.h"
+#include "Animation/AnimMontage.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "HAL/PlatformMemory.h"
+#include "Serialization/ArchiveCountMem.h"
+
+#include "EngineUtils.h"
+
+#if ENABLE_LOW_LEVEL_MEM_TRACKER
+DECLARE_LLM_MEMORY_STAT( TEXT( "Combat" ), STAT_CombatLLMSummary, STATGROUP_LLM );
+DECLARE_LLM_MEMORY_STAT( TEXT( "CombatHumans" ), STAT_CombatHumansLLM, STATGROUP_LLMFULL );
+DECLARE_LLM_MEMORY_STAT( TEXT( "CombatMoveSets" ), STAT_CombatMoveSetsLLM, STATGROUP_LLMFULL );
+DECLARE_LLM_MEMORY_STAT( TEXT( "CombatMontages" ), STAT_CombatMontagesLLM, STATGROUP_LLMFULL );
+DECLARE_LLM_MEMORY_STAT( TEXT( "CombatSabers" ), STAT_CombatSabersLLM, STATGROUP_LLMFULL );
+DECLARE_LLM_MEMORY_STAT( TEXT( "CombatManager" ), STAT_CombatManagerLLM, STATGROUP_LLMFULL );
+DECLARE_LLM_MEMORY_STAT( TEXT( "CombatDebugDraw" ), STAT_CombatDebugDrawLLM, STATGROUP_LLMFULL );
+DECLARE_LLM_MEMORY_STAT( TEXT( "CombatSlicing" ), STAT_CombatSlicingLLM, STATGROUP_LLMFULL );
+#endif
+
+static FAutoConsoleCommandWithWorldAndArgs CombatMemoryCommand(
+	TEXT( "swa.CombatMemory" ),
+	TEXT( "Logs memory of combat subsystems and warns about exceeded budgets. 'all' reports every game world of the process." ),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda( []( const TArray<FString> & Args, UWorld * World )
+	{
+		TArray<UWorld *> Worlds;
+
+		if( Args.Num() > 0 && Args[ 0 ] == TEXT( "all" ) )
+		{
+			for( const FWorldContext & Context : GEngine->GetWorldContexts() )
+			{
+				if( Context.World() && ( Context.WorldType == EWorldType::Game || Context.WorldType == EWorldType::PIE ) )
+					Worlds.Add( Context.World() );
+			}
+		}
+		else
+		{
+			Worlds.Add( World );
+		}
+
+		for( UWorld * ReportWorld : Worlds )
+		{
+			const FCombatMemoryReport Report = CombatMemory::Measure( ReportWorld );
+			CombatMemory::LogReport( Report );
+			CombatMemory::CheckBudgets( Report );
+		}
+	} ) );
+
+namespace
+{
+	SIZE_T ObjectBytes( UObject * Object )
+	{
+		if( !Object )
+			return 0;
+
+		FArchiveCountMem Count( Object );
+		return Count.GetMax() + Object->GetResourceSizeBytes( EResourceSizeMode::Exclusive );
+	}
+
+	/* Actor and its components, Skip is counted by the caller under another subsystem */
+	SIZE_T ActorBytes( AActor * Actor, const UActorComponent * Skip = nullptr )
+	{
+		SIZE_T Bytes = ObjectBytes( Actor );
+
+		TInlineComponentArray<UActorComponent *> Components;
+		Actor->GetComponents( Components );
+
+		for( UActorComponent * Component : Components )
+		{
+			if( Component != Skip )
+				Bytes += ObjectBytes( Component );
+		}
+
+		return Bytes;
+	}
+
+	void WarnIfOver( const TCHAR * What, const FString & WorldName, double Value, float Budget, const TCHAR * Unit, int32 & NumExceeded )
+	{
+		if( Budget <= 0.f || Value <= Budget )
+			return;
+
+		UE_LOG( LogTemp, Warning, TEXT( "Combat memory budget exceeded in %s : %s %.1f %s, budget %.1f %s" ), *WorldName, What, Value, Unit, Budget, Unit );
+		++NumExceeded;
+	}
+}
+
+UCombatMemorySettings::UCombatMemorySettings() :
+	HumanKB( 256.f ),
+	SaberKB( 64.f ),
+	MontagesMB( 64.f ),
+	CombatManagerKB( 1024.f ),
+	SlicingKB( 2048.f ),
+	ArenaMB( 128.f ),
+	ProcessMB( 0.f ),
+	CheckInterval( 60.f )
+{
+}
+
+SIZE_T FCombatMemoryReport::GetTotal() const
+{
+	SIZE_T Total = 0;
+	for( SIZE_T SubsystemBytes : Bytes )
+		Total += SubsystemBytes;
+
+	return Total;
+}
+
+const TCHAR * CombatMemory::GetName( ECombatMemory Subsystem )
+{
+	switch( Subsystem )
+	{
+		case ECombatMemory::Humans :		return TEXT( "Humans" );
+		case ECombatMemory::MoveSets :		return TEXT( "MoveSets" );
+		case ECombatMemory::Montages :		return TEXT( "Montages" );
+		case ECombatMemory::Sabers :		return TEXT( "Sabers" );
+		case ECombatMemory::CombatManager :	return TEXT( "CombatManager" );
+		case ECombatMemory::DebugDraw :		return TEXT( "DebugDraw" );
+		case ECombatMemory::Slicing :		return TEXT( "Slicing" );
+		default :							break;
+	}
+
+	return TEXT( "Unknown" );
+}
+
+void CombatMemory::RegisterLLMTags()
+{
+#if ENABLE_LOW_LEVEL_MEM_TRACKER
+	const FName StatNames[] =
+	{
+		GET_STATFNAME( STAT_CombatHumansLLM ),
+		GET_STATFNAME( STAT_CombatMoveSetsLLM ),
+		GET_STATFNAME( STAT_CombatMontagesLLM ),
+		GET_STATFNAME( STAT_CombatSabersLLM ),
+		GET_STATFNAME( STAT_CombatManagerLLM ),
+		GET_STATFNAME( STAT_CombatDebugDrawLLM ),
+		GET_STATFNAME( STAT_CombatSlicingLLM )
+	};
+
+	static_assert( ARRAY_COUNT( StatNames ) == int32( ECombatMemory::Count ), "Every combat subsystem needs an LLM stat" );
+
+	for( int32 i = 0; i < int32( ECombatMemory::Count ); ++i )
+	{
+		const FString TagName = FString( TEXT( "Combat" ) ) + GetName( ECombatMemory( i ) );
+		FLowLevelMemTracker::Get().RegisterProjectTag( int32( ELLMTag::ProjectTagStart ) + i, *TagName, StatNames[ i ], GET_STATFNAME( STAT_CombatLLMSummary ) );
+	}
+#endif
+}
+
+FCombatMemoryReport CombatMemory::Measure( UWorld * World )
+{
+	FCombatMemoryReport Report;
+	if( !World )
+		return Report;
+
+	Report.WorldName = World->GetName();
+
+	TSet<UAnimMontage *> Montages;
+
+	for( TActorIterator<AHuman> It( World ); It; ++It )
+	{
+		Report.Bytes[ int32( ECombatMemory::Humans ) ] += ActorBytes( *It, It->MoveSet );
+		Report.Bytes[ int32( ECombatMemory::MoveSets ) ] += ObjectBytes( It->MoveSet );
+		++Report.NumHumans;
+
+		if( It->MoveSet )
+			It->MoveSet->GetAttackMontages( Montages );
+	}
+
+	/* Montages are assets shared by every move set using them, each is counted once with its sequences */
+	for( UAnimMontage * Montage : Montages )
+	{
+		FArchiveCountMem Count( Montage );
+		Report.Bytes[ int32( ECombatMemory::Montages ) ] += Count.GetMax() + Montage->GetResourceSizeBytes( EResourceSizeMode::EstimatedTotal );
+	}
+
+	Report.NumMontages = Montages.Num();
+
+	for( TActorIterator<ASaber> It( World ); It; ++It )
+	{
+		Report.Bytes[ int32( ECombatMemory::Sabers ) ] += ActorBytes( *It );
+		++Report.NumSabers;
+	}
+
+	if( ACombatManager * CombatManager = ACombatManager::Get( World, false ) )
+	{
+		Report.Bytes[ int32( ECombatMemory::CombatManager ) ] += ActorBytes( CombatManager ) + CombatManager->GetAllocatedSize();
+		Report.Bytes[ int32( ECombatMemory::DebugDraw ) ] += CombatManager->GetDebugDrawAllocatedSize();
+	}
+
+	if( ASliceManager * SliceManager = ASliceManager::Get( World, false ) )
+		Report.Bytes[ int32( ECombatMemory::Slicing ) ] += ActorBytes( SliceManager );
+
+	return Report;
+}
+
+void CombatMemory::LogReport( const FCombatMemoryReport & Report )
+{
+	UE_LOG( LogTemp, Display, TEXT( "Combat memory of %s : %.1f KB, %d humans, %d sabers, %d montages" ),
+			*Report.WorldName, Report.GetTotal() / 1024.f, Report.NumHumans, Report.NumSabers, Report.NumMontages );
+
+	for( int32 i = 0; i < int32( ECombatMemory::Count ); ++i )
+		UE_LOG( LogTemp, Display, TEXT( "  %-14s %10.1f KB" ), GetName( ECombatMemory( i ) ), Report.Bytes[ i ] / 1024.f );
+
+	const float HumanKB = Report.NumHumans > 0 ? ( Report.Bytes[ int32( ECombatMemory::Humans ) ] + Report.Bytes[ int32( ECombatMemory::MoveSets ) ] ) / 1024.f / Report.NumHumans : 0.f;
+	const float SaberKB = Report.NumSabers > 0 ? Report.Bytes[ int32( ECombatMemory::Sabers ) ] / 1024.f / Report.NumSabers : 0.f;
+
+	UE_LOG( LogTemp, Display, TEXT( "  Per human %.1f KB, per saber %.1f KB, per duel ( 2 humans, 2 sabers ) %.1f KB without shared montages" ),
+			HumanKB, SaberKB, ( HumanKB + SaberKB ) * 2.f );
+
+	const FPlatformMemoryStats MemoryStats = FPlatformMemory::GetStats();
+	UE_LOG( LogTemp, Display, TEXT( "  Process resident %.1f MB ( peak %.1f MB )" ),
+			MemoryStats.UsedPhysical / ( 1024.f * 1024.f ), MemoryStats.PeakUsedPhysical / ( 1024.f * 1024.f ) );
+}
+
+int32 CombatMemory::CheckBudgets( const FCombatMemoryReport & Report )
+{
+	const UCombatMemorySettings * Settings = GetDefault<UCombatMemorySettings>();
+	int32 NumExceeded = 0;
+
+	const auto KB = [ &Report ]( ECombatMemory Subsystem ) { return Report.Bytes[ int32( Subsystem ) ] / 1024.0; };
+
+	if( Report.NumHumans > 0 )
+		WarnIfOver( TEXT( "human" ), Report.WorldName, ( KB( ECombatMemory::Humans ) + KB( ECombatMemory::MoveSets ) ) / Report.NumHumans, Settings->HumanKB, TEXT( "KB" ), NumExceeded );
+
+	if( Report.NumSabers > 0 )
+		WarnIfOver( TEXT( "saber" ), Report.WorldName, KB( ECombatMemory::Sabers ) / Report.NumSabers, Settings->SaberKB, TEXT( "KB" ), NumExceeded );
+
+	WarnIfOver( TEXT( "montages" ), Report.WorldName, KB( ECombatMemory::Montages ) / 1024.0, Settings->MontagesMB, TEXT( "MB" ), NumExceeded );
+	WarnIfOver( TEXT( "combat manager" ), Report.WorldName, KB( ECombatMemory::CombatManager ) + KB( ECombatMemory::DebugDraw ), Settings->CombatManagerKB, TEXT( "KB" ), NumExceeded );
+	WarnIfOver( TEXT( "slicing" ), Report.WorldName, KB( ECombatMemory::Slicing ), Settings->SlicingKB, TEXT( "KB" ), NumExceeded );
+	WarnIfOver( TEXT( "arena" ), Report.WorldName, Report.GetTotal() / ( 1024.0 * 1024.0 ), Settings->ArenaMB, TEXT( "MB" ), NumExceeded );
+	WarnIfOver( TEXT( "process" ), Report.WorldName, FPlatformMemory::GetStats().UsedPhysical / ( 1024.0 * 1024.0 ), Settings->ProcessMB, TEXT( "MB" ), NumExceeded );
+
+	return NumExceeded;
+}
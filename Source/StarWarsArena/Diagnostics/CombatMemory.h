@@ -0,0 +1,110 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DeveloperSettings.h"
+#include "HAL/LowLevelMemTracker.h"
+#include "CombatMemory.generated.h"
+
+class UWorld;
+
+/* Combat subsystems memory is tracked and budgeted for */
+enum class ECombatMemory : uint8
+{
+	Humans,
+	MoveSets,
+	Montages,
+	Sabers,
+	CombatManager,
+	DebugDraw,
+	Slicing,
+	Count
+};
+
+/**
+* Memory budgets of combat subsystems, warned about by swa.CombatMemory and the periodic server check.
+* Zero disables a budget. Per human and per saber budgets are averages over all of them in a world.
+*/
+UCLASS( Config = Game, DefaultConfig, Meta = ( DisplayName = "Combat Memory" ) )
+class STARWARSARENA_API UCombatMemorySettings : public UDeveloperSettings
+{
+	GENERATED_BODY()
+
+public:
+	UCombatMemorySettings();
+
+	/* Actor, components and move set of one human */
+	UPROPERTY( Config, EditAnywhere, Category = "Budgets", Meta = ( ClampMin = "0" ) )
+	float								HumanKB;
+
+	UPROPERTY( Config, EditAnywhere, Category = "Budgets", Meta = ( ClampMin = "0" ) )
+	float								SaberKB;
+
+	/* Attack montages of all move sets, shared by everyone using the same asset */
+	UPROPERTY( Config, EditAnywhere, Category = "Budgets", Meta = ( ClampMin = "0" ) )
+	float								MontagesMB;
+
+	/* Combat manager with its queries, hashes and debug draw ring */
+	UPROPERTY( Config, EditAnywhere, Category = "Budgets", Meta = ( ClampMin = "0" ) )
+	float								CombatManagerKB;
+
+	UPROPERTY( Config, EditAnywhere, Category = "Budgets", Meta = ( ClampMin = "0" ) )
+	float								SlicingKB;
+
+	/* Everything above for one arena ( world ) */
+	UPROPERTY( Config, EditAnywhere, Category = "Budgets", Meta = ( ClampMin = "0" ) )
+	float								ArenaMB;
+
+	/* Resident memory of the whole process */
+	UPROPERTY( Config, EditAnywhere, Category = "Budgets", Meta = ( ClampMin = "0" ) )
+	float								ProcessMB;
+
+	/* Seconds between budget checks on dedicated server, zero turns the check off */
+	UPROPERTY( Config, EditAnywhere, Category = "Budgets", Meta = ( ClampMin = "0" ) )
+	float								CheckInterval;
+};
+
+/* Measured memory of one world */
+struct FCombatMemoryReport
+{
+	FString								WorldName;
+	SIZE_T								Bytes[ int32( ECombatMemory::Count ) ];
+	int32								NumHumans = 0;
+	int32								NumSabers = 0;
+	int32								NumMontages = 0;
+
+	FCombatMemoryReport()
+	{
+		FMemory::Memzero( Bytes );
+	}
+
+	SIZE_T								GetTotal() const;
+};
+
+/**
+* Memory of combat subsystems.
+* Measured: objects are counted with FArchiveCountMem plus their resource size, native containers by their allocated size.
+* Tracked: allocations under COMBAT_LLM_SCOPE go to the project LLM tags Combat*, visible with -LLM in stat LLM and the LLM csv.
+*/
+namespace CombatMemory
+{
+	STARWARSARENA_API const TCHAR *		GetName( ECombatMemory Subsystem );
+
+	/* Registers LLM tags, called at module start */
+	STARWARSARENA_API void				RegisterLLMTags();
+
+	STARWARSARENA_API FCombatMemoryReport Measure( UWorld * World );
+
+	/* Logs the report with per human, per duel and process figures */
+	STARWARSARENA_API void				LogReport( const FCombatMemoryReport & Report );
+
+	/* Warns about every exceeded budget. Returns number of them */
+	STARWARSARENA_API int32				CheckBudgets( const FCombatMemoryReport & Report );
+}
+
+#if ENABLE_LOW_LEVEL_MEM_TRACKER
+	#define COMBAT_LLM_SCOPE( Subsystem )	LLM_SCOPE( ELLMTag( int32( ELLMTag::ProjectTagStart ) + int32( Subsystem ) ) )
+#else
+	#define COMBAT_LLM_SCOPE( Subsystem )
+#endif
@@ -0,0 +1,319 @@
+#include "HitchWatchdog.h"
+#include "Engine/World.h"
+#include "Engine/NetDriver.h"
+#include "Engine/NetConnection.h"
+#include "Engine/Channel.h"
+#include "Async/Async.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+#include "EngineUtils.h"
+
+static TAutoConsoleVariable<int32> CVarHitchWatchdog(
+	TEXT( "swa.HitchWatchdog" ),
+	1,
+	TEXT( "Server hitch watchdog.\n" )
+	TEXT( " 0: off\n" )
+	TEXT( " 1: record combat counters of recent frames and dump them on slow frames" ) );
+
+static FAutoConsoleCommandWithWorld HitchStatsCommand(
+	TEXT( "swa.HitchStats" ),
+	TEXT( "Logs hitch count, dumps written and frame times of the watchdog history." ),
+	FConsoleCommandWithWorldDelegate::CreateLambda( []( UWorld * World )
+	{
+		if( AHitchWatchdog * Watchdog = AHitchWatchdog::Get( World, false ) )
+			Watchdog->LogStats();
+	} ) );
+
+static FAutoConsoleCommandWithWorld HitchDumpCommand(
+	TEXT( "swa.HitchDump" ),
+	TEXT( "Writes the hitch watchdog history to Saved/Logs now." ),
+	FConsoleCommandWithWorldDelegate::CreateLambda( []( UWorld * World )
+	{
+		if( AHitchWatchdog * Watchdog = AHitchWatchdog::Get( World, false ) )
+			Watchdog->Dump( TEXT( "Requested by swa.HitchDump" ) );
+	} ) );
+
+namespace
+{
+	const TCHAR * EventName( EHitchEvent Type )
+	{
+		switch( Type )
+		{
+			case EHitchEvent::BladeOverlap :	return TEXT( "Overlap" );
+			case EHitchEvent::BladeClash :		return TEXT( "Clash" );
+			case EHitchEvent::SaberLaunch :		return TEXT( "Launch" );
+			case EHitchEvent::SaberStop :		return TEXT( "Stop" );
+			case EHitchEvent::PlayAttack :		return TEXT( "Attack" );
+			case EHitchEvent::StateChange :		return TEXT( "State" );
+			case EHitchEvent::StatsUpdate :		return TEXT( "Stats" );
+			case EHitchEvent::SaberTransform :	return TEXT( "Transform" );
+			case EHitchEvent::ForcePower :		return TEXT( "Force" );
+			default :							break;
+		}
+
+		return TEXT( "Unknown" );
+	}
+
+	const TCHAR * TimerName( EHitchTimer Timer )
+	{
+		switch( Timer )
+		{
+			case EHitchTimer::Human :			return TEXT( "Human" );
+			case EHitchTimer::Saber :			return TEXT( "Saber" );
+			case EHitchTimer::CombatManager :	return TEXT( "Combat" );
+			case EHitchTimer::ForcePowers :		return TEXT( "Force" );
+			case EHitchTimer::Bots :			return TEXT( "Bots" );
+			default :							break;
+		}
+
+		return TEXT( "Unknown" );
+	}
+
+	/* Copy of the history handed to the writer thread */
+	struct FHitchDump
+	{
+		FString							FileName;
+		FString							Header;
+		TArray<FHitchFrame>				Frames;
+		TArray<FHitchEventRecord>		Events;
+	};
+
+	void WriteDump( const FHitchDump & Dump )
+	{
+		FString Text = Dump.Header;
+
+		Text += TEXT( "\nframe ms" );
+		for( int32 i = 0; i < int32( EHitchEvent::Count ); ++i )
+			Text += FString::Printf( TEXT( " %s" ), EventName( EHitchEvent( i ) ) );
+		for( int32 i = 0; i < int32( EHitchTimer::Count ); ++i )
+			Text += FString::Printf( TEXT( " %sMs/n" ), TimerName( EHitchTimer( i ) ) );
+		Text += TEXT( " reliable saturated\n" );
+
+		for( const FHitchFrame & Frame : Dump.Frames )
+		{
+			Text += FString::Printf( TEXT( "%llu %.2f" ), Frame.FrameNumber, Frame.FrameMs );
+
+			for( int32 i = 0; i < int32( EHitchEvent::Count ); ++i )
+				Text += FString::Printf( TEXT( " %d" ), Frame.Events[ i ] );
+
+			for( int32 i = 0; i < int32( EHitchTimer::Count ); ++i )
+				Text += FString::Printf( TEXT( " %.2f/%d" ), FPlatformTime::ToMilliseconds( Frame.TimerCycles[ i ] ), Frame.TimerCalls[ i ] );
+
+			Text += FString::Printf( TEXT( " %d %d\n" ), Frame.PendingReliable, Frame.SaturatedConnections );
+		}
+
+		Text += TEXT( "\nframe time event actor other\n" );
+
+		for( const FHitchEventRecord & Event : Dump.Events )
+		{
+			Text += FString::Printf( TEXT( "%llu %.3f %s %s %s\n" ), Event.FrameNumber, Event.Time, EventName( Event.Type ),
+									 *Event.Actor.ToString(), Event.Other.IsNone() ? TEXT( "-" ) : *Event.Other.ToString() );
+		}
+
+		if( !FFileHelper::SaveStringToFile( Text, *Dump.FileName ) )
+			UE_LOG( LogTemp, Warning, TEXT( "Hitch watchdog : can not write %s" ), *Dump.FileName );
+	}
+}
+
+TArray<AHitchWatchdog *> AHitchWatchdog::s_Watchdogs;
+
+AHitchWatchdog::AHitchWatchdog() :
+	HitchThresholdMs( 50.f ),
+	HistoryFrames( 120 ),
+	MaxEvents( 512 ),
+	MinDumpInterval( 30.f ),
+	m_FrameHead( 0 ),
+	m_NumFrames( 0 ),
+	m_EventHead( 0 ),
+	m_NumEvents( 0 ),
+	m_FrameStartCycles( 0 ),
+	m_LastDumpTime( -DBL_MAX ),
+	m_NumHitches( 0 ),
+	m_NumDumps( 0 )
+{
+	bReplicates = false;
+
+	/* Frames are closed by world delegates, nothing to tick */
+	PrimaryActorTick.bCanEverTick = false;
+}
+
+AHitchWatchdog * AHitchWatchdog::Get( UWorld * World, bool bSpawnIfMissing )
+{
+	if( !World || World->GetNetMode() == NM_Client )
+		return nullptr;
+
+	for( TActorIterator<AHitchWatchdog> It( World ); It; ++It )
+	{
+		if( !It->IsPendingKill() )
+			return *It;
+	}
+
+	if( !bSpawnIfMissing )
+		return nullptr;
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	SpawnParams.ObjectFlags |= RF_Transient;
+
+	return World->SpawnActor<AHitchWatchdog>( SpawnParams );
+}
+
+AHitchWatchdog * AHitchWatchdog::Find( UWorld * World )
+{
+	if( CVarHitchWatchdog.GetValueOnGameThread() <= 0 )
+		return nullptr;
+
+	for( AHitchWatchdog * Watchdog : s_Watchdogs )
+	{
+		if( Watchdog->GetWorld() == World )
+			return Watchdog;
+	}
+
+	return nullptr;
+}
+
+void AHitchWatchdog::BeginPlay()
+{
+	Super::BeginPlay();
+
+	m_Frames.SetNum( FMath::Max( HistoryFrames, 2 ) );
+	m_Events.SetNum( FMath::Max( MaxEvents, 1 ) );
+
+	s_Watchdogs.Add( this );
+
+	m_TickStartHandle = FWorldDelegates::OnWorldTickStart.AddUObject( this, &AHitchWatchdog::OnWorldTickStart );
+	m_PostTickFlushHandle = GetWorld()->PostTickFlushEvent.AddUObject( this, &AHitchWatchdog::OnPostTickFlush );
+}
+
+void AHitchWatchdog::EndPlay( const EEndPlayReason::Type EndPlayReason )
+{
+	FWorldDelegates::OnWorldTickStart.Remove( m_TickStartHandle );
+	GetWorld()->PostTickFlushEvent.Remove( m_PostTickFlushHandle );
+
+	s_Watchdogs.Remove( this );
+
+	Super::EndPlay( EndPlayReason );
+}
+
+void AHitchWatchdog::OnWorldTickStart( ELevelTick TickType, float DeltaSeconds )
+{
+	/* Delegate is global, every world starts its tick through here */
+	if( GWorld != GetWorld() )
+		return;
+
+	m_FrameStartCycles = FPlatformTime::Cycles();
+
+	FHitchFrame & Frame = CurrentFrame();
+	Frame = FHitchFrame();
+	Frame.FrameNumber = GFrameCounter;
+}
+
+void AHitchWatchdog::OnPostTickFlush( float DeltaSeconds )
+{
+	if( m_FrameStartCycles == 0 || CVarHitchWatchdog.GetValueOnGameThread() <= 0 )
+		return;
+
+	FHitchFrame & Frame = CurrentFrame();
+	Frame.FrameMs = FPlatformTime::ToMilliseconds( FPlatformTime::Cycles() - m_FrameStartCycles );
+	SampleConnections( Frame );
+
+	m_FrameHead = ( m_FrameHead + 1 ) % m_Frames.Num();
+	m_NumFrames = FMath::Min( m_NumFrames + 1, m_Frames.Num() );
+	m_FrameStartCycles = 0;
+
+	if( Frame.FrameMs < HitchThresholdMs )
+		return;
+
+	++m_NumHitches;
+
+	const double Now = FPlatformTime::Seconds();
+	if( Now - m_LastDumpTime < MinDumpInterval )
+		return;
+
+	Dump( FString::Printf( TEXT( "Hitch of %.2f ms on frame %llu, threshold %.1f ms" ), Frame.FrameMs, Frame.FrameNumber, HitchThresholdMs ) );
+}
+
+void AHitchWatchdog::SampleConnections( FHitchFrame & Frame ) const
+{
+	UNetDriver * NetDriver = GetWorld()->GetNetDriver();
+	if( !NetDriver )
+		return;
+
+	for( UNetConnection * Connection : NetDriver->ClientConnections )
+	{
+		if( !Connection )
+			continue;
+
+		for( UChannel * Channel : Connection->OpenChannels )
+			Frame.PendingReliable += Channel ? Channel->NumOutRec : 0;
+
+		Frame.SaturatedConnections += Connection->IsNetReady( false ) ? 0 : 1;
+	}
+}
+
+void AHitchWatchdog::AddEvent( EHitchEvent Type, const AActor * Actor, const AActor * Other )
+{
+	uint16 & Count = CurrentFrame().Events[ int32( Type ) ];
+	Count = Count < MAX_uint16 ? Count + 1 : Count;
+
+	/* Transforms come every frame from every thrower and would push everything else out of the list */
+	if( Type == EHitchEvent::SaberTransform )
+		return;
+
+	FHitchEventRecord & Record = m_Events[ m_EventHead ];
+	Record.FrameNumber = GFrameCounter;
+	Record.Time = GetWorld()->GetTimeSeconds();
+	Record.Type = Type;
+	Record.Actor = Actor ? Actor->GetFName() : NAME_None;
+	Record.Other = Other ? Other->GetFName() : NAME_None;
+
+	m_EventHead = ( m_EventHead + 1 ) % m_Events.Num();
+	m_NumEvents = FMath::Min( m_NumEvents + 1, m_Events.Num() );
+}
+
+void AHitchWatchdog::AddTimer( EHitchTimer Timer, uint32 Cycles )
+{
+	FHitchFrame & Frame = CurrentFrame();
+	Frame.TimerCycles[ int32( Timer ) ] += Cycles;
+	++Frame.TimerCalls[ int32( Timer ) ];
+}
+
+void AHitchWatchdog::Dump( const FString & Reason )
+{
+	m_LastDumpTime = FPlatformTime::Seconds();
+	++m_NumDumps;
+
+	/* Copy oldest to newest on game thread, format and write on a worker so the hitch does not get longer */
+	TSharedPtr<FHitchDump, ESPMode::ThreadSafe> HitchDump = MakeShareable( new FHitchDump() );
+	HitchDump->FileName = FPaths::ProjectLogDir() / FString::Printf( TEXT( "Hitch_%s_%llu.log" ), *GetWorld()->GetName(), GFrameCounter );
+	HitchDump->Header = FString::Printf( TEXT( "%s\nWorld %s, time %.2f, %s\n" ), *Reason, *GetWorld()->GetName(), GetWorld()->GetTimeSeconds(), *FDateTime::Now().ToString() );
+
+	HitchDump->Frames.Reserve( m_NumFrames );
+	for( int32 i = m_NumFrames; i > 0; --i )
+		HitchDump->Frames.Add( m_Frames[ ( m_FrameHead - i + m_Frames.Num() ) % m_Frames.Num() ] );
+
+	HitchDump->Events.Reserve( m_NumEvents );
+	for( int32 i = m_NumEvents; i > 0; --i )
+		HitchDump->Events.Add( m_Events[ ( m_EventHead - i + m_Events.Num() ) % m_Events.Num() ] );
+
+	UE_LOG( LogTemp, Warning, TEXT( "%s, writing %s" ), *Reason, *HitchDump->FileName );
+
+	Async<void>( EAsyncExecution::ThreadPool, [ HitchDump ]() { WriteDump( *HitchDump ); } );
+}
+
+void AHitchWatchdog::LogStats() const
+{
+	float TotalMs = 0.f;
+	float WorstMs = 0.f;
+
+	for( int32 i = 1; i <= m_NumFrames; ++i )
+	{
+		const float FrameMs = m_Frames[ ( m_FrameHead - i + m_Frames.Num() ) % m_Frames.Num() ].FrameMs;
+		TotalMs += FrameMs;
+		WorstMs = FMath::Max( WorstMs, FrameMs );
+	}
+
+	UE_LOG( LogTemp, Display, TEXT( "Hitch watchdog : %d hitches over %.1f ms, %d dumps, last %d frames average %.2f ms, worst %.2f ms" ),
+			m_NumHitches, HitchThresholdMs, m_NumDumps, m_NumFrames, m_NumFrames > 0 ? TotalMs / m_NumFrames : 0.f, WorstMs );
+}
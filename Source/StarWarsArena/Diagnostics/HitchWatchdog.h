@@ -0,0 +1,168 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "HitchWatchdog.generated.h"
+
+/* Combat activity the watchdog counts per frame */
+enum class EHitchEvent : uint8
+{
+	BladeOverlap,
+	BladeClash,
+	SaberLaunch,
+	SaberStop,
+	PlayAttack,
+	StateChange,
+	StatsUpdate,
+	/* Saber transform updates from owning clients, counted but not kept in the event list */
+	SaberTransform,
+	ForcePower,
+	Count
+};
+
+/* Ticks the watchdog times per frame */
+enum class EHitchTimer : uint8
+{
+	Human,
+	Saber,
+	CombatManager,
+	ForcePowers,
+	Bots,
+	Count
+};
+
+/* Counters of one server frame */
+struct FHitchFrame
+{
+	uint64								FrameNumber = 0;
+	float								FrameMs = 0.f;
+	uint16								Events[ int32( EHitchEvent::Count ) ];
+	uint32								TimerCycles[ int32( EHitchTimer::Count ) ];
+	uint16								TimerCalls[ int32( EHitchTimer::Count ) ];
+	/* Reliable bunches sent but not acked yet, summed over client connections */
+	int32								PendingReliable = 0;
+	/* Client connections that could not take more data this frame */
+	int32								SaturatedConnections = 0;
+
+	FHitchFrame()
+	{
+		FMemory::Memzero( Events );
+		FMemory::Memzero( TimerCycles );
+		FMemory::Memzero( TimerCalls );
+	}
+};
+
+/* One combat event, actor names are kept since actors may be gone when the dump is written */
+struct FHitchEventRecord
+{
+	uint64								FrameNumber = 0;
+	float								Time = 0.f;
+	EHitchEvent							Type = EHitchEvent::BladeOverlap;
+	FName								Actor;
+	FName								Other;
+};
+
+/**
+* Per-world server watchdog of slow frames.
+* Keeps the last HistoryFrames frames of combat counters, human, saber and combat manager tick time and pending
+* reliable RPCs, plus the last MaxEvents combat events. A world tick, from its start to the end of net flush,
+* longer than HitchThresholdMs copies all of it and writes Saved/Logs/Hitch_<World>_<Frame>.log on a worker thread.
+* Not spawned on clients, Get returns null there. swa.HitchWatchdog 0 turns it off, swa.HitchDump writes a dump now.
+*/
+UCLASS( NotPlaceable, Transient, Config = Game )
+class STARWARSARENA_API AHitchWatchdog : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	AHitchWatchdog();
+
+	/* Returns watchdog of the world, spawning it on first use. Null on clients */
+	static AHitchWatchdog *				Get( UWorld * World, bool bSpawnIfMissing = true );
+
+	/* Cheap lookup for per event and per tick calls, never spawns. Null if off */
+	static AHitchWatchdog *				Find( UWorld * World );
+
+	void								AddEvent( EHitchEvent Type, const AActor * Actor, const AActor * Other = nullptr );
+
+	void								AddTimer( EHitchTimer Timer, uint32 Cycles );
+
+	/* Writes history to a dump file, Reason goes to its first line */
+	void								Dump( const FString & Reason );
+
+	/* Hitches and dumps so far, average and worst frame of the history */
+	void								LogStats() const;
+
+protected:
+	virtual void						BeginPlay() override;
+
+	virtual void						EndPlay( const EEndPlayReason::Type EndPlayReason ) override;
+
+	UPROPERTY( Config )
+	float								HitchThresholdMs;
+
+	UPROPERTY( Config )
+	int32								HistoryFrames;
+
+	UPROPERTY( Config )
+	int32								MaxEvents;
+
+	/* Seconds between two dumps, a stall of many slow frames writes one file */
+	UPROPERTY( Config )
+	float								MinDumpInterval;
+
+private:
+	void								OnWorldTickStart( ELevelTick TickType, float DeltaSeconds );
+
+	void								OnPostTickFlush( float DeltaSeconds );
+
+	void								SampleConnections( FHitchFrame & Frame ) const;
+
+	FHitchFrame &						CurrentFrame()													{ return m_Frames[ m_FrameHead ]; }
+
+	TArray<FHitchFrame>					m_Frames;
+	/* Frame being recorded, older ones follow it backwards */
+	int32								m_FrameHead;
+	int32								m_NumFrames;
+
+	TArray<FHitchEventRecord>			m_Events;
+	int32								m_EventHead;
+	int32								m_NumEvents;
+
+	uint32								m_FrameStartCycles;
+	double								m_LastDumpTime;
+	int32								m_NumHitches;
+	int32								m_NumDumps;
+
+	FDelegateHandle						m_TickStartHandle;
+	FDelegateHandle						m_PostTickFlushHandle;
+
+	/* Watchdogs of all worlds, so Find does not iterate actors */
+	static TArray<AHitchWatchdog *>		s_Watchdogs;
+};
+
+/* Times the rest of the scope into the world watchdog */
+struct FHitchTimerScope
+{
+	FHitchTimerScope( UWorld * World, EHitchTimer InTimer ) :
+		Watchdog( AHitchWatchdog::Find( World ) ),
+		Timer( InTimer ),
+		StartCycles( Watchdog ? FPlatformTime::Cycles() : 0 )
+	{
+	}
+
+	~FHitchTimerScope()
+	{
+		if( Watchdog )
+			Watchdog->AddTimer( Timer, FPlatformTime::Cycles() - StartCycles );
+	}
+
+	AHitchWatchdog *					Watchdog;
+	EHitchTimer							Timer;
+	uint32								StartCycles;
+};
+
+#define HITCH_TIMER( World, Timer )				FHitchTimerScope HitchTimerScope( World, Timer )
+#define HITCH_EVENT( World, Type, ... )			do { if( AHitchWatchdog * HitchWatchdog = AHitchWatchdog::Find( World ) ) { HitchWatchdog->AddEvent( Type, __VA_ARGS__ ); } } while( 0 )
@@ -3,6 +3,15 @@
 #include "Components/SkeletalMeshComponent.h"
 #include "Components/CapsuleComponent.h"
 #include "Objects/Saber.h"
+#include "Combat/CombatManager.h"
+#include "Combat/CombatSignificance.h"
+#include "Combat/ForcePowers.h"
+#include "Net/NetPacking.h"
+#include "Net/CombatClock.h"
+#include "Diagnostics/HitchWatchdog.h"
+#include "Diagnostics/CombatMemory.h"
+#include "LoadTest/InputScript.h"
+#include "StarWarsArenaGameState.h"
 
 #include "EngineUtils.h"
 
@@ -12,13 +21,16 @@ AHuman::AHuman() :
 	bWaitBeforeJump( false ),
 	bInCombat( false ),
 	m_eState( EHumanState::EHS_Free ),
+	m_eMoveMode( EHumanMoveMode::EHMM_Run ),
 	AnimationCutTime( 0.35f ),
-	StartingStats( 100, 100 ),
-	StatsRestoreSpeed( 0, 10 ),
+	StartingStats( 100, 100, 100 ),
+	StatsRestoreSpeed( 0, 10, 5 ),
 	MaxSaberFlyDistance( 1400 ),
 	bShouldWaitBeforeJump( true ),
 	DelayBeforeJump( 0.1f )
 {
+	COMBAT_LLM_SCOPE( ECombatMemory::Humans );
+
 	bReplicates = true;
 	bReplicateMovement = true;
 
@@ -33,26 +45,59 @@ void AHuman::GetLifetimeReplicatedProps( TArray<FLifetimeProperty> & OutLifetime
 {
 	Super::GetLifetimeReplicatedProps( OutLifetimeProps );
 
-	DOREPLIFETIME( AHuman, m_eState );
-	DOREPLIFETIME( AHuman, m_CurrentStats );
+	DOREPLIFETIME( AHuman, m_CombatSnapshot );
 	DOREPLIFETIME( AHuman, bHoldingAttack );
 	DOREPLIFETIME( AHuman, m_CurrentAttack );
 }
 
+void AHuman::PreReplication( IRepChangedPropertyTracker & ChangedPropertyTracker )
+{
+	m_CombatSnapshot.Stats = m_CurrentStats;
+	m_CombatSnapshot.State = m_eState;
+	m_CombatSnapshot.MoveMode = m_eMoveMode;
+
+	Super::PreReplication( ChangedPropertyTracker );
+}
+
 void AHuman::BeginPlay()
 {
+	COMBAT_LLM_SCOPE( ECombatMemory::Humans );
+
 	Super::BeginPlay();
 
-	m_CurrentStats = StartingStats;
+	SetCurrentStats( StartingStats );
 	UpdateStats( StartingStats );
 
 	SetReplicates( true );
 	SetReplicateMovement( true );
+
+	if( ACombatManager * CombatManager = ACombatManager::Get( GetWorld() ) )
+		CombatManager->RegisterHuman( this );
+
+	if( ACombatSignificanceManager * SignificanceManager = ACombatSignificanceManager::Get( GetWorld() ) )
+		SignificanceManager->RegisterHuman( this );
+}
+
+void AHuman::EndPlay( const EEndPlayReason::Type EndPlayReason )
+{
+	if( ACombatManager * CombatManager = ACombatManager::Get( GetWorld(), false ) )
+		CombatManager->UnregisterHuman( this );
+
+	if( ACombatSignificanceManager * SignificanceManager = ACombatSignificanceManager::Get( GetWorld(), false ) )
+		SignificanceManager->UnregisterHuman( this );
+
+	Super::EndPlay( EndPlayReason );
 }
 
 void AHuman::Tick(float DeltaTime)
 {
+	HITCH_TIMER( GetWorld(), EHitchTimer::Human );
+	COMBAT_LLM_SCOPE( ECombatMemory::Humans );
+
 	Super::Tick(DeltaTime);
+
+	if( Role == ROLE_SimulatedProxy )
+		PlayRemoteEvents();
 	
 	if ( bShouldWaitBeforeJump && bWaitBeforeJump )
 	{
@@ -73,11 +118,15 @@ void AHuman::Tick(float DeltaTime)
 	if( HasAuthority() )
 	{
 		CurrentlyRestoredInteger += DeltaTime * StatsRestoreSpeed.HS_Stamina;
-		if( CurrentlyRestoredInteger >= 1 )
+		CurrentlyRestoredForce += DeltaTime * StatsRestoreSpeed.HS_Force;
+		if( CurrentlyRestoredInteger >= 1 || CurrentlyRestoredForce >= 1 )
 		{
-			Server_UpdateStats( FHumanStats( 0, 1 ) );
+			/* Both restored in one update, the other stat's fraction keeps counting */
+			const FHumanStats Restored( 0, CurrentlyRestoredInteger >= 1 ? 1 : 0, CurrentlyRestoredForce >= 1 ? 1 : 0 );
+			Server_UpdateStats( Restored );
 
-			CurrentlyRestoredInteger = 0.f;
+			CurrentlyRestoredInteger -= Restored.HS_Stamina;
+			CurrentlyRestoredForce -= Restored.HS_Force;
 		}
 	}
 
@@ -97,7 +146,7 @@ void AHuman::Tick(float DeltaTime)
 				}
 				else
 				{
-					m_eState = EHumanState::EHS_Free;
+					SetStateLocal( EHumanState::EHS_Free );
 					m_CurrentAttack = FAttackMontage();
 				}
 
@@ -128,7 +177,7 @@ void AHuman::SetupPlayerInputComponent(UInputComponent* PlayerInputComponent)
 
 	PlayerInputComponent->BindAxis( "MoveForward",						this, &AHuman::MoveForward );
 	PlayerInputComponent->BindAxis( "MoveRight",						this, &AHuman::MoveRight );
-	PlayerInputComponent->BindAxis( "Turn",								this, &AHuman::AddControllerYawInput );
+	PlayerInputComponent->BindAxis( "Turn",								this, &AHuman::Turn );
 	PlayerInputComponent->BindAxis( "LookUp",							this, &AHuman::AddControllerPitchInput );
 
 	PlayerInputComponent->BindAction( "Jump", IE_Pressed,				this, &AHuman::OnJumpStart );
@@ -144,6 +193,10 @@ void AHuman::SetupPlayerInputComponent(UInputComponent* PlayerInputComponent)
 	PlayerInputComponent->BindAction( "ThrowSaber", IE_Pressed,			this, &AHuman::ThrowSaber );
 	PlayerInputComponent->BindAction( "ThrowSaber", IE_Released,		this, &AHuman::StopThrowingSaber );
 
+	PlayerInputComponent->BindAction( "ForcePush", IE_Pressed,			this, &AHuman::ForcePush );
+	PlayerInputComponent->BindAction( "ForcePull", IE_Pressed,			this, &AHuman::ForcePull );
+	PlayerInputComponent->BindAction( "RecallSaber", IE_Pressed,		this, &AHuman::RecallSaber );
+
 	PlayerInputComponent->BindAction( "Defend", IE_Pressed,				this, &AHuman::SwitchDefending );
 	// TODO uncomment - commented for debugging
 	//PlayerInputComponent->BindAction( "Defend", IE_Released,			this, &AHuman::SwitchDefending );
@@ -151,6 +204,8 @@ void AHuman::SetupPlayerInputComponent(UInputComponent* PlayerInputComponent)
 
 void AHuman::MoveForward( float Value )
 {
+	InputScript::Record( this, EScriptedInput::MoveForward, Value );
+
 	if ( !Controller || Value == 0.f )
 		return;
 
@@ -166,6 +221,8 @@ void AHuman::MoveForward( float Value )
 
 void AHuman::MoveRight( float Value )
 {
+	InputScript::Record( this, EScriptedInput::MoveRight, Value );
+
 	if ( !Controller || Value == 0.f )
 		return;
 
@@ -176,19 +233,32 @@ void AHuman::MoveRight( float Value )
 	AddMovementInput( Direction, Value );
 }
 
+void AHuman::Turn( float Value )
+{
+	InputScript::Record( this, EScriptedInput::Turn, Value );
+
+	AddControllerYawInput( Value );
+}
+
 void AHuman::OnJumpStart()
 {
+	InputScript::Record( this, EScriptedInput::Jump );
+
 	bWaitBeforeJump = true;
 }
 
 void AHuman::OnJumpEnd()
 {
+	InputScript::Record( this, EScriptedInput::StopJump );
+
 	bPressedJump = false;
 }
 
 //======================== Movement functions END here ======================//
 void AHuman::ToggleCombat()
 {
+	InputScript::Record( this, EScriptedInput::ToggleCombat );
+
 	if( m_eState != EHumanState::EHS_Free )
 		return;
 
@@ -212,6 +282,8 @@ float AHuman::TakeDamage( float DamageAmount, FDamageEvent const & DamageEvent,
 
 void AHuman::Attack()
 {
+	InputScript::Record( this, EScriptedInput::Attack );
+
 	if ( !bInCombat )
 		return;
 
@@ -228,6 +300,8 @@ void AHuman::Attack()
 
 void AHuman::StopAttack()
 {
+	InputScript::Record( this, EScriptedInput::StopAttack );
+
 	bHoldingAttack = false;
 
 	if( !bInCombat )
@@ -268,8 +342,8 @@ void AHuman::StopAttack()
 bool AHuman::CanPerformAttack( FAttackMontage AttackMont )
 {
 	if( !AttackMont.MontageAnimation ||
-		AttackMont.StaminaRequired > m_CurrentStats.HS_Stamina
-		//AttackMont.ForceRequired > m_CurrentStats.HS_Force
+		AttackMont.StaminaRequired > m_CurrentStats.HS_Stamina ||
+		AttackMont.ForceRequired > m_CurrentStats.HS_Force
 		)
 		return false;
 
@@ -285,14 +359,16 @@ void AHuman::PlayAttack( FAttackMontage AttackToPlay )
 	if( Role < ROLE_Authority )
 		Server_PlayAttack( AttackToPlay );
 	else
-		Multicast_PlayAttack( AttackToPlay );	
+		Multicast_PlayAttack( AttackToPlay, UCombatClockComponent::GetServerTime( GetWorld() ) );
 
-	Server_UpdateStats( FHumanStats( 0, -AttackToPlay.StaminaRequired ) );
+	Server_UpdateStats( FHumanStats( 0, -AttackToPlay.StaminaRequired, -AttackToPlay.ForceRequired ) );
 }
 
 void AHuman::Server_PlayAttack_Implementation( FAttackMontage Mont )
 {
-	Multicast_PlayAttack( Mont );
+	HITCH_EVENT( GetWorld(), EHitchEvent::PlayAttack, this );
+
+	Multicast_PlayAttack( Mont, UCombatClockComponent::GetServerTime( GetWorld() ) );
 }
 
 bool AHuman::Server_PlayAttack_Validate( FAttackMontage Mont ) 
@@ -306,18 +382,39 @@ bool AHuman::Server_PlayAttack_Validate( FAttackMontage Mont )
 	return true;
 }
 
-void AHuman::Multicast_PlayAttack_Implementation( FAttackMontage AttackToPlay )
+void AHuman::Multicast_PlayAttack_Implementation( FAttackMontage AttackToPlay, double ServerTime )
 {
-	/* Set duration of currently played attack for counting to end */
 	if( !AttackToPlay.MontageAnimation )
 		return;
-	
+
+	if( ShouldBufferRemoteEvents() )
+	{
+		FRemoteCombatEvent Event;
+		Event.bAttack = true;
+		Event.Attack = AttackToPlay;
+		m_RemoteEvents.Push( ServerTime, Event );
+		return;
+	}
+
+	ApplyAttack( AttackToPlay );
+}
+
+void AHuman::ApplyAttack( const FAttackMontage & AttackToPlay )
+{
+	/* Set duration of currently played attack for counting to end */
 	m_CurrentAttack = AttackToPlay;
 	m_fFirstPress = m_fSecondPress = 0.f;
 	m_CurAttackLengthCounter = GetMesh()->GetAnimInstance()->Montage_Play( AttackToPlay.MontageAnimation, AttackToPlay.PlayRate, EMontagePlayReturnType::Duration );
+
+	if( m_Saber )
+		m_Saber->PlaySaberSound( ESaberSoundCategory::ESSC_Swing );
+
+	COMBAT_DEBUG( GetWorld(), AddLabel( ECombatDebugCategory::HitWindow, GetActorLocation() + FVector( 0.f, 0.f, 140.f ),
+										FString::Printf( TEXT( "%s %.2fs" ), *AttackToPlay.MontageAnimation->GetName(), m_CurAttackLengthCounter ),
+										FColor::Red, m_CurAttackLengthCounter ) );
 }
 
-bool AHuman::Multicast_PlayAttack_Validate( FAttackMontage Mont ) 
+bool AHuman::Multicast_PlayAttack_Validate( FAttackMontage Mont, double ServerTime ) 
 { 
 	if( //m_CurrentStats.HS_Health <= 0 ||
 		//m_CurrentStats.HS_Stamina <= Mont.StaminaRequired ||
@@ -342,6 +439,9 @@ void AHuman::OnAttackDefendingEnemy( AHuman * Enemy )
 
 	Enemy->UpdateStats( FHumanStats( 0, -m_CurrentAttack.StaminaRequired ) );
 
+	if( AStarWarsArenaGameState * GameState = AStarWarsArenaGameState::Get( GetWorld() ) )
+		GameState->RecordBlock( this, Enemy );
+
 	GetMesh()->GetAnimInstance()->Montage_Stop
 	( 
 		m_CurrentAttack.MontageAnimation->BlendOut.GetBlendTime(),
@@ -352,6 +452,9 @@ void AHuman::OnAttackDefendingEnemy( AHuman * Enemy )
 
 void AHuman::OnAttackAttackingEnemy( AHuman * Enemy )
 {
+	if( AStarWarsArenaGameState * GameState = AStarWarsArenaGameState::Get( GetWorld() ) )
+		GameState->RecordClash( this, Enemy );
+
 	/* Set impact state and timer to character with weaker attack */
 	FAttackMontage EnemyAttack = Enemy->GetCurrentlyPlayingAttack();
 	float ImpactLength = ( EnemyAttack.StaminaRequired - m_CurrentAttack.StaminaRequired ) / StartingStats.HS_Health * MaxImpactTime;
@@ -398,6 +501,8 @@ void AHuman::PlayCurrentAttackInReverse()
 
 void AHuman::ThrowSaber()
 {
+	InputScript::Record( this, EScriptedInput::Throw );
+
 	bHoldingThrow = true;
 
 	SetState( EHumanState::EHS_ThrowingSaber );
@@ -410,6 +515,8 @@ void AHuman::ThrowSaber()
 
 void AHuman::StopThrowingSaber()
 {
+	InputScript::Record( this, EScriptedInput::StopThrow );
+
 	bHoldingThrow = false;
 
 	if( m_Saber )
@@ -420,8 +527,74 @@ void AHuman::StopThrowingSaber()
 	fTimeHoldingThrow = 0.f;
 }
 
+void AHuman::ForcePush()
+{
+	InputScript::Record( this, EScriptedInput::ForcePush );
+
+	UseForcePower( EForcePower::EFP_Push );
+}
+
+void AHuman::ForcePull()
+{
+	InputScript::Record( this, EScriptedInput::ForcePull );
+
+	UseForcePower( EForcePower::EFP_Pull );
+}
+
+void AHuman::RecallSaber()
+{
+	InputScript::Record( this, EScriptedInput::RecallSaber );
+
+	UseForcePower( EForcePower::EFP_Recall );
+}
+
+bool AHuman::CanUseForcePower( EForcePower Power )
+{
+	if( AForcePowerManager::GetForceCost( Power ) > m_CurrentStats.HS_Force )
+		return false;
+
+	if( Power == EForcePower::EFP_Recall )
+		return m_Saber && m_Saber->IsThrown();
+
+	return m_eState == EHumanState::EHS_Free || m_eState == EHumanState::EHS_Defending || m_eState == EHumanState::EHS_ThrowingSaber;
+}
+
+void AHuman::UseForcePower( EForcePower Power )
+{
+	if( !CanUseForcePower( Power ) )
+		return;
+
+	if( HasAuthority() )
+		Server_UseForcePower_Implementation( Power );
+	else
+		Server_UseForcePower( Power );
+}
+
+void AHuman::Server_UseForcePower_Implementation( EForcePower Power )
+{
+	HITCH_EVENT( GetWorld(), EHitchEvent::ForcePower, this );
+
+	/* Client checked with stats that may be behind */
+	if( !CanUseForcePower( Power ) )
+		return;
+
+	SetCurrentStats( m_CurrentStats.Add( FHumanStats( 0, 0, -AForcePowerManager::GetForceCost( Power ) ), StartingStats ) );
+
+	Multicast_UseForcePower( Power, GetActorLocation(), GetControlRotation().Vector() );
+}
+
+void AHuman::Multicast_UseForcePower_Implementation( EForcePower Power, FVector Origin, FVector Direction )
+{
+	if( AForcePowerManager * ForcePowerManager = AForcePowerManager::Get( GetWorld() ) )
+		ForcePowerManager->RequestPower( this, Power, Origin, Direction );
+
+	OnForcePower( Power );
+}
+
 void AHuman::SwitchDefending()
 {
+	InputScript::Record( this, EScriptedInput::Defend );
+
 	if( !bInCombat )
 		return;
 
@@ -431,32 +604,37 @@ void AHuman::SwitchDefending()
 	{
 		SetState( EHumanState::EHS_Defending );
 		StatsRestoreSpeed.HS_Stamina = StaminaRestoreWhileDefending;
-		SetMaxWalkSpeed( WalkSpeed );
+		SetMoveMode( EHumanMoveMode::EHMM_Walk );
 	}
 	else if( !bHoldingDefend && m_eState == EHumanState::EHS_Defending )
 	{
 		SetState( EHumanState::EHS_Free );
 		StatsRestoreSpeed.HS_Stamina = FreeStaminaRestoreSpeed;
-		SetMaxWalkSpeed( RunSpeed );
+		SetMoveMode( EHumanMoveMode::EHMM_Run );
 	}
 }
 
-void AHuman::SetMaxWalkSpeed( float NewSpeed )
+void AHuman::SetMoveMode( EHumanMoveMode NewMode )
 {
-	if( HasAuthority() )
-		Multicast_SetWalkSpeed( NewSpeed );
-	else
-		Server_SetWalkSpeed( NewSpeed );
+	/* Owning client moves with the new speed right away, so its moves agree with server's once it gets the RPC */
+	SetMoveModeLocal( NewMode );
+
+	if( !HasAuthority() )
+		Server_SetMoveMode( NewMode );
 }
 
-void AHuman::Server_SetWalkSpeed_Implementation( float NewSpeed )
+void AHuman::Server_SetMoveMode_Implementation( EHumanMoveMode NewMode )
 {
-	Multicast_SetWalkSpeed( NewSpeed );
+	SetMoveModeLocal( NewMode );
 }
 
-void AHuman::Multicast_SetWalkSpeed_Implementation( float NewSpeed )
+void AHuman::SetMoveModeLocal( EHumanMoveMode NewMode )
 {
-	GetCharacterMovement()->MaxWalkSpeed = NewSpeed;
+	if( NewMode == m_eMoveMode )
+		return;
+
+	m_eMoveMode = NewMode;
+	GetCharacterMovement()->MaxWalkSpeed = NewMode == EHumanMoveMode::EHMM_Walk ? WalkSpeed : RunSpeed;
 }
 
 void AHuman::SetState( EHumanState NewState )
@@ -469,12 +647,14 @@ void AHuman::SetState( EHumanState NewState )
 	if( Role < ROLE_Authority )
 		Server_SetState( NewState );
 	else
-		Multicast_SetState( NewState );
+		Multicast_SetState( NewState, UCombatClockComponent::GetServerTime( GetWorld() ) );
 }
 
 void AHuman::Server_SetState_Implementation( EHumanState NewState )
 {
-	Multicast_SetState( NewState );
+	HITCH_EVENT( GetWorld(), EHitchEvent::StateChange, this );
+
+	Multicast_SetState( NewState, UCombatClockComponent::GetServerTime( GetWorld() ) );
 }
 
 bool AHuman::Server_SetState_Validate( EHumanState NewState )
@@ -482,7 +662,63 @@ bool AHuman::Server_SetState_Validate( EHumanState NewState )
 	return true;
 }
 
-void AHuman::Multicast_SetState_Implementation( EHumanState NewState )
+void AHuman::Multicast_SetState_Implementation( EHumanState NewState, double ServerTime )
+{
+	if( ShouldBufferRemoteEvents() )
+	{
+		FRemoteCombatEvent Event;
+		Event.State = NewState;
+		m_RemoteEvents.Push( ServerTime, Event );
+		return;
+	}
+
+	ApplyState( NewState );
+}
+
+void AHuman::ApplyState( EHumanState NewState )
+{
+	if( NewState == m_eState )
+		return;
+
+#if ENABLE_COMBAT_DEBUG
+	static const UEnum * StateEnum = FindObject<UEnum>( ANY_PACKAGE, TEXT( "EHumanState" ) );
+	COMBAT_DEBUG( GetWorld(), AddLabel( ECombatDebugCategory::State, GetActorLocation() + FVector( 0.f, 0.f, 125.f ),
+										FString::Printf( TEXT( "%s: %s -> %s" ), *GetName(),
+														 StateEnum ? *StateEnum->GetNameStringByValue( int64( m_eState ) ) : TEXT( "?" ),
+														 StateEnum ? *StateEnum->GetNameStringByValue( int64( NewState ) ) : TEXT( "?" ) ),
+										FColor::Yellow, 2.f ) );
+#endif
+
+	SetStateLocal( NewState );
+}
+
+bool AHuman::ShouldBufferRemoteEvents() const
+{
+	return Role == ROLE_SimulatedProxy && CombatInterpolation::IsActive( GetWorld() );
+}
+
+void AHuman::PlayRemoteEvents()
+{
+	if( m_RemoteEvents.IsEmpty() )
+		return;
+
+	const double RenderTime = ShouldBufferRemoteEvents() ? CombatInterpolation::GetRenderTime( GetWorld() ) : MAX_dbl;
+
+	FRemoteCombatEvent Event;
+	while( m_RemoteEvents.PopDue( RenderTime, Event ) )
+	{
+		if( Event.bAttack )
+			ApplyAttack( Event.Attack );
+		else
+			ApplyState( Event.State );
+	}
+
+	/* Snapshot state was held back while events were queued */
+	if( m_RemoteEvents.IsEmpty() )
+		SetStateLocal( m_CombatSnapshot.State );
+}
+
+void AHuman::SetStateLocal( EHumanState NewState )
 {
 	if( NewState == m_eState )
 		return;
@@ -490,45 +726,90 @@ void AHuman::Multicast_SetState_Implementation( EHumanState NewState )
 	m_eState = NewState;
 
 	OnChangeState( m_eState );
+	OnStateChanged.Broadcast( this, m_eState );
 }
 
-bool AHuman::Multicast_SetState_Validate( EHumanState NewState )
+
+bool AHuman::Multicast_SetState_Validate( EHumanState NewState, double ServerTime )
 {
 	return true;
 }
 
-void AHuman::PutSaberInBelt()
+void AHuman::ResetForRound( const FTransform & StartTransform )
 {
 	if( HasAuthority() )
-		Multicast_PutSaberInSlot( FName( "SaberBelt" ) );
-	else
-		Server_PutSaberInSlot( FName( "SaberBelt" ) );
+		Multicast_ResetForRound( StartTransform );
+}
+
+void AHuman::Multicast_ResetForRound_Implementation( FTransform StartTransform )
+{
+	if( UAnimInstance * AnimInstance = GetMesh()->GetAnimInstance() )
+		AnimInstance->Montage_Stop( 0.f );
+
+	GetWorldTimerManager().ClearAllTimersForObject( this );
+
+	/* Input and attack bookkeeping */
+	bHoldingAttack = bHoldingThrow = bHoldingDefend = false;
+	/* Released defend, as SwitchDefending does it */
+	StatsRestoreSpeed.HS_Stamina = FreeStaminaRestoreSpeed;
+	fTimeHoldingAttack = fTimeHoldingThrow = 0.f;
+	CurrentJumpTimer = 0.f;
+	bWaitBeforeJump = false;
+	m_fFirstPress = m_fSecondPress = 0.f;
+	m_CurAttackLengthCounter = 0.f;
+	m_CurrentImpactCounter = 0.f;
+	CurrentlyRestoredInteger = CurrentlyRestoredForce = 0.f;
+	m_CurrentAttack = FAttackMontage();
+	m_RemoteEvents.Reset();
+	bInCombat = false;
+
+	SetStateLocal( EHumanState::EHS_Free );
+	SetCurrentStats( StartingStats );
+
+	GetCharacterMovement()->StopMovementImmediately();
+	SetActorLocationAndRotation( StartTransform.GetLocation(), StartTransform.GetRotation(), false, nullptr, ETeleportType::TeleportPhysics );
+
+	if( Controller )
+		Controller->SetControlRotation( StartTransform.Rotator() );
+
+	SetMoveModeLocal( EHumanMoveMode::EHMM_Run );
+
+	if( m_Saber )
+	{
+		m_Saber->ResetForRound();
+		m_Saber->SetAttachment( ESaberAttachment::ESA_Belt );
+	}
+
+	OnRoundReset();
+}
+
+void AHuman::PutSaberInBelt()
+{
+	PutSaberInSlot( ESaberAttachment::ESA_Belt );
 }
 
 void AHuman::PutSaberInHand()
 {
-	if( HasAuthority() )
-		Multicast_PutSaberInSlot( FName( "SaberHand" ) );
-	else
-		Server_PutSaberInSlot( FName( "SaberHand" ) );
+	PutSaberInSlot( ESaberAttachment::ESA_Hand );
 }
 
-void AHuman::Server_PutSaberInSlot_Implementation( FName SlotName )
+void AHuman::PutSaberInSlot( ESaberAttachment Attachment )
 {
-	Multicast_PutSaberInSlot( SlotName );
+	if( HasAuthority() )
+		Server_PutSaberInSlot_Implementation( Attachment );
+	else
+		Server_PutSaberInSlot( Attachment );
 }
 
-void AHuman::Multicast_PutSaberInSlot_Implementation( FName SlotName )
+void AHuman::Server_PutSaberInSlot_Implementation( ESaberAttachment Attachment )
 {
 	if( !m_Saber )
 	{
-		UE_LOG( LogTemp, Error, TEXT( "%s tried to put NULL saber in slot %s." ), *GetName(), *SlotName.ToString() );
+		UE_LOG( LogTemp, Error, TEXT( "%s tried to put NULL saber in slot %d." ), *GetName(), int32( Attachment ) );
 		return;
 	}
-	
-	FAttachmentTransformRules Rules( EAttachmentRule::SnapToTarget, true );
 
-	m_Saber->AttachToComponent( GetMesh(), Rules, SlotName );
+	m_Saber->SetAttachment( Attachment );
 }
 
 void AHuman::UpdateStats( FHumanStats DeltaStats )
@@ -545,8 +826,10 @@ void AHuman::UpdateStats( FHumanStats DeltaStats )
 
 void AHuman::Server_UpdateStats_Implementation( FHumanStats DeltaStats )
 {
+	HITCH_EVENT( GetWorld(), EHitchEvent::StatsUpdate, this );
+
 	//Multicast_UpdateStats( DeltaStats );
-	m_CurrentStats = m_CurrentStats.Add( DeltaStats, StartingStats );
+	SetCurrentStats( m_CurrentStats.Add( DeltaStats, StartingStats ) );
 	if( DeltaStats.HS_Stamina > 1 )
 		UE_LOG( LogTemp, Warning, TEXT( "Running updatestats Server. DeltaStamina is %d" ), DeltaStats.HS_Stamina );
 }
@@ -558,7 +841,7 @@ bool AHuman::Server_UpdateStats_Validate( FHumanStats DeltaStats )
 
 void AHuman::Multicast_UpdateStats_Implementation( FHumanStats DeltaStats )
 {
-	m_CurrentStats = m_CurrentStats.Add( DeltaStats, StartingStats );
+	SetCurrentStats( m_CurrentStats.Add( DeltaStats, StartingStats ) );
 	if( DeltaStats.HS_Stamina > 1 )
 		UE_LOG( LogTemp, Warning, TEXT( "Running updatestats Multicasted. DeltaStamina is %d" ), DeltaStats.HS_Stamina );
 }
@@ -566,4 +849,63 @@ void AHuman::Multicast_UpdateStats_Implementation( FHumanStats DeltaStats )
 bool AHuman::Multicast_UpdateStats_Validate( FHumanStats DeltaStats )
 {
 	return true;
-}
\ No newline at end of file
+}
+
+void AHuman::SetCurrentStats( const FHumanStats & NewStats )
+{
+	if( NewStats == m_CurrentStats )
+		return;
+
+	m_CurrentStats = NewStats;
+
+	OnStatsChanged.Broadcast( this, m_CurrentStats );
+}
+
+void AHuman::OnRep_CombatSnapshot()
+{
+	/* State may have arrived already through Multicast_SetState, setters only broadcast real changes.
+	Snapshot would overtake buffered remote events, their queue sets its state once drained */
+	SetCurrentStats( m_CombatSnapshot.Stats );
+	if( m_RemoteEvents.IsEmpty() )
+		SetStateLocal( m_CombatSnapshot.State );
+
+	/* Owner applies walk and run itself, a snapshot sent before its Server_SetMoveMode landed would undo it */
+	if( !IsLocallyControlled() )
+		SetMoveModeLocal( m_CombatSnapshot.MoveMode );
+}
+
+bool FHumanStats::NetSerialize( FArchive & Ar, UPackageMap * Map, bool & bOutSuccess )
+{
+	int32 NumBits = NetPacking::SerializeStat( Ar, HS_Health );
+	NumBits += NetPacking::SerializeStat( Ar, HS_Stamina );
+	NumBits += NetPacking::SerializeStat( Ar, HS_Force );
+
+	if( Ar.IsSaving() )
+		NetPacking::RecordWrite( ENetPackedProperty::HumanStats, NumBits, 3 * 32 );
+
+	bOutSuccess = true;
+	return true;
+}
+
+bool FHumanCombatSnapshot::NetSerialize( FArchive & Ar, UPackageMap * Map, bool & bOutSuccess )
+{
+	int32 NumBits = NetPacking::SerializeStat( Ar, Stats.HS_Health );
+	NumBits += NetPacking::SerializeStat( Ar, Stats.HS_Stamina );
+	NumBits += NetPacking::SerializeStat( Ar, Stats.HS_Force );
+
+	uint32 PackedState = uint32( State );
+	Ar.SerializeInt( PackedState, 16 );
+	State = EHumanState( PackedState );
+	NumBits += 4;
+
+	uint8 bWalk = MoveMode == EHumanMoveMode::EHMM_Walk;
+	Ar.SerializeBits( &bWalk, 1 );
+	MoveMode = bWalk ? EHumanMoveMode::EHMM_Walk : EHumanMoveMode::EHMM_Run;
+	NumBits += 1;
+
+	if( Ar.IsSaving() )
+		NetPacking::RecordWrite( ENetPackedProperty::HumanSnapshot, NumBits, 3 * 32 + 8 + 8 );
+
+	bOutSuccess = true;
+	return true;
+}
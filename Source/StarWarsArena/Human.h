@@ -6,6 +6,9 @@
 #include "Engine.h"
 #include "UnrealNetwork.h"
 #include "MoveSet.h"
+#include "Objects/Saber.h"
+#include "Net/CombatInterpolation.h"
+#include "Combat/ForcePowers.h"
 #include "Human.generated.h"
 
 class ASaber;
@@ -13,7 +16,7 @@ class UCharacterMovementComponent;
 class UCapsuleComponent;
 
 USTRUCT( BlueprintType )
-struct FHumanStats
+struct STARWARSARENA_API FHumanStats
 {
 	GENERATED_BODY()
 
@@ -23,27 +26,56 @@ struct FHumanStats
 	UPROPERTY( EditDefaultsOnly, BlueprintReadWrite, meta = ( DisplayName = "Stamina" ) )
 	int32 HS_Stamina;
 
+	/* Spent by force powers and attacks with ForceRequired */
+	UPROPERTY( EditDefaultsOnly, BlueprintReadWrite, meta = ( DisplayName = "Force" ) )
+	int32 HS_Force;
+
 	FHumanStats()
 	{
-		HS_Health = HS_Stamina = 0;
+		HS_Health = HS_Stamina = HS_Force = 0;
 	}
 
-	FHumanStats( int32 Health, int32 Stamina )
+	FHumanStats( int32 Health, int32 Stamina, int32 Force = 0 )
 	{
 		HS_Health = Health;
 		HS_Stamina = Stamina;
+		HS_Force = Force;
 	}
 
 	FHumanStats( int32 NewStat )
 	{
-		HS_Health = HS_Stamina = NewStat;
+		HS_Health = HS_Stamina = HS_Force = NewStat;
 	}
 
 	FHumanStats Add( FHumanStats other, FHumanStats MaxStats )
 	{
 		return FHumanStats( FMath::Clamp( HS_Health + other.HS_Health, 0, MaxStats.HS_Health ),
-							FMath::Clamp( HS_Stamina + other.HS_Stamina, 0, MaxStats.HS_Stamina ) );
+							FMath::Clamp( HS_Stamina + other.HS_Stamina, 0, MaxStats.HS_Stamina ),
+							FMath::Clamp( HS_Force + other.HS_Force, 0, MaxStats.HS_Force ) );
+	}
+
+	bool operator==( const FHumanStats & other ) const
+	{
+		return HS_Health == other.HS_Health && HS_Stamina == other.HS_Stamina && HS_Force == other.HS_Force;
+	}
+
+	bool operator!=( const FHumanStats & other ) const
+	{
+		return !( *this == other );
 	}
+
+	/* Stats are 0..100 almost always: 8 bits each instead of 32. Deltas sent through RPCs may be negative */
+	bool NetSerialize( FArchive & Ar, UPackageMap * Map, bool & bOutSuccess );
+};
+
+template<>
+struct TStructOpsTypeTraits<FHumanStats> : public TStructOpsTypeTraitsBase2<FHumanStats>
+{
+	enum
+	{
+		WithNetSerializer = true,
+		WithIdenticalViaEquality = true
+	};
 };
 
 UENUM( BlueprintType )
@@ -59,6 +91,54 @@ enum class EHumanState : uint8
 	EHS_ThrowingSaber	UMETA( DisplayName = "ThrowingSaber" ) // While throwing saber or waiting until it returns from flight
 };
 
+/* Which max walk speed the movement component uses */
+UENUM( BlueprintType )
+enum class EHumanMoveMode : uint8
+{
+	EHMM_Run			UMETA( DisplayName = "Run" ),	// RunSpeed, default
+	EHMM_Walk			UMETA( DisplayName = "Walk" )	// WalkSpeed, while defending
+};
+
+/* Replicated combat state of a human, sent as one unit whenever any part changes */
+USTRUCT()
+struct STARWARSARENA_API FHumanCombatSnapshot
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	FHumanStats Stats;
+
+	UPROPERTY()
+	EHumanState State = EHumanState::EHS_Free;
+
+	UPROPERTY()
+	EHumanMoveMode MoveMode = EHumanMoveMode::EHMM_Run;
+
+	bool operator==( const FHumanCombatSnapshot & other ) const
+	{
+		return Stats == other.Stats && State == other.State && MoveMode == other.MoveMode;
+	}
+
+	/* Stats packed as in FHumanStats, state in 4 bits, move mode in 1 */
+	bool NetSerialize( FArchive & Ar, UPackageMap * Map, bool & bOutSuccess );
+};
+
+template<>
+struct TStructOpsTypeTraits<FHumanCombatSnapshot> : public TStructOpsTypeTraitsBase2<FHumanCombatSnapshot>
+{
+	enum
+	{
+		WithNetSerializer = true,
+		WithIdenticalViaEquality = true
+	};
+};
+
+class AHuman;
+
+/* Broadcast on server and clients when replicated stats or state actually change */
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams( FOnHumanStatsChanged, AHuman *, Human, const FHumanStats &, NewStats );
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams( FOnHumanStateChanged, AHuman *, Human, EHumanState, NewState );
+
 UCLASS()
 class STARWARSARENA_API AHuman : public ACharacter
 {
@@ -66,6 +146,7 @@ class STARWARSARENA_API AHuman : public ACharacter
 
 protected:
 	virtual void					BeginPlay() override;
+	virtual void					EndPlay( const EEndPlayReason::Type EndPlayReason ) override;
 
 
 	UPROPERTY( BlueprintReadWrite, EditAnywhere, Category = "Moving", Meta = ( DisplayName = "RunSpeed" ) )
@@ -139,11 +220,18 @@ protected:
 	/* Called when player changes state (from free to attacking, from ChangingCombat to Free, etc) */
 	UFUNCTION( BlueprintImplementableEvent, Category = "Human", Meta = ( DisplayName = "OnChangeState" ) )
 	void							OnChangeState( EHumanState NewState );
+
+	/* Called on all machines when server accepted a force power, its targets are moved a frame or two later */
+	UFUNCTION( BlueprintImplementableEvent, Category = "Human", Meta = ( DisplayName = "OnForcePower" ) )
+	void							OnForcePower( EForcePower Power );
 public:
 									AHuman();
 
 	virtual void					GetLifetimeReplicatedProps( TArray<FLifetimeProperty>& OutLifetimeProps ) const override;
 
+	/* Server copies stats and state into the combat snapshot */
+	virtual void					PreReplication( IRepChangedPropertyTracker & ChangedPropertyTracker ) override;
+
 	virtual void					Tick(float DeltaTime) override;
 
 	virtual void					SetupPlayerInputComponent(class UInputComponent* PlayerInputComponent) override;
@@ -157,6 +245,18 @@ public:
 	UFUNCTION( BlueprintPure, Category = "Human", Meta = ( DisplayName = "GetCurrentStats" ) )
 	FHumanStats						GetCurrentStats()																			{ return m_CurrentStats; }
 
+	/* Stats human starts with, current stats never exceed them */
+	UFUNCTION( BlueprintPure, Category = "Human", Meta = ( DisplayName = "GetMaxStats" ) )
+	FHumanStats						GetMaxStats()																				{ return StartingStats; }
+
+	UPROPERTY( BlueprintAssignable, Category = "Human", Meta = ( DisplayName = "OnStatsChanged" ) )
+	FOnHumanStatsChanged			OnStatsChanged;
+
+	UPROPERTY( BlueprintAssignable, Category = "Human", Meta = ( DisplayName = "OnStateChanged" ) )
+	FOnHumanStateChanged			OnStateChanged;
+
+	UMoveSet *						GetMoveSet() const																			{ return MoveSet; }
+
 	UFUNCTION( BlueprintPure, Category = "Human", Meta = ( DisplayName = "GetCurrentlyPlayingAttack" ) )
 	FAttackMontage					GetCurrentlyPlayingAttack()																	{ return m_CurrentAttack; }
 
@@ -206,12 +306,26 @@ public:
 	/* Returns if player has enough stamina, force, checks nullptr */
 	UFUNCTION( BlueprintCallable, Category = "Human", Meta = ( DisplayName = "CanPerformAttack" ) )
 	bool							CanPerformAttack( FAttackMontage AttackMont );
-private:
+
+	/* Returns if player has enough force and is free to use the power. Recall also needs a thrown saber */
+	UFUNCTION( BlueprintCallable, Category = "Human", Meta = ( DisplayName = "CanUseForcePower" ) )
+	bool							CanUseForcePower( EForcePower Power );
+
+	/* Server only. Puts human back to round start state at StartTransform on all machines, keeping actor and its channel */
+	void							ResetForRound( const FTransform & StartTransform );
+
+	/* Called on all machines after human was reset for a new round */
+	UFUNCTION( BlueprintImplementableEvent, Category = "Human", Meta = ( DisplayName = "OnRoundReset" ) )
+	void							OnRoundReset();
+
+	/* Input handlers. Public so scripted drivers ( load test clients, bots ) press the same paths as a player */
 	UFUNCTION()
 	void							MoveForward( float Value );
 	UFUNCTION()
 	void							MoveRight( float Value );
 	UFUNCTION()
+	void							Turn( float Value );
+	UFUNCTION()
 	void							OnJumpStart();
 	UFUNCTION()
 	void							OnJumpEnd();
@@ -229,7 +343,14 @@ private:
 	UFUNCTION()
 	void							StopThrowingSaber();
 
-	protected:
+	UFUNCTION()
+	void							ForcePush();
+	UFUNCTION()
+	void							ForcePull();
+	UFUNCTION()
+	void							RecallSaber();
+
+protected:
 	/// Saber variables
 	ASaber *						m_Saber;
 	UPROPERTY( Replicated )
@@ -258,10 +379,11 @@ private:
 	void							Server_UpdateStats_Implementation( FHumanStats DeltaStats );
 	bool							Server_UpdateStats_Validate( FHumanStats DeltaStats );
 
+	/* ServerTime is combat clock time of the change, remote proxies play it at interpolation render time */
 	UFUNCTION( NetMulticast, Reliable, WithValidation )
-	void							Multicast_SetState( EHumanState NewState );
-	void							Multicast_SetState_Implementation( EHumanState NewState );
-	bool							Multicast_SetState_Validate( EHumanState NewState );
+	void							Multicast_SetState( EHumanState NewState, double ServerTime );
+	void							Multicast_SetState_Implementation( EHumanState NewState, double ServerTime );
+	bool							Multicast_SetState_Validate( EHumanState NewState, double ServerTime );
 	
 	UFUNCTION( Server, Reliable, WithValidation )
 	void							Server_SetState( EHumanState NewState );
@@ -270,9 +392,9 @@ private:
 	/// Attack ( including network ) functions
 	/* This function if ran on server promote it to all connections */
 	UFUNCTION( NetMulticast, Reliable, WithValidation )
-	void							Multicast_PlayAttack( FAttackMontage Mont );
-	void							Multicast_PlayAttack_Implementation( FAttackMontage Mont );
-	bool							Multicast_PlayAttack_Validate( FAttackMontage Mont );
+	void							Multicast_PlayAttack( FAttackMontage Mont, double ServerTime );
+	void							Multicast_PlayAttack_Implementation( FAttackMontage Mont, double ServerTime );
+	bool							Multicast_PlayAttack_Validate( FAttackMontage Mont, double ServerTime );
 	
 	/* This function runs on server side */
 	UFUNCTION( Server, Reliable, WithValidation )
@@ -280,33 +402,72 @@ private:
 	void							Server_PlayAttack_Implementation( FAttackMontage Mont );
 	bool							Server_PlayAttack_Validate( FAttackMontage Mont );
 							
-	/* Putting saber in slots */
-	UFUNCTION( NetMulticast, Reliable, WithValidation )
-	void							Multicast_PutSaberInSlot( FName SlotName );
-	void							Multicast_PutSaberInSlot_Implementation( FName SlotName );
-	bool							Multicast_PutSaberInSlot_Validate( FName SlotName ) { return true;  }
+	/* Putting saber in slots. Server sets saber attachment, which replicates with saber state */
+	void							PutSaberInSlot( ESaberAttachment Attachment );
 
 	UFUNCTION( Server, Reliable, WithValidation )
-	void							Server_PutSaberInSlot( FName SlotName );
-	void							Server_PutSaberInSlot_Implementation( FName SlotName );
-	bool							Server_PutSaberInSlot_Validate( FName SlotName ) { return true;  }
+	void							Server_PutSaberInSlot( ESaberAttachment Attachment );
+	void							Server_PutSaberInSlot_Implementation( ESaberAttachment Attachment );
+	bool							Server_PutSaberInSlot_Validate( ESaberAttachment Attachment ) { return true;  }
 
-	void SetMaxWalkSpeed( float NewSpeed );
+	UFUNCTION( NetMulticast, Reliable )
+	void							Multicast_ResetForRound( FTransform StartTransform );
+	void							Multicast_ResetForRound_Implementation( FTransform StartTransform );
 
-	UFUNCTION( NetMulticast, Reliable, WithValidation )
-	void							Multicast_SetWalkSpeed( float NewSpeed );
-	void							Multicast_SetWalkSpeed_Implementation( float NewSpeed );
-	bool							Multicast_SetWalkSpeed_Validate( float NewSpeed ) { return true; }
+	/* Owning client asks server, which spends force and sends the power to every machine's AForcePowerManager */
+	void							UseForcePower( EForcePower Power );
+
+	UFUNCTION( Server, Reliable, WithValidation )
+	void							Server_UseForcePower( EForcePower Power );
+	void							Server_UseForcePower_Implementation( EForcePower Power );
+	bool							Server_UseForcePower_Validate( EForcePower Power ) { return true; }
+
+	/* Origin and aim are server's, so every machine queries the same volume */
+	UFUNCTION( NetMulticast, Reliable )
+	void							Multicast_UseForcePower( EForcePower Power, FVector Origin, FVector Direction );
+	void							Multicast_UseForcePower_Implementation( EForcePower Power, FVector Origin, FVector Direction );
+
+	/* Applies move mode at once, owning client asks server which replicates it through m_CombatSnapshot */
+	void							SetMoveMode( EHumanMoveMode NewMode );
 
 	UFUNCTION( Server, Reliable, WithValidation )
-	void							Server_SetWalkSpeed( float NewSpeed );
-	void							Server_SetWalkSpeed_Implementation( float NewSpeed );
-	bool							Server_SetWalkSpeed_Validate( float NewSpeed ) { return true; }
+	void							Server_SetMoveMode( EHumanMoveMode NewMode );
+	void							Server_SetMoveMode_Implementation( EHumanMoveMode NewMode );
+	bool							Server_SetMoveMode_Validate( EHumanMoveMode NewMode ) { return true; }
+
+	/* Sets MaxWalkSpeed of the mode if it differs. Replication is done by callers */
+	void							SetMoveModeLocal( EHumanMoveMode NewMode );
+
+	/* Replicated through m_CombatSnapshot */
+	EHumanMoveMode					m_eMoveMode;
 
 	void							PlayAttack( FAttackMontage AttackToPlay );
+
+	/* State change or attack of a remote proxy waiting for render time */
+	struct FRemoteCombatEvent
+	{
+		bool						bAttack = false;
+		EHumanState					State = EHumanState::EHS_Free;
+		FAttackMontage				Attack;
+	};
+
+	TCombatEventQueue<FRemoteCombatEvent>	m_RemoteEvents;
+
+	/* Simulated proxy on a client with combat interpolation active */
+	bool							ShouldBufferRemoteEvents() const;
+
+	/* Plays remote events due at render time, all of them if interpolation got inactive */
+	void							PlayRemoteEvents();
+
+	/* Multicast bodies, applied on arrival or when a buffered event is due */
+	void							ApplyState( EHumanState NewState );
+	void							ApplyAttack( const FAttackMontage & AttackToPlay );
+
 	/* It is float but has name Integer. Yes. Needed to count DeltaTime (float) and add 1 to some int */
 	float							CurrentlyRestoredInteger = 0.f;
-	UPROPERTY( Replicated )
+	/* Same for force */
+	float							CurrentlyRestoredForce = 0.f;
+	/* Replicated through m_CombatSnapshot */
 	EHumanState						m_eState;
 
 	float							m_CurAttackLengthCounter;
@@ -316,7 +477,20 @@ private:
 	float							m_CurrentImpactCounter = 0.f;
 
 	/// Stats variables
-	UPROPERTY( Replicated )
+	/* Replicated through m_CombatSnapshot */
 	FHumanStats						m_CurrentStats;
-	
+
+	UPROPERTY( ReplicatedUsing = OnRep_CombatSnapshot )
+	FHumanCombatSnapshot			m_CombatSnapshot;
+
+	/* Applies stats and state of the snapshot, broadcasting what changed */
+	UFUNCTION()
+	void							OnRep_CombatSnapshot();
+
+	/* Sets stats and broadcasts OnStatsChanged if they differ */
+	void							SetCurrentStats( const FHumanStats & NewStats );
+
+	/* Sets state locally and broadcasts OnStateChanged if it differs. Replication is done by callers */
+	void							SetStateLocal( EHumanState NewState );
+
 };
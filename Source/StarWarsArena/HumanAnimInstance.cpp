@@ -0,0 +1,82 @@
+#include "HumanAnimInstance.h"
+#include "GameFramework/CharacterMovementComponent.h"
+
+UHumanAnimInstance::UHumanAnimInstance() :
+	Speed( 0.f ),
+	Direction( 0.f ),
+	Lean( 0.f ),
+	bIsMoving( false ),
+	bIsInAir( false ),
+	bInCombat( false ),
+	bAttacking( false ),
+	bHoldingAttack( false ),
+	bDefending( false ),
+	bThrowing( false ),
+	State( EHumanState::EHS_Free ),
+	FullLeanYawRate( 270.f ),
+	LeanInterpSpeed( 6.f ),
+	MovingSpeedThreshold( 10.f )
+{
+}
+
+float UHumanAnimInstance::CalculateDirection( const FVector & Velocity, const FRotator & BaseRotation )
+{
+	if( Velocity.IsNearlyZero() )
+		return 0.f;
+
+	const FRotationMatrix RotationMatrix( BaseRotation );
+	const FVector Forward = RotationMatrix.GetScaledAxis( EAxis::X );
+	const FVector Right = RotationMatrix.GetScaledAxis( EAxis::Y );
+	const FVector NormalizedVelocity = Velocity.GetSafeNormal2D();
+
+	const float Degrees = FMath::RadiansToDegrees( FMath::Acos( FMath::Clamp( Forward | NormalizedVelocity, -1.f, 1.f ) ) );
+
+	return ( Right | NormalizedVelocity ) < 0.f ? -Degrees : Degrees;
+}
+
+void FHumanAnimInstanceProxy::PreUpdate( UAnimInstance * InAnimInstance, float DeltaSeconds )
+{
+	Super::PreUpdate( InAnimInstance, DeltaSeconds );
+
+	AHuman * Human = Cast<AHuman>( InAnimInstance->TryGetPawnOwner() );
+	m_bHasHuman = Human != nullptr;
+
+	if( !Human )
+		return;
+
+	m_Velocity = Human->GetVelocity();
+	m_Rotation = Human->GetActorRotation();
+	m_State = Human->GetState();
+	m_bFalling = Human->GetCharacterMovement()->IsFalling();
+	m_bInCombat = Human->IsInCombat();
+	m_bHoldingAttack = Human->IsHoldingAttack();
+	m_bHoldingThrow = Human->IsHoldingThrow();
+}
+
+void FHumanAnimInstanceProxy::Update( float DeltaSeconds )
+{
+	Super::Update( DeltaSeconds );
+
+	if( !m_bHasHuman )
+		return;
+
+	/* Instance is owned by this task until the update finishes, game thread does not touch it meanwhile */
+	UHumanAnimInstance * Instance = static_cast<UHumanAnimInstance *>( GetAnimInstanceObject() );
+
+	const float YawRate = DeltaSeconds > 0.f ? FRotator::NormalizeAxis( m_Rotation.Yaw - m_PrevYaw ) / DeltaSeconds : 0.f;
+	const float TargetLean = FMath::Clamp( YawRate / FMath::Max( Instance->FullLeanYawRate, 1.f ), -1.f, 1.f );
+	m_Lean = FMath::FInterpTo( m_Lean, TargetLean, DeltaSeconds, Instance->LeanInterpSpeed );
+	m_PrevYaw = m_Rotation.Yaw;
+
+	Instance->Speed = m_Velocity.Size2D();
+	Instance->Direction = UHumanAnimInstance::CalculateDirection( m_Velocity, m_Rotation );
+	Instance->Lean = m_Lean;
+	Instance->bIsMoving = Instance->Speed > Instance->MovingSpeedThreshold;
+	Instance->bIsInAir = m_bFalling;
+	Instance->bInCombat = m_bInCombat;
+	Instance->bAttacking = m_State == EHumanState::EHS_Attacking;
+	Instance->bHoldingAttack = m_bHoldingAttack;
+	Instance->bDefending = m_State == EHumanState::EHS_Defending;
+	Instance->bThrowing = m_State == EHumanState::EHS_ThrowingSaber || m_bHoldingThrow;
+	Instance->State = m_State;
+}
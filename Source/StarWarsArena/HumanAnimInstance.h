@@ -0,0 +1,128 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Animation/AnimInstance.h"
+#include "Animation/AnimInstanceProxy.h"
+#include "Human.h"
+#include "HumanAnimInstance.generated.h"
+
+class UHumanAnimInstance;
+
+/**
+* Animation update of a human off the game thread.
+* PreUpdate copies what it needs from AHuman on game thread, Update derives anim variables on the animation
+* worker and writes them to the instance right before the graph reads them, in the same task.
+*/
+USTRUCT()
+struct STARWARSARENA_API FHumanAnimInstanceProxy : public FAnimInstanceProxy
+{
+	GENERATED_BODY()
+
+	FHumanAnimInstanceProxy() {}
+
+	FHumanAnimInstanceProxy( UAnimInstance * InAnimInstance ) :
+		FAnimInstanceProxy( InAnimInstance )
+	{
+	}
+
+protected:
+	virtual void						PreUpdate( UAnimInstance * InAnimInstance, float DeltaSeconds ) override;
+
+	virtual void						Update( float DeltaSeconds ) override;
+
+private:
+	/* Game thread copy of the owner */
+	FVector								m_Velocity = FVector::ZeroVector;
+	FRotator							m_Rotation = FRotator::ZeroRotator;
+	EHumanState							m_State = EHumanState::EHS_Free;
+	bool								m_bHasHuman = false;
+	bool								m_bFalling = false;
+	bool								m_bInCombat = false;
+	bool								m_bHoldingAttack = false;
+	bool								m_bHoldingThrow = false;
+
+	/* Worker side history */
+	float								m_PrevYaw = 0.f;
+	float								m_Lean = 0.f;
+};
+
+/**
+* Native parent of the human animation blueprint.
+* Locomotion and combat variables are computed in C++ on the animation worker, so the anim graph only reads
+* members and runs with multi-threaded update. Blueprint event graph of the child should stay empty and
+* Use Multi Threaded Animation Update in its class settings on, any game thread node in the graph turns it off.
+*/
+UCLASS( Transient, Blueprintable )
+class STARWARSARENA_API UHumanAnimInstance : public UAnimInstance
+{
+	GENERATED_BODY()
+
+	friend struct FHumanAnimInstanceProxy;
+
+public:
+	UHumanAnimInstance();
+
+	/* Same result as UAnimInstance::CalculateDirection, without touching any UObject - safe on workers */
+	static float						CalculateDirection( const FVector & Velocity, const FRotator & BaseRotation );
+
+protected:
+	virtual FAnimInstanceProxy *		CreateAnimInstanceProxy() override										{ return &m_Proxy; }
+
+	/* Proxy is a member, nothing to delete */
+	virtual void						DestroyAnimInstanceProxy( FAnimInstanceProxy * InProxy ) override		{}
+
+	/* Horizontal speed */
+	UPROPERTY( Transient, BlueprintReadOnly, Category = "Human" )
+	float								Speed;
+
+	/* Movement direction relative to facing, -180 to 180 degrees */
+	UPROPERTY( Transient, BlueprintReadOnly, Category = "Human" )
+	float								Direction;
+
+	/* Smoothed turn rate, -1 leaning left to 1 leaning right */
+	UPROPERTY( Transient, BlueprintReadOnly, Category = "Human" )
+	float								Lean;
+
+	UPROPERTY( Transient, BlueprintReadOnly, Category = "Human" )
+	bool								bIsMoving;
+
+	UPROPERTY( Transient, BlueprintReadOnly, Category = "Human" )
+	bool								bIsInAir;
+
+	/* Saber drawn, combat stance */
+	UPROPERTY( Transient, BlueprintReadOnly, Category = "Human" )
+	bool								bInCombat;
+
+	UPROPERTY( Transient, BlueprintReadOnly, Category = "Human" )
+	bool								bAttacking;
+
+	UPROPERTY( Transient, BlueprintReadOnly, Category = "Human" )
+	bool								bHoldingAttack;
+
+	UPROPERTY( Transient, BlueprintReadOnly, Category = "Human" )
+	bool								bDefending;
+
+	/* Throwing or waiting for the saber to come back */
+	UPROPERTY( Transient, BlueprintReadOnly, Category = "Human" )
+	bool								bThrowing;
+
+	UPROPERTY( Transient, BlueprintReadOnly, Category = "Human" )
+	EHumanState							State;
+
+	/* Turn rate in degrees per second at which lean reaches 1 */
+	UPROPERTY( EditDefaultsOnly, BlueprintReadOnly, Category = "Human" )
+	float								FullLeanYawRate;
+
+	UPROPERTY( EditDefaultsOnly, BlueprintReadOnly, Category = "Human" )
+	float								LeanInterpSpeed;
+
+	/* Below this speed human stands */
+	UPROPERTY( EditDefaultsOnly, BlueprintReadOnly, Category = "Human" )
+	float								MovingSpeedThreshold;
+
+private:
+	UPROPERTY( Transient )
+	FHumanAnimInstanceProxy				m_Proxy;
+};
@@ -0,0 +1,303 @@
+#include "InputScript.h"
+#include "Human.h"
+#include "HAL/IConsoleManager.h"
+#include "Math/RandomStream.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+namespace
+{
+	bool IsAxis( EScriptedInput Input )
+	{
+		return Input == EScriptedInput::MoveForward || Input == EScriptedInput::MoveRight || Input == EScriptedInput::Turn;
+	}
+
+	bool ParseInput( const FString & Name, EScriptedInput & OutInput )
+	{
+		for( int32 i = 0; i < int32( EScriptedInput::Count ); ++i )
+		{
+			if( Name.Equals( InputScript::InputName( EScriptedInput( i ) ), ESearchCase::IgnoreCase ) )
+			{
+				OutInput = EScriptedInput( i );
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+#if !UE_BUILD_SHIPPING
+	/* Script being recorded by swa.RecordInput, one at a time per process */
+	struct FInputRecording
+	{
+		FInputScript				Script;
+		FString						FileName;
+		double						StartTime = 0.0;
+		float						LastAxis[ 3 ] = { 0.f, 0.f, 0.f };
+	};
+
+	TUniquePtr<FInputRecording>		GInputRecording;
+
+	void RecordInputCommand( const TArray<FString> & Args )
+	{
+		if( Args.Num() >= 2 && Args[ 0 ] == TEXT( "start" ) )
+		{
+			GInputRecording = MakeUnique<FInputRecording>();
+			GInputRecording->FileName = FPaths::IsRelative( Args[ 1 ] ) ? FPaths::ProjectSavedDir() / Args[ 1 ] : Args[ 1 ];
+			GInputRecording->StartTime = FPlatformTime::Seconds();
+
+			UE_LOG( LogTemp, Display, TEXT( "Recording input to %s" ), *GInputRecording->FileName );
+		}
+		else if( Args.Num() >= 1 && Args[ 0 ] == TEXT( "stop" ) && GInputRecording.IsValid() )
+		{
+			FInputScript & Script = GInputRecording->Script;
+			Script.Length = float( FPlatformTime::Seconds() - GInputRecording->StartTime );
+
+			if( Script.SaveToFile( GInputRecording->FileName ) )
+				UE_LOG( LogTemp, Display, TEXT( "Saved %d input events ( %.1f s ) to %s" ), Script.Events.Num(), Script.Length, *GInputRecording->FileName );
+
+			GInputRecording.Reset();
+		}
+		else
+		{
+			UE_LOG( LogTemp, Display, TEXT( "Usage: swa.RecordInput start <file> | stop" ) );
+		}
+	}
+
+	FAutoConsoleCommand RecordInputCommandObject(
+		TEXT( "swa.RecordInput" ),
+		TEXT( "Records local human input into a load test script. 'start <file>' relative to Saved, 'stop' writes it." ),
+		FConsoleCommandWithArgsDelegate::CreateStatic( &RecordInputCommand ) );
+#endif
+}
+
+bool FInputScript::LoadFromFile( const FString & FileName )
+{
+	TArray<FString> Lines;
+	if( !FFileHelper::LoadFileToStringArray( Lines, *FileName ) )
+	{
+		UE_LOG( LogTemp, Error, TEXT( "Cannot read input script %s" ), *FileName );
+		return false;
+	}
+
+	Events.Reset();
+	Length = 0.f;
+
+	for( int32 LineIndex = 0; LineIndex < Lines.Num(); ++LineIndex )
+	{
+		FString Line = Lines[ LineIndex ];
+
+		int32 CommentStart;
+		if( Line.FindChar( TCHAR( '#' ), CommentStart ) )
+			Line = Line.Left( CommentStart );
+
+		TArray<FString> Tokens;
+		Line.ParseIntoArrayWS( Tokens );
+
+		if( Tokens.Num() == 0 )
+			continue;
+
+		FInputScriptEvent Event;
+		if( Tokens.Num() < 2 || !ParseInput( Tokens[ 1 ], Event.Input ) )
+		{
+			UE_LOG( LogTemp, Warning, TEXT( "%s:%d: expected '<seconds> <input> [value]'" ), *FileName, LineIndex + 1 );
+			continue;
+		}
+
+		Event.Time = FCString::Atof( *Tokens[ 0 ] );
+		Event.Value = Tokens.Num() > 2 ? FCString::Atof( *Tokens[ 2 ] ) : 0.f;
+
+		Events.Add( Event );
+	}
+
+	Events.StableSort( []( const FInputScriptEvent & A, const FInputScriptEvent & B ) { return A.Time < B.Time; } );
+
+	Length = Events.Num() > 0 ? Events.Last().Time + 1.f : 0.f;
+
+	return Events.Num() > 0;
+}
+
+bool FInputScript::SaveToFile( const FString & FileName ) const
+{
+	FString Text = FString::Printf( TEXT( "# StarWarsArena input script, %.2f s\n# <seconds> <input> [axis value]\n" ), Length );
+
+	for( const FInputScriptEvent & Event : Events )
+	{
+		if( IsAxis( Event.Input ) )
+			Text += FString::Printf( TEXT( "%.3f %s %.3f\n" ), Event.Time, InputScript::InputName( Event.Input ), Event.Value );
+		else
+			Text += FString::Printf( TEXT( "%.3f %s\n" ), Event.Time, InputScript::InputName( Event.Input ) );
+	}
+
+	return FFileHelper::SaveStringToFile( Text, *FileName );
+}
+
+FInputScript FInputScript::MakeRandom( int32 Seed, float Duration )
+{
+	FRandomStream Random( Seed );
+	FInputScript Script;
+
+	Script.Events.Add( { 0.5f, EScriptedInput::ToggleCombat, 0.f } );
+
+	float Time = 1.f;
+	while( Time < Duration )
+	{
+		/* New stick direction every second or two */
+		Script.Events.Add( { Time, EScriptedInput::MoveForward, Random.FRandRange( -1.f, 1.f ) } );
+		Script.Events.Add( { Time, EScriptedInput::MoveRight, Random.FRandRange( -1.f, 1.f ) } );
+		Script.Events.Add( { Time, EScriptedInput::Turn, Random.FRandRange( -0.5f, 0.5f ) } );
+
+		const float Roll = Random.FRand();
+		const float ActionTime = Time + Random.FRandRange( 0.1f, 0.5f );
+
+		if( Roll < 0.5f )
+		{
+			/* Attack with a short or long hold, sometimes a quick second press */
+			const float Hold = Random.FRandRange( 0.05f, 0.6f );
+			Script.Events.Add( { ActionTime, EScriptedInput::Attack, 0.f } );
+			Script.Events.Add( { ActionTime + Hold, EScriptedInput::StopAttack, 0.f } );
+
+			if( Random.FRand() < 0.3f )
+			{
+				Script.Events.Add( { ActionTime + Hold + 0.15f, EScriptedInput::Attack, 0.f } );
+				Script.Events.Add( { ActionTime + Hold + 0.25f, EScriptedInput::StopAttack, 0.f } );
+			}
+		}
+		else if( Roll < 0.7f )
+		{
+			Script.Events.Add( { ActionTime, EScriptedInput::Defend, 0.f } );
+			Script.Events.Add( { ActionTime + Random.FRandRange( 0.3f, 1.2f ), EScriptedInput::Defend, 0.f } );
+		}
+		else if( Roll < 0.8f )
+		{
+			/* Thrown saber is recalled now and then instead of waiting for it */
+			const float FlightTime = Random.FRandRange( 0.5f, 1.5f );
+			Script.Events.Add( { ActionTime, EScriptedInput::Throw, 0.f } );
+			Script.Events.Add( { ActionTime + FlightTime, EScriptedInput::StopThrow, 0.f } );
+
+			if( Random.FRand() < 0.3f )
+				Script.Events.Add( { ActionTime + FlightTime * 0.5f, EScriptedInput::RecallSaber, 0.f } );
+		}
+		else if( Roll < 0.9f )
+		{
+			Script.Events.Add( { ActionTime, EScriptedInput::Jump, 0.f } );
+			Script.Events.Add( { ActionTime + 0.2f, EScriptedInput::StopJump, 0.f } );
+		}
+		else if( Roll < 0.95f )
+		{
+			Script.Events.Add( { ActionTime, Random.FRand() < 0.5f ? EScriptedInput::ForcePush : EScriptedInput::ForcePull, 0.f } );
+		}
+
+		Time += Random.FRandRange( 1.f, 2.f );
+	}
+
+	Script.Events.StableSort( []( const FInputScriptEvent & A, const FInputScriptEvent & B ) { return A.Time < B.Time; } );
+	Script.Length = FMath::Max( Time, Script.Events.Last().Time + 0.5f );
+
+	return Script;
+}
+
+FInputScriptPlayer::FInputScriptPlayer( const FInputScript & InScript ) :
+	m_Script( InScript )
+{
+}
+
+int32 FInputScriptPlayer::Advance( AHuman * Human, float DeltaTime )
+{
+	if( !Human || m_Script.Events.Num() == 0 )
+		return 0;
+
+	m_Time += DeltaTime;
+
+	int32 NumActions = 0;
+
+	/* Events are sorted, fire everything that became due and wrap around at the end of the loop */
+	while( m_Time >= m_Script.Events[ m_NextEvent ].Time )
+	{
+		const FInputScriptEvent & Event = m_Script.Events[ m_NextEvent ];
+		Fire( Human, Event );
+		NumActions += IsAxis( Event.Input ) ? 0 : 1;
+
+		if( ++m_NextEvent == m_Script.Events.Num() )
+		{
+			m_NextEvent = 0;
+			m_Time = FMath::Max( m_Time - m_Script.Length, 0.f );
+			break;
+		}
+	}
+
+	/* Axis handlers are called every frame, as the input component does */
+	Human->MoveForward( m_Forward );
+	Human->MoveRight( m_Right );
+	Human->Turn( m_Turn );
+
+	return NumActions;
+}
+
+void FInputScriptPlayer::Fire( AHuman * Human, const FInputScriptEvent & Event )
+{
+	switch( Event.Input )
+	{
+		case EScriptedInput::MoveForward :	m_Forward = Event.Value;		break;
+		case EScriptedInput::MoveRight :	m_Right = Event.Value;			break;
+		case EScriptedInput::Turn :			m_Turn = Event.Value;			break;
+		case EScriptedInput::Jump :			Human->OnJumpStart();			break;
+		case EScriptedInput::StopJump :		Human->OnJumpEnd();				break;
+		case EScriptedInput::ToggleCombat :	Human->ToggleCombat();			break;
+		case EScriptedInput::Attack :		Human->Attack();				break;
+		case EScriptedInput::StopAttack :	Human->StopAttack();			break;
+		case EScriptedInput::Defend :		Human->SwitchDefending();		break;
+		case EScriptedInput::Throw :		Human->ThrowSaber();			break;
+		case EScriptedInput::StopThrow :	Human->StopThrowingSaber();		break;
+		case EScriptedInput::ForcePush :	Human->ForcePush();				break;
+		case EScriptedInput::ForcePull :	Human->ForcePull();				break;
+		case EScriptedInput::RecallSaber :	Human->RecallSaber();			break;
+		default :															break;
+	}
+}
+
+const TCHAR * InputScript::InputName( EScriptedInput Input )
+{
+	switch( Input )
+	{
+		case EScriptedInput::MoveForward :	return TEXT( "MoveForward" );
+		case EScriptedInput::MoveRight :	return TEXT( "MoveRight" );
+		case EScriptedInput::Turn :			return TEXT( "Turn" );
+		case EScriptedInput::Jump :			return TEXT( "Jump" );
+		case EScriptedInput::StopJump :		return TEXT( "StopJump" );
+		case EScriptedInput::ToggleCombat :	return TEXT( "ToggleCombat" );
+		case EScriptedInput::Attack :		return TEXT( "Attack" );
+		case EScriptedInput::StopAttack :	return TEXT( "StopAttack" );
+		case EScriptedInput::Defend :		return TEXT( "Defend" );
+		case EScriptedInput::Throw :		return TEXT( "Throw" );
+		case EScriptedInput::StopThrow :	return TEXT( "StopThrow" );
+		case EScriptedInput::ForcePush :	return TEXT( "ForcePush" );
+		case EScriptedInput::ForcePull :	return TEXT( "ForcePull" );
+		case EScriptedInput::RecallSaber :	return TEXT( "RecallSaber" );
+		default :							break;
+	}
+
+	return TEXT( "Unknown" );
+}
+
+void InputScript::Record( const AHuman * Human, EScriptedInput Input, float Value )
+{
+#if !UE_BUILD_SHIPPING
+	/* Bots on a listen server are locally controlled too */
+	if( !GInputRecording.IsValid() || !Human || !Human->IsLocallyControlled() || !Human->IsPlayerControlled() )
+		return;
+
+	/* Axes arrive every frame, only changes are worth a line */
+	if( IsAxis( Input ) )
+	{
+		float & LastValue = GInputRecording->LastAxis[ int32( Input ) ];
+		if( FMath::IsNearlyEqual( LastValue, Value, 0.01f ) )
+			return;
+
+		LastValue = Value;
+	}
+
+	const float Time = float( FPlatformTime::Seconds() - GInputRecording->StartTime );
+	GInputRecording->Script.Events.Add( { Time, Input, Value } );
+#endif
+}
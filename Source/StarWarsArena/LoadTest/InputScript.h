@@ -0,0 +1,85 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class AHuman;
+
+/* Inputs a script can press, same handlers the input component calls */
+enum class EScriptedInput : uint8
+{
+	MoveForward,
+	MoveRight,
+	Turn,
+	Jump,
+	StopJump,
+	ToggleCombat,
+	Attack,
+	StopAttack,
+	Defend,
+	Throw,
+	StopThrow,
+	ForcePush,
+	ForcePull,
+	RecallSaber,
+	Count
+};
+
+struct FInputScriptEvent
+{
+	/* Seconds from script start */
+	float								Time = 0.f;
+	EScriptedInput						Input = EScriptedInput::MoveForward;
+	/* Axis value, unused by actions */
+	float								Value = 0.f;
+};
+
+/**
+* Timed list of human inputs, played in a loop.
+* Text format is one event per line: <seconds> <input> [axis value], # starts a comment.
+* Scripts are recorded from a playing client with swa.RecordInput or generated at random.
+*/
+struct STARWARSARENA_API FInputScript
+{
+	TArray<FInputScriptEvent>			Events;
+
+	/* Loop length, a bit longer than the last event */
+	float								Length = 0.f;
+
+	bool								LoadFromFile( const FString & FileName );
+
+	bool								SaveToFile( const FString & FileName ) const;
+
+	/* Duel-like mix of movement, turning, combat toggles, attacks, blocks, throws and force powers */
+	static FInputScript					MakeRandom( int32 Seed, float Duration );
+};
+
+/* Plays a script on one human. Axis values persist between events, as a held stick does */
+class STARWARSARENA_API FInputScriptPlayer
+{
+public:
+	explicit FInputScriptPlayer( const FInputScript & InScript );
+
+	/* Fires events that became due and feeds held axes. Returns number of actions fired */
+	int32								Advance( AHuman * Human, float DeltaTime );
+
+private:
+	void								Fire( AHuman * Human, const FInputScriptEvent & Event );
+
+	FInputScript						m_Script;
+	float								m_Time = 0.f;
+	int32								m_NextEvent = 0;
+
+	float								m_Forward = 0.f;
+	float								m_Right = 0.f;
+	float								m_Turn = 0.f;
+};
+
+namespace InputScript
+{
+	STARWARSARENA_API const TCHAR *		InputName( EScriptedInput Input );
+
+	/* Adds input of a locally controlled human to the script being recorded. Axes are only added when they change */
+	STARWARSARENA_API void				Record( const AHuman * Human, EScriptedInput Input, float Value = 0.f );
+}
@@ -0,0 +1,141 @@
+#include "LoadTestCommandlet.h"
+#include "LoadTestConnection.h"
+#include "InputScript.h"
+#include "Async/TaskGraphInterfaces.h"
+#include "Containers/Ticker.h"
+#include "HAL/FileManager.h"
+#include "Misc/Paths.h"
+#include "UObject/UObjectGlobals.h"
+
+namespace
+{
+	/* Seconds between garbage collections, connection worlds spawn and destroy replicated actors all the time */
+	const float							GCInterval = 30.f;
+
+	void WriteCsv( FArchive * Csv, const FString & Line )
+	{
+		const FTCHARToUTF8 Utf8( *Line );
+		Csv->Serialize( const_cast<ANSICHAR *>( Utf8.Get() ), Utf8.Length() );
+	}
+}
+
+ULoadTestCommandlet::ULoadTestCommandlet()
+{
+	IsClient = true;
+	IsServer = false;
+	IsEditor = false;
+	LogToConsole = true;
+}
+
+int32 ULoadTestCommandlet::Main( const FString & Params )
+{
+	FString Server = TEXT( "127.0.0.1:7777" );
+	FString ScriptFile;
+	FString CsvFile = TEXT( "LoadTest.csv" );
+	int32 NumClients = 8;
+	int32 Seed = 1;
+	float Duration = 120.f;
+	float FrameRate = 30.f;
+	float Stagger = 0.25f;
+
+	FParse::Value( *Params, TEXT( "Server=" ), Server );
+	FParse::Value( *Params, TEXT( "Script=" ), ScriptFile );
+	FParse::Value( *Params, TEXT( "Csv=" ), CsvFile );
+	FParse::Value( *Params, TEXT( "Clients=" ), NumClients );
+	FParse::Value( *Params, TEXT( "Seed=" ), Seed );
+	FParse::Value( *Params, TEXT( "Duration=" ), Duration );
+	FParse::Value( *Params, TEXT( "FrameRate=" ), FrameRate );
+	FParse::Value( *Params, TEXT( "Stagger=" ), Stagger );
+
+	FInputScript LoadedScript;
+	if( !ScriptFile.IsEmpty() && !LoadedScript.LoadFromFile( FPaths::IsRelative( ScriptFile ) ? FPaths::ProjectSavedDir() / ScriptFile : ScriptFile ) )
+	{
+		UE_LOG( LogTemp, Error, TEXT( "Load test : can not load script %s" ), *ScriptFile );
+		return 1;
+	}
+
+	const FString CsvPath = FPaths::ConvertRelativePathToFull( FPaths::IsRelative( CsvFile ) ? FPaths::ProjectSavedDir() / CsvFile : CsvFile );
+	TUniquePtr<FArchive> Csv( IFileManager::Get().CreateFileWriter( *CsvPath, FILEWRITE_AllowRead ) );
+	if( !Csv )
+	{
+		UE_LOG( LogTemp, Error, TEXT( "Load test : can not write %s" ), *CsvPath );
+		return 1;
+	}
+
+	WriteCsv( Csv.Get(), FLoadTestConnection::GetCsvHeader() );
+
+	UE_LOG( LogTemp, Display, TEXT( "Load test : %d connections against %s for %.0f s, %s, writing %s" ),
+			NumClients, *Server, Duration, ScriptFile.IsEmpty() ? TEXT( "random scripts" ) : *ScriptFile, *CsvPath );
+
+	TArray<TUniquePtr<FLoadTestConnection>> Connections;
+	Connections.Reserve( NumClients );
+
+	const float FrameTime = 1.f / FMath::Max( FrameRate, 1.f );
+	const double StartTime = FPlatformTime::Seconds();
+	double LastFrameTime = StartTime;
+	double NextSampleTime = StartTime + 1.0;
+	double NextGCTime = StartTime + GCInterval;
+	int32 NumFailed = 0;
+
+	/* All connections tick on this thread at the client frame rate, the server sees them as separate players */
+	while( !GIsRequestingExit )
+	{
+		const double Now = FPlatformTime::Seconds();
+		const float Elapsed = float( Now - StartTime );
+
+		/* Connects are spread out, the server logs everyone in on its game thread */
+		const int32 NumDue = FMath::Min( NumClients, Stagger > 0.f ? FMath::FloorToInt( Elapsed / Stagger ) + 1 : NumClients );
+		while( Connections.Num() + NumFailed < NumDue )
+		{
+			const int32 Index = Connections.Num() + NumFailed;
+			const FInputScript Script = ScriptFile.IsEmpty() ? FInputScript::MakeRandom( Seed + Index, 60.f ) : LoadedScript;
+
+			TUniquePtr<FLoadTestConnection> Connection = MakeUnique<FLoadTestConnection>( Index, Script );
+			if( Connection->Connect( Server ) )
+				Connections.Add( MoveTemp( Connection ) );
+			else
+				++NumFailed;
+		}
+
+		if( Elapsed >= NumClients * Stagger + Duration )
+			break;
+
+		const float DeltaTime = float( Now - LastFrameTime );
+		LastFrameTime = Now;
+
+		FTaskGraphInterface::Get().ProcessThreadUntilIdle( ENamedThreads::GameThread );
+		FTicker::GetCoreTicker().Tick( DeltaTime );
+
+		for( TUniquePtr<FLoadTestConnection> & Connection : Connections )
+			Connection->Tick( DeltaTime );
+
+		++GFrameCounter;
+
+		if( Now >= NextSampleTime )
+		{
+			for( TUniquePtr<FLoadTestConnection> & Connection : Connections )
+				WriteCsv( Csv.Get(), Connection->Sample( Elapsed ) );
+
+			NextSampleTime += 1.0;
+		}
+
+		if( Now >= NextGCTime )
+		{
+			CollectGarbage( GARBAGE_COLLECTION_KEEPFLAGS );
+			NextGCTime = Now + GCInterval;
+		}
+
+		const float Remaining = FrameTime - float( FPlatformTime::Seconds() - Now );
+		if( Remaining > 0.f )
+			FPlatformProcess::Sleep( Remaining );
+	}
+
+	/* Closing the drivers tells the server, players leave as on a normal disconnect */
+	Connections.Empty();
+	CollectGarbage( GARBAGE_COLLECTION_KEEPFLAGS );
+
+	Csv->Flush();
+
+	UE_LOG( LogTemp, Display, TEXT( "Load test : done, %d of %d connections started, results in %s" ), NumClients - NumFailed, NumClients, *CsvPath );
+	return NumFailed > 0 ? 1 : 0;
+}
@@ -0,0 +1,26 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "LoadTestCommandlet.generated.h"
+
+/**
+* Headless load generator, many real net connections from one process against a dedicated server:
+*	UE4Editor-Cmd StarWarsArena -run=LoadTest -Server=127.0.0.1:7777 -Clients=32 -Duration=300 -Csv=LoadTest.csv
+* Every FLoadTestConnection has its own net driver, local player and empty world and logs in through the normal
+* handshake, without loading the map. The owned human plays an input script through the same handlers as a player
+* ( -Script=<file> recorded with swa.RecordInput, or a random duel script seeded per client ). All connections are
+* ticked on the commandlet thread at -FrameRate and sampled once a second into one CSV ( relative to Saved ).
+*/
+UCLASS()
+class ULoadTestCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	ULoadTestCommandlet();
+
+	virtual int32						Main( const FString & Params ) override;
+};
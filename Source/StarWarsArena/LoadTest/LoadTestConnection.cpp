@@ -0,0 +1,259 @@
+#include "LoadTestConnection.h"
+#include "Human.h"
+#include "Engine/Engine.h"
+#include "Engine/GameInstance.h"
+#include "Engine/LocalPlayer.h"
+#include "Engine/NetDriver.h"
+#include "Engine/NetConnection.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "GameFramework/PlayerState.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "GameFramework/OnlineReplStructs.h"
+#include "Net/DataChannel.h"
+#include "Misc/NetworkVersion.h"
+
+namespace
+{
+	const float							StateRttTimeout = 2.f;
+}
+
+FLoadTestConnection::FLoadTestConnection( int32 InIndex, const FInputScript & Script ) :
+	m_Index( InIndex ),
+	m_Script( Script ),
+	m_GameInstance( nullptr ),
+	m_World( nullptr ),
+	m_NetDriver( nullptr ),
+	m_bJoined( false ),
+	m_bFailed( false ),
+	m_PendingSince( 0.0 ),
+	m_PendingState( EHumanState::EHS_Free ),
+	m_RttSum( 0.0 ),
+	m_RttSamples( 0 ),
+	m_LastCorrectionTime( 0.f ),
+	m_Corrections( 0 )
+{
+}
+
+FLoadTestConnection::~FLoadTestConnection()
+{
+	Shutdown();
+}
+
+bool FLoadTestConnection::Connect( const FString & Server )
+{
+	/* Game instance brings the world context and local player the engine looks the client player up through */
+	m_GameInstance = NewObject<UGameInstance>( GEngine );
+	m_GameInstance->AddToRoot();
+	m_GameInstance->InitializeStandalone();
+
+	/* Standalone instance starts with a dummy world, the connection gets an empty game world instead */
+	FWorldContext & Context = *m_GameInstance->GetWorldContext();
+	UWorld * DummyWorld = Context.World();
+
+	m_World = UWorld::CreateWorld( EWorldType::Game, false );
+	m_World->SetGameInstance( m_GameInstance );
+	Context.SetCurrentWorld( m_World );
+
+	if( DummyWorld )
+	{
+		DummyWorld->RemoveFromRoot();
+		DummyWorld->DestroyWorld( false );
+	}
+
+	FString Error;
+	if( !m_GameInstance->CreateLocalPlayer( 0, Error, false ) )
+	{
+		UE_LOG( LogTemp, Error, TEXT( "Load test client %d : %s" ), m_Index, *Error );
+		return false;
+	}
+
+	m_World->InitializeActorsForPlay( FURL() );
+	m_World->BeginPlay();
+
+	/* Game net driver of this world only, actors of the world find it by name for their RPCs */
+	if( !GEngine->CreateNamedNetDriver( m_World, NAME_GameNetDriver, NAME_GameNetDriver ) )
+	{
+		UE_LOG( LogTemp, Error, TEXT( "Load test client %d : can not create net driver" ), m_Index );
+		return false;
+	}
+
+	m_NetDriver = GEngine->FindNamedNetDriver( m_World, NAME_GameNetDriver );
+	m_NetDriver->SetWorld( m_World );
+	m_World->SetNetDriver( m_NetDriver );
+
+	m_URL = FURL( nullptr, *Server, TRAVEL_Absolute );
+	m_URL.AddOption( *FString::Printf( TEXT( "Name=LoadTest%d" ), m_Index ) );
+
+	if( !m_NetDriver->InitConnect( this, m_URL, Error ) )
+	{
+		UE_LOG( LogTemp, Error, TEXT( "Load test client %d : can not connect to %s, %s" ), m_Index, *Server, *Error );
+		return false;
+	}
+
+	/* Same greeting as UPendingNetGame, the server answers with a challenge */
+	uint8 IsLittleEndian = uint8( PLATFORM_LITTLE_ENDIAN );
+	uint32 LocalNetworkVersion = FNetworkVersion::GetLocalNetworkVersion();
+	FString EncryptionToken;
+	FNetControlMessage<NMT_Hello>::Send( m_NetDriver->ServerConnection, IsLittleEndian, LocalNetworkVersion, EncryptionToken );
+	m_NetDriver->ServerConnection->FlushNet();
+
+	return true;
+}
+
+void FLoadTestConnection::NotifyControlMessage( UNetConnection * Connection, uint8 MessageType, FInBunch & Bunch )
+{
+	switch( MessageType )
+	{
+		case NMT_Challenge :
+		{
+			FNetControlMessage<NMT_Challenge>::Receive( Bunch, Connection->Challenge );
+
+			FURL LoginURL( m_URL );
+			LoginURL.Host = TEXT( "" );
+
+			Connection->ClientResponse = TEXT( "0" );
+			FString URLString = LoginURL.ToString();
+			FUniqueNetIdRepl UniqueId;
+			FNetControlMessage<NMT_Login>::Send( Connection, Connection->ClientResponse, URLString, UniqueId );
+			Connection->FlushNet();
+			break;
+		}
+
+		case NMT_Welcome :
+		{
+			FString GameName;
+			FString RedirectURL;
+			FNetControlMessage<NMT_Welcome>::Receive( Bunch, m_URL.Map, GameName, RedirectURL );
+
+			/* A real client loads m_URL.Map now. Actors are spawned from their classes, the map is not needed to play */
+			FNetControlMessage<NMT_Netspeed>::Send( Connection, Connection->CurrentNetSpeed );
+			FNetControlMessage<NMT_Join>::Send( Connection );
+			Connection->FlushNet();
+
+			m_bJoined = true;
+			UE_LOG( LogTemp, Log, TEXT( "Load test client %d : joined %s" ), m_Index, *m_URL.Map );
+			break;
+		}
+
+		case NMT_Failure :
+		{
+			FString Error;
+			FNetControlMessage<NMT_Failure>::Receive( Bunch, Error );
+			UE_LOG( LogTemp, Error, TEXT( "Load test client %d : server refused, %s" ), m_Index, *Error );
+
+			m_bFailed = true;
+			break;
+		}
+
+		default :
+			break;
+	}
+}
+
+void FLoadTestConnection::Tick( float DeltaTime )
+{
+	if( !m_World || m_bFailed )
+		return;
+
+	if( AHuman * Human = GetHuman() )
+	{
+		const double Now = FPlatformTime::Seconds();
+
+		if( m_PendingSince > 0.0 && Human->GetState() != m_PendingState )
+		{
+			m_RttSum += Now - m_PendingSince;
+			++m_RttSamples;
+			m_PendingSince = 0.0;
+		}
+		else if( m_PendingSince > 0.0 && Now - m_PendingSince > StateRttTimeout )
+		{
+			/* Input the server ignored, e.g. attack without stamina */
+			m_PendingSince = 0.0;
+		}
+
+		const EHumanState StateBeforeInput = Human->GetState();
+		if( m_Script.Advance( Human, DeltaTime ) > 0 && m_PendingSince == 0.0 )
+		{
+			m_PendingSince = Now;
+			m_PendingState = StateBeforeInput;
+		}
+
+		const FNetworkPredictionData_Client_Character * PredictionData = Human->GetCharacterMovement()->GetPredictionData_Client_Character();
+		if( PredictionData && PredictionData->LastCorrectionTime != m_LastCorrectionTime )
+		{
+			m_LastCorrectionTime = PredictionData->LastCorrectionTime;
+			++m_Corrections;
+		}
+	}
+
+	/* Dispatches received packets, ticks replicated actors and movement, flushes RPCs */
+	m_World->Tick( LEVELTICK_All, DeltaTime );
+}
+
+const TCHAR * FLoadTestConnection::GetCsvHeader()
+{
+	return TEXT( "Time,Client,Connected,InBytesPerSec,OutBytesPerSec,InPacketsLost,OutPacketsLost,AvgLagMs,PingMs,StateRttMs,StateRttSamples,Corrections\n" );
+}
+
+FString FLoadTestConnection::Sample( float Time )
+{
+	UNetConnection * Connection = GetConnection();
+	AHuman * Human = GetHuman();
+	const APlayerState * PlayerState = Human ? Human->PlayerState : nullptr;
+
+	const FString Line = FString::Printf( TEXT( "%.1f,%d,%d,%d,%d,%d,%d,%.1f,%.1f,%.1f,%d,%d\n" ),
+										  Time,
+										  m_Index,
+										  Connection && Human ? 1 : 0,
+										  Connection ? Connection->InBytesPerSecond : 0,
+										  Connection ? Connection->OutBytesPerSecond : 0,
+										  Connection ? Connection->InPacketsLost : 0,
+										  Connection ? Connection->OutPacketsLost : 0,
+										  Connection ? Connection->AvgLag * 1000.f : 0.f,
+										  PlayerState ? PlayerState->ExactPing : 0.f,
+										  m_RttSamples > 0 ? m_RttSum * 1000.0 / m_RttSamples : 0.0,
+										  m_RttSamples,
+										  m_Corrections );
+
+	m_RttSum = 0.0;
+	m_RttSamples = 0;
+	m_Corrections = 0;
+
+	return Line;
+}
+
+AHuman * FLoadTestConnection::GetHuman() const
+{
+	ULocalPlayer * LocalPlayer = m_GameInstance ? m_GameInstance->GetFirstGamePlayer() : nullptr;
+	APlayerController * PlayerController = LocalPlayer ? LocalPlayer->PlayerController : nullptr;
+
+	return PlayerController ? Cast<AHuman>( PlayerController->GetPawn() ) : nullptr;
+}
+
+UNetConnection * FLoadTestConnection::GetConnection() const
+{
+	return m_bJoined && m_NetDriver ? m_NetDriver->ServerConnection : nullptr;
+}
+
+void FLoadTestConnection::Shutdown()
+{
+	if( !m_GameInstance )
+		return;
+
+	m_GameInstance->Shutdown();
+
+	if( m_World )
+	{
+		GEngine->DestroyNamedNetDriver( m_World, NAME_GameNetDriver );
+		GEngine->DestroyWorldContext( m_World );
+		m_World->RemoveFromRoot();
+		m_World->DestroyWorld( false );
+	}
+
+	m_GameInstance->RemoveFromRoot();
+
+	m_GameInstance = nullptr;
+	m_World = nullptr;
+	m_NetDriver = nullptr;
+}
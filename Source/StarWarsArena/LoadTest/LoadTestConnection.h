@@ -0,0 +1,76 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/PendingNetGame.h"
+#include "InputScript.h"
+
+class AHuman;
+class UGameInstance;
+class UNetDriver;
+class UNetConnection;
+class UWorld;
+enum class EHumanState : uint8;
+
+/**
+* One simulated client of the load test, a real net connection without the map.
+* It has its own game instance, local player and empty game world, and its own net driver connected to the server.
+* The login handshake is the one UPendingNetGame does, but the client joins right after Welcome without loading the map:
+* replicated actors ( game state, player controller, humans ) are spawned into the empty world as usual, static map
+* actors stay unresolved. The owned human gets its input from a script through the same handlers a player uses,
+* so moves and combat go to the server through the normal RPCs.
+*/
+class FLoadTestConnection : public FNetworkNotify
+{
+public:
+	FLoadTestConnection( int32 InIndex, const FInputScript & Script );
+
+	virtual ~FLoadTestConnection();
+
+	/* Creates the world and net driver and sends Hello. False if the connection could not be started */
+	bool								Connect( const FString & Server );
+
+	/* Plays the script on the owned human and ticks the world, which also receives and sends packets */
+	void								Tick( float DeltaTime );
+
+	/* CSV row of the last second, resets the window */
+	FString								Sample( float Time );
+
+	static const TCHAR *				GetCsvHeader();
+
+	//~ FNetworkNotify
+	virtual EAcceptConnection::Type		NotifyAcceptingConnection() override								{ return EAcceptConnection::Reject; }
+	virtual void						NotifyAcceptedConnection( UNetConnection * Connection ) override	{}
+	virtual bool						NotifyAcceptingChannel( UChannel * Channel ) override				{ return true; }
+	virtual void						NotifyControlMessage( UNetConnection * Connection, uint8 MessageType, FInBunch & Bunch ) override;
+
+private:
+	AHuman *							GetHuman() const;
+
+	UNetConnection *					GetConnection() const;
+
+	void								Shutdown();
+
+	int32								m_Index;
+	FInputScriptPlayer					m_Script;
+
+	UGameInstance *						m_GameInstance;
+	UWorld *							m_World;
+	UNetDriver *						m_NetDriver;
+
+	/* Login URL, map part is filled in by Welcome */
+	FURL								m_URL;
+
+	bool								m_bJoined;
+	bool								m_bFailed;
+
+	/* State round trip: state is only set by the server, so input until the local state changes is one round trip */
+	double								m_PendingSince;
+	EHumanState							m_PendingState;
+	double								m_RttSum;
+	int32								m_RttSamples;
+
+	float								m_LastCorrectionTime;
+	int32								m_Corrections;
+};
@@ -1,12 +1,16 @@
 #include "MoveSet.h"
 #include "GameFramework/Character.h"
-#include "Animation/AnimInstance.h"
+#include "HumanAnimInstance.h"
+#include "Diagnostics/CombatMemory.h"
+#include "Animation/AnimMontage.h"
 
 UMoveSet::UMoveSet() :
 	m_MaxStamina( 100.f ),
 	m_MaxForce( 100.f ),
 	m_fLongPressDuration( 0.3f )
 {
+	COMBAT_LLM_SCOPE( ECombatMemory::MoveSets );
+
 	PrimaryComponentTick.bCanEverTick = false;
 
 	for( auto OpeningAttack : OpeningAttacks )
@@ -21,21 +25,18 @@ UMoveSet::UMoveSet() :
 
 void UMoveSet::BeginPlay()
 {
+	COMBAT_LLM_SCOPE( ECombatMemory::MoveSets );
+
 	Super::BeginPlay();
 	
 	m_OwningCharacter  = Cast<ACharacter>( GetOwner() );
-	m_AnimationInstance = m_OwningCharacter->GetMesh()->GetAnimInstance();
 	
+	/* Direction comes from velocity and rotation, see UHumanAnimInstance::CalculateDirection - no anim instance needed */
 	if( !m_OwningCharacter )
 	{
 		UE_LOG( LogTemp, Error, TEXT( "MoveSet %s does not have owner." ), *GetName() );
 		DestroyComponent();
-	}
-	
-	if( !m_AnimationInstance )
-	{
-		UE_LOG( LogTemp, Error, TEXT( "MoveSet's %s owner %s does not have AnimInstance." ), *GetName(), *m_OwningCharacter->GetName() );
-		DestroyComponent();
+		return;
 	}
 
 	if( OpeningAttacks.Num() < 1 || FurtherAttacks.Num() < 1 )
@@ -49,9 +50,25 @@ void UMoveSet::TickComponent(float DeltaTime, ELevelTick TickType, FActorCompone
 	
 }
 */
+void UMoveSet::GetAttackMontages( TSet<UAnimMontage *> & OutMontages ) const
+{
+	for( const FAttackMontage & Attack : OpeningAttacks )
+	{
+		if( Attack.MontageAnimation )
+			OutMontages.Add( Attack.MontageAnimation );
+	}
+
+	for( const auto & Attack : FurtherAttacks )
+	{
+		if( Attack.Value.MontageAnimation )
+			OutMontages.Add( Attack.Value.MontageAnimation );
+	}
+}
+
 FAttackMontage UMoveSet::GetOpeningMontage()
 {
-	float CurrentDirection = m_AnimationInstance->CalculateDirection( m_OwningCharacter->GetVelocity(), m_OwningCharacter->GetActorRotation() );
+	/* Same math as the anim graph direction, so the opening attack matches the locomotion blend */
+	float CurrentDirection = UHumanAnimInstance::CalculateDirection( m_OwningCharacter->GetVelocity(), m_OwningCharacter->GetActorRotation() );
 
 	/* Add 45/2 degrees to direction. If direction < 0 add 360 more */
 	CurrentDirection += CurrentDirection < 0.f ? 382.5f : 22.5f;
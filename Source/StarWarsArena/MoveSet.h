@@ -5,7 +5,6 @@
 #include "MoveSet.generated.h"
 
 class ACharacter;
-class UAnimInstance;
 
 USTRUCT( BlueprintType )
 struct FAttackMontage
@@ -71,7 +70,7 @@ struct FAttackMontage
 
 /**
 * Class that defines Move Set of a character.
-* Character should have an animation instance obviously.
+* Owner should be a character, opening attack is picked by its movement direction.
 * Opening attacks array stores what attacks to play first in combo -
 * sort them from "front run" to "left front" in clockwise.
 * Further attacks stores all further attacks - for now we
@@ -94,6 +93,16 @@ public:
 
 	void									SetLongPressDuration( float NewLength )										{ m_fLongPressDuration = NewLength; }
 
+	float									GetLongPressDuration() const												{ return m_fLongPressDuration; }
+
+	const TArray<FAttackMontage> &			GetOpeningAttacks() const													{ return OpeningAttacks; }
+
+	/* Follow up attack by its press pattern ( Weak, Strong, WeakWeak, ... ), null if the move set has none */
+	const FAttackMontage *					FindFurtherAttack( FName Name ) const										{ return FurtherAttacks.Find( Name ); }
+
+	/* Adds every opening and further attack montage, for memory reports */
+	void									GetAttackMontages( TSet<UAnimMontage *> & OutMontages ) const;
+
 protected:
 	virtual void BeginPlay() override;
 
@@ -107,7 +116,6 @@ protected:
 	FAttackMontage							OpeningSttacksStats;
 private:
 	ACharacter		*						m_OwningCharacter;
-	UAnimInstance	*						m_AnimationInstance;
 
 	float									m_fLongPressDuration;
 
@@ -0,0 +1,473 @@
+#include "CombatBroadcast.h"
+#include "NetPacking.h"
+#include "CombatClock.h"
+#include "Engine/World.h"
+#include "Engine/NetSerialization.h"
+#include "Animation/AnimMontage.h"
+#include "Serialization/BitReader.h"
+#include "Serialization/BitWriter.h"
+#include "Containers/Ticker.h"
+#include "Misc/Crc.h"
+#include "Sockets.h"
+#include "SocketSubsystem.h"
+#include "Common/UdpSocketBuilder.h"
+#include "Interfaces/IPv4/IPv4Endpoint.h"
+
+#include "EngineUtils.h"
+
+namespace
+{
+	/* Datagram larger than any packet the broadcaster writes */
+	const int32							ReceiveBufferSize = 2048;
+
+	/* Relay forgets spectators after 10 seconds of silence */
+	const double						SubscribeInterval = 3.0;
+
+	void SerializeHuman( FArchive & Ar, FBroadcastHuman & Human )
+	{
+		Ar.SerializeIntPacked( Human.HumanId );
+
+		/* 0.1 cm precision, same as replicated movement */
+		SerializePackedVector<10, 24>( Human.Location, Ar );
+
+		uint16 CompressedYaw = FRotator::CompressAxisToShort( Human.Yaw );
+		Ar << CompressedYaw;
+		Human.Yaw = FRotator::DecompressAxisFromShort( CompressedYaw );
+
+		NetPacking::SerializeStat( Ar, Human.Stats.HS_Health );
+		NetPacking::SerializeStat( Ar, Human.Stats.HS_Stamina );
+		NetPacking::SerializeStat( Ar, Human.Stats.HS_Force );
+
+		uint32 PackedState = uint32( Human.State );
+		Ar.SerializeInt( PackedState, 16 );
+		Human.State = EHumanState( PackedState );
+
+		uint8 bHasAttack = Human.AttackId != 0;
+		Ar.SerializeBits( &bHasAttack, 1 );
+		if( bHasAttack )
+			Ar << Human.AttackId;
+		else
+			Human.AttackId = 0;
+
+		uint32 PackedSaberState = uint32( Human.SaberState );
+		Ar.SerializeInt( PackedSaberState, 8 );
+		Human.SaberState = ESaberState( PackedSaberState );
+
+		NetPacking::SerializeQuantized( Ar, Human.BladeFraction, 1.f, 8 );
+	}
+}
+
+bool FCombatBroadcastPacket::Serialize( FArchive & Ar )
+{
+	uint16 Magic = CombatBroadcast::PacketMagic;
+	uint8 PacketVersion = CombatBroadcast::Version;
+	Ar << Magic << PacketVersion;
+
+	if( Ar.IsError() || Magic != CombatBroadcast::PacketMagic || PacketVersion != CombatBroadcast::Version )
+		return false;
+
+	Ar << ArenaId << Sequence << ServerTime;
+
+	uint32 Part = PartIndex;
+	uint32 Parts = NumParts;
+	Ar.SerializeInt( Part, 256 );
+	Ar.SerializeInt( Parts, 256 );
+	PartIndex = uint8( Part );
+	NumParts = uint8( Parts );
+
+	uint32 NumHumans = Humans.Num();
+	Ar.SerializeInt( NumHumans, CombatBroadcast::MaxHumansPerPacket + 1 );
+	if( Ar.IsLoading() )
+		Humans.SetNum( NumHumans );
+
+	for( FBroadcastHuman & Human : Humans )
+		SerializeHuman( Ar, Human );
+
+	uint32 NumLaunches = Launches.Num();
+	Ar.SerializeInt( NumLaunches, CombatBroadcast::MaxLaunchesPerPacket + 1 );
+	if( Ar.IsLoading() )
+		Launches.SetNum( NumLaunches );
+
+	for( FBroadcastSaberLaunch & Launch : Launches )
+	{
+		Ar.SerializeIntPacked( Launch.LaunchId );
+		Ar.SerializeIntPacked( Launch.HumanId );
+		Ar << Launch.MaxFlyDistance << Launch.ServerTime;
+	}
+
+	return !Ar.IsError();
+}
+
+bool CombatBroadcast::PeekPacket( const uint8 * Data, int32 NumBytes, uint16 & OutArenaId )
+{
+	FBitReader Reader( const_cast<uint8 *>( Data ), NumBytes * 8 );
+
+	uint16 Magic = 0;
+	uint8 PacketVersion = 0;
+	Reader << Magic << PacketVersion << OutArenaId;
+
+	return !Reader.IsError() && Magic == PacketMagic && PacketVersion == Version;
+}
+
+void CombatBroadcast::WriteSubscribe( uint16 ArenaId, TArray<uint8> & OutData )
+{
+	FBitWriter Writer( 64, true );
+	uint32 Magic = SubscribeMagic;
+	Writer << Magic << ArenaId;
+
+	OutData = *Writer.GetBuffer();
+	OutData.SetNum( Writer.GetNumBytes() );
+}
+
+bool CombatBroadcast::ReadSubscribe( const uint8 * Data, int32 NumBytes, uint16 & OutArenaId )
+{
+	FBitReader Reader( const_cast<uint8 *>( Data ), NumBytes * 8 );
+
+	uint32 Magic = 0;
+	Reader << Magic << OutArenaId;
+
+	return !Reader.IsError() && Magic == SubscribeMagic;
+}
+
+TSharedPtr<FInternetAddr> CombatBroadcast::ResolveAddress( const FString & Address )
+{
+	FIPv4Endpoint Endpoint;
+	if( !FIPv4Endpoint::Parse( Address, Endpoint ) )
+		return nullptr;
+
+	TSharedRef<FInternetAddr> InternetAddress = Endpoint.ToInternetAddr();
+	return InternetAddress;
+}
+
+FCombatBroadcastReceiver::~FCombatBroadcastReceiver()
+{
+	Close();
+}
+
+bool FCombatBroadcastReceiver::Connect( const FString & RelayAddress, uint16 ArenaId )
+{
+	Close();
+
+	m_RelayAddress = CombatBroadcast::ResolveAddress( RelayAddress );
+	if( !m_RelayAddress.IsValid() )
+	{
+		UE_LOG( LogTemp, Error, TEXT( "Combat broadcast : invalid relay address %s." ), *RelayAddress );
+		return false;
+	}
+
+	m_Socket = FUdpSocketBuilder( TEXT( "CombatBroadcastReceiver" ) ).AsNonBlocking().WithReceiveBufferSize( 256 * 1024 ).Build();
+	m_ArenaId = ArenaId;
+	m_LastSubscribeTime = 0.0;
+	m_LastSequence = 0;
+	m_NumLost = 0;
+
+	return m_Socket != nullptr;
+}
+
+void FCombatBroadcastReceiver::Close()
+{
+	if( m_Socket )
+	{
+		m_Socket->Close();
+		ISocketSubsystem::Get( PLATFORM_SOCKETSUBSYSTEM )->DestroySocket( m_Socket );
+		m_Socket = nullptr;
+	}
+}
+
+void FCombatBroadcastReceiver::Poll( TArray<FCombatBroadcastPacket> & OutPackets )
+{
+	OutPackets.Reset();
+
+	if( !m_Socket )
+		return;
+
+	const double Now = FPlatformTime::Seconds();
+	if( Now - m_LastSubscribeTime >= SubscribeInterval )
+	{
+		TArray<uint8> Subscribe;
+		CombatBroadcast::WriteSubscribe( m_ArenaId, Subscribe );
+
+		int32 BytesSent = 0;
+		m_Socket->SendTo( Subscribe.GetData(), Subscribe.Num(), BytesSent, *m_RelayAddress );
+		m_LastSubscribeTime = Now;
+	}
+
+	uint8 Buffer[ ReceiveBufferSize ];
+	int32 BytesRead = 0;
+	TSharedRef<FInternetAddr> Sender = ISocketSubsystem::Get( PLATFORM_SOCKETSUBSYSTEM )->CreateInternetAddr();
+
+	while( m_Socket->RecvFrom( Buffer, ReceiveBufferSize, BytesRead, *Sender ) && BytesRead > 0 )
+	{
+		FBitReader Reader( Buffer, BytesRead * 8 );
+		FCombatBroadcastPacket Packet;
+
+		if( !Packet.Serialize( Reader ) || Packet.ArenaId != m_ArenaId )
+			continue;
+
+		/* Only the first part of a frame counts, a lost part shows up as an old sequence */
+		if( Packet.PartIndex == 0 )
+		{
+			if( m_LastSequence != 0 && Packet.Sequence > m_LastSequence + 1 )
+				m_NumLost += Packet.Sequence - m_LastSequence - 1;
+
+			m_LastSequence = FMath::Max( m_LastSequence, Packet.Sequence );
+		}
+
+		OutPackets.Add( MoveTemp( Packet ) );
+	}
+}
+
+ACombatBroadcaster::ACombatBroadcaster() :
+	PacketsPerSecond( 20.f ),
+	LaunchRepeats( 3 ),
+	m_Socket( nullptr ),
+	m_ArenaId( 0 ),
+	m_NextLaunchId( 1 ),
+	m_Sequence( 0 ),
+	m_TimeToSend( 0.f ),
+	m_NumPackets( 0 ),
+	m_NumBytes( 0 ),
+	m_PackSeconds( 0.0 )
+{
+	bReplicates = false;
+	PrimaryActorTick.bCanEverTick = true;
+	/* Humans have moved and resolved their combat by then */
+	PrimaryActorTick.TickGroup = TG_PostUpdateWork;
+}
+
+ACombatBroadcaster * ACombatBroadcaster::Get( UWorld * World, bool bSpawnIfMissing )
+{
+	if( !World || World->GetNetMode() == NM_Client )
+		return nullptr;
+
+	for( TActorIterator<ACombatBroadcaster> It( World ); It; ++It )
+	{
+		if( !It->IsPendingKill() )
+			return *It;
+	}
+
+	if( !bSpawnIfMissing )
+		return nullptr;
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	SpawnParams.ObjectFlags |= RF_Transient;
+
+	return World->SpawnActor<ACombatBroadcaster>( SpawnParams );
+}
+
+bool ACombatBroadcaster::StartBroadcast( const FString & RelayAddress, uint16 InArenaId )
+{
+	m_RelayAddress = CombatBroadcast::ResolveAddress( RelayAddress );
+	if( !m_RelayAddress.IsValid() )
+	{
+		UE_LOG( LogTemp, Error, TEXT( "%s : invalid combat broadcast relay address %s." ), *GetName(), *RelayAddress );
+		return false;
+	}
+
+	if( !m_Socket )
+		m_Socket = FUdpSocketBuilder( TEXT( "CombatBroadcast" ) ).AsNonBlocking().WithSendBufferSize( 256 * 1024 ).Build();
+
+	m_ArenaId = InArenaId;
+
+	UE_LOG( LogTemp, Log, TEXT( "%s : broadcasting arena %d to %s, %.0f packets per second." ),
+			*GetName(), m_ArenaId, *RelayAddress, PacketsPerSecond );
+
+	return m_Socket != nullptr;
+}
+
+void ACombatBroadcaster::EndPlay( const EEndPlayReason::Type EndPlayReason )
+{
+	if( m_Socket )
+	{
+		LogStats();
+
+		m_Socket->Close();
+		ISocketSubsystem::Get( PLATFORM_SOCKETSUBSYSTEM )->DestroySocket( m_Socket );
+		m_Socket = nullptr;
+	}
+
+	Super::EndPlay( EndPlayReason );
+}
+
+void ACombatBroadcaster::RecordSaberLaunch( AHuman * Human, float MaxFlyDistance )
+{
+	if( !m_Socket || !Human )
+		return;
+
+	FPendingLaunch & Pending = m_Launches[ m_Launches.AddDefaulted() ];
+	Pending.Launch.LaunchId = m_NextLaunchId++;
+	Pending.Launch.HumanId = Human->GetUniqueID();
+	Pending.Launch.MaxFlyDistance = MaxFlyDistance;
+	Pending.Launch.ServerTime = float( UCombatClockComponent::GetServerTime( GetWorld() ) );
+	Pending.RepeatsLeft = FMath::Max( LaunchRepeats, 1 );
+}
+
+void ACombatBroadcaster::Tick( float DeltaTime )
+{
+	Super::Tick( DeltaTime );
+
+	if( !m_Socket )
+		return;
+
+	m_TimeToSend -= DeltaTime;
+	if( m_TimeToSend > 0.f )
+		return;
+
+	m_TimeToSend += 1.f / FMath::Max( PacketsPerSecond, 1.f );
+	m_TimeToSend = FMath::Max( m_TimeToSend, 0.f );
+
+	SendFrame();
+}
+
+void ACombatBroadcaster::SendFrame()
+{
+	const double StartTime = FPlatformTime::Seconds();
+
+	m_Humans.Reset();
+
+	for( TActorIterator<AHuman> It( GetWorld() ); It; ++It )
+	{
+		AHuman * Human = *It;
+		if( Human->IsPendingKill() )
+			continue;
+
+		FBroadcastHuman & Entry = m_Humans[ m_Humans.AddDefaulted() ];
+		Entry.HumanId = Human->GetUniqueID();
+		Entry.Location = Human->GetActorLocation();
+		Entry.Yaw = Human->GetActorRotation().Yaw;
+		Entry.Stats = Human->GetCurrentStats();
+		Entry.State = Human->GetState();
+
+		const FAttackMontage Attack = Human->GetCurrentlyPlayingAttack();
+		if( Entry.State == EHumanState::EHS_Attacking && Attack.MontageAnimation )
+			Entry.AttackId = FCrc::StrCrc32( *Attack.MontageAnimation->GetPathName() );
+
+		if( ASaber * Saber = Human->GetSaber() )
+		{
+			Entry.SaberState = Saber->GetSaberState();
+			Entry.BladeFraction = Saber->GetBladeFraction();
+		}
+	}
+
+	++m_Sequence;
+
+	FCombatBroadcastPacket Packet;
+	Packet.ArenaId = m_ArenaId;
+	Packet.Sequence = m_Sequence;
+	Packet.ServerTime = float( UCombatClockComponent::GetServerTime( GetWorld() ) );
+	Packet.NumParts = uint8( FMath::Clamp( FMath::DivideAndRoundUp( m_Humans.Num(), CombatBroadcast::MaxHumansPerPacket ), 1, 255 ) );
+
+	/* Launches ride in the first part */
+	for( FPendingLaunch & Pending : m_Launches )
+	{
+		if( Packet.Launches.Num() >= CombatBroadcast::MaxLaunchesPerPacket )
+			break;
+
+		Packet.Launches.Add( Pending.Launch );
+		--Pending.RepeatsLeft;
+	}
+
+	m_Launches.RemoveAll( []( const FPendingLaunch & Pending ) { return Pending.RepeatsLeft <= 0; } );
+
+	for( int32 Part = 0; Part < Packet.NumParts; ++Part )
+	{
+		const int32 First = Part * CombatBroadcast::MaxHumansPerPacket;
+		const int32 Count = FMath::Clamp( m_Humans.Num() - First, 0, CombatBroadcast::MaxHumansPerPacket );
+
+		Packet.PartIndex = uint8( Part );
+		Packet.Humans.Reset();
+		Packet.Humans.Append( m_Humans.GetData() + First, Count );
+
+		SendPacket( Packet );
+		Packet.Launches.Reset();
+	}
+
+	m_PackSeconds += FPlatformTime::Seconds() - StartTime;
+}
+
+void ACombatBroadcaster::SendPacket( FCombatBroadcastPacket & Packet )
+{
+	FBitWriter Writer( 1200 * 8, true );
+	Packet.Serialize( Writer );
+
+	int32 BytesSent = 0;
+	if( m_Socket->SendTo( Writer.GetData(), Writer.GetNumBytes(), BytesSent, *m_RelayAddress ) )
+	{
+		++m_NumPackets;
+		m_NumBytes += BytesSent;
+	}
+}
+
+void ACombatBroadcaster::LogStats() const
+{
+	UE_LOG( LogTemp, Log, TEXT( "Combat broadcast : %llu packets, %llu bytes sent to relay, %.3f ms packing per frame." ),
+			m_NumPackets, m_NumBytes, m_Sequence > 0 ? m_PackSeconds * 1000.0 / m_Sequence : 0.0 );
+}
+
+static FAutoConsoleCommandWithWorld CombatBroadcastStatsCommand(
+	TEXT( "swa.BroadcastStats" ),
+	TEXT( "Logs packets and bytes the server sent to the combat broadcast relay." ),
+	FConsoleCommandWithWorldDelegate::CreateLambda( []( UWorld * World )
+	{
+		if( ACombatBroadcaster * Broadcaster = ACombatBroadcaster::Get( World, false ) )
+			Broadcaster->LogStats();
+	} ) );
+
+#if !UE_BUILD_SHIPPING
+namespace CombatBroadcastWatch
+{
+	/* Spectator side check of the stream: logs what arrives once per second */
+	TUniquePtr<FCombatBroadcastReceiver>	GReceiver;
+	FDelegateHandle							GTickerHandle;
+	TArray<FCombatBroadcastPacket>			GPackets;
+	int32									GNumPackets = 0;
+	double									GLastLogTime = 0.0;
+
+	bool Tick( float DeltaTime )
+	{
+		GReceiver->Poll( GPackets );
+		GNumPackets += GPackets.Num();
+
+		const double Now = FPlatformTime::Seconds();
+		if( Now - GLastLogTime >= 1.0 )
+		{
+			const FCombatBroadcastPacket * Last = GPackets.Num() > 0 ? &GPackets.Last() : nullptr;
+
+			UE_LOG( LogTemp, Log, TEXT( "Combat broadcast watch : %d packets, %d lost, last sequence %u with %d humans." ),
+					GNumPackets, GReceiver->GetNumLostPackets(), Last ? Last->Sequence : 0u, Last ? Last->Humans.Num() : 0 );
+
+			GNumPackets = 0;
+			GLastLogTime = Now;
+		}
+
+		return true;
+	}
+
+	void Run( const TArray<FString> & Args )
+	{
+		if( GTickerHandle.IsValid() )
+		{
+			FTicker::GetCoreTicker().RemoveTicker( GTickerHandle );
+			GTickerHandle.Reset();
+			GReceiver.Reset();
+		}
+
+		if( Args.Num() == 0 || Args[ 0 ] == TEXT( "stop" ) )
+			return;
+
+		GReceiver = MakeUnique<FCombatBroadcastReceiver>();
+		const uint16 ArenaId = Args.Num() > 1 ? uint16( FCString::Atoi( *Args[ 1 ] ) ) : 0;
+
+		if( GReceiver->Connect( Args[ 0 ], ArenaId ) )
+			GTickerHandle = FTicker::GetCoreTicker().AddTicker( FTickerDelegate::CreateStatic( &Tick ) );
+		else
+			GReceiver.Reset();
+	}
+}
+
+static FAutoConsoleCommand CombatBroadcastWatchCommand(
+	TEXT( "swa.WatchBroadcast" ),
+	TEXT( "Subscribes to a combat broadcast relay and logs the stream. Arguments: relay host:port [arena id], or 'stop'." ),
+	FConsoleCommandWithArgsDelegate::CreateStatic( &CombatBroadcastWatch::Run ) );
+#endif // !UE_BUILD_SHIPPING
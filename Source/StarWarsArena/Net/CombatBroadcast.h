@@ -0,0 +1,175 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "Human.h"
+#include "Objects/Saber.h"
+#include "CombatBroadcast.generated.h"
+
+class FSocket;
+class FInternetAddr;
+
+/* State of one human in a broadcast packet */
+struct FBroadcastHuman
+{
+	/* Server side actor id, stable for the whole match */
+	uint32								HumanId = 0;
+
+	FVector								Location = FVector::ZeroVector;
+	float								Yaw = 0.f;
+
+	FHumanStats							Stats;
+	EHumanState							State = EHumanState::EHS_Free;
+
+	/* CRC of the attack montage path, zero when not attacking */
+	uint32								AttackId = 0;
+
+	ESaberState							SaberState = ESaberState::ESS_Closed;
+	float								BladeFraction = 0.f;
+};
+
+/* Saber throw, repeated in a few packets since datagrams get lost. Receivers drop duplicates by LaunchId */
+struct FBroadcastSaberLaunch
+{
+	uint32								LaunchId = 0;
+	uint32								HumanId = 0;
+	float								MaxFlyDistance = 0.f;
+	float								ServerTime = 0.f;
+};
+
+/* One datagram of the combat stream. A frame with many humans is split into parts with the same sequence */
+struct STARWARSARENA_API FCombatBroadcastPacket
+{
+	uint16								ArenaId = 0;
+	uint32								Sequence = 0;
+	float								ServerTime = 0.f;
+	uint8								PartIndex = 0;
+	uint8								NumParts = 1;
+
+	TArray<FBroadcastHuman>				Humans;
+	TArray<FBroadcastSaberLaunch>		Launches;
+
+	/* Bit packed both ways. False if a loaded packet is not a combat stream packet of this version or is truncated */
+	bool								Serialize( FArchive & Ar );
+};
+
+/**
+* Compact combat stream for spectators. The server sends one stream per arena to a relay
+* ( UCombatRelayCommandlet ), the relay delays it and fans it out to any number of subscribed
+* spectators, so server cost does not depend on audience size.
+*/
+namespace CombatBroadcast
+{
+	static const uint16					PacketMagic = 0x5357;
+	static const uint8					Version = 2;
+	static const uint32					SubscribeMagic = 0x53554231;
+
+	/* Keeps a packet under a usual MTU */
+	static const int32					MaxHumansPerPacket = 40;
+	static const int32					MaxLaunchesPerPacket = 16;
+
+	/* Reads arena id from the packet header without decoding the rest. False if this is not a stream packet */
+	STARWARSARENA_API bool				PeekPacket( const uint8 * Data, int32 NumBytes, uint16 & OutArenaId );
+
+	STARWARSARENA_API void				WriteSubscribe( uint16 ArenaId, TArray<uint8> & OutData );
+
+	STARWARSARENA_API bool				ReadSubscribe( const uint8 * Data, int32 NumBytes, uint16 & OutArenaId );
+
+	/* Resolves host:port, false if the address is invalid */
+	STARWARSARENA_API TSharedPtr<FInternetAddr>	ResolveAddress( const FString & Address );
+}
+
+/**
+* Spectator side of the stream: subscribes to a relay and decodes what it receives.
+* Subscription is renewed every few seconds, the relay forgets silent spectators.
+*/
+class STARWARSARENA_API FCombatBroadcastReceiver
+{
+public:
+	~FCombatBroadcastReceiver();
+
+	bool								Connect( const FString & RelayAddress, uint16 ArenaId );
+
+	void								Close();
+
+	/* Renews subscription when due and decodes every waiting packet */
+	void								Poll( TArray<FCombatBroadcastPacket> & OutPackets );
+
+	int32								GetNumLostPackets() const									{ return m_NumLost; }
+
+private:
+	FSocket *							m_Socket = nullptr;
+	TSharedPtr<FInternetAddr>			m_RelayAddress;
+	uint16								m_ArenaId = 0;
+
+	double								m_LastSubscribeTime = 0.0;
+	uint32								m_LastSequence = 0;
+	int32								m_NumLost = 0;
+};
+
+/**
+* Server side of the combat stream, one per world.
+* A fixed number of times per second state of every human is packed and sent to the relay as
+* one or a few datagrams. Started by the game mode with ?Broadcast=host:port in the travel URL.
+* Not spawned on clients, Get returns null there.
+*/
+UCLASS( NotPlaceable, Transient, Config = Game )
+class STARWARSARENA_API ACombatBroadcaster : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	ACombatBroadcaster();
+
+	/* Returns broadcaster of the world, spawning it on first use. Null on clients */
+	static ACombatBroadcaster *			Get( UWorld * World, bool bSpawnIfMissing = true );
+
+	/* Starts sending the stream of this arena to the relay. False if the address is invalid */
+	bool								StartBroadcast( const FString & RelayAddress, uint16 InArenaId );
+
+	/* Called by saber on server when it is thrown */
+	void								RecordSaberLaunch( AHuman * Human, float MaxFlyDistance );
+
+	virtual void						Tick( float DeltaTime ) override;
+
+	/* Packets and bytes sent and time spent packing since the broadcast started */
+	void								LogStats() const;
+
+protected:
+	virtual void						EndPlay( const EEndPlayReason::Type EndPlayReason ) override;
+
+	UPROPERTY( Config )
+	float								PacketsPerSecond;
+
+	/* Number of frames every saber launch is repeated in */
+	UPROPERTY( Config )
+	int32								LaunchRepeats;
+
+private:
+	void								SendFrame();
+
+	void								SendPacket( FCombatBroadcastPacket & Packet );
+
+	struct FPendingLaunch
+	{
+		FBroadcastSaberLaunch			Launch;
+		int32							RepeatsLeft = 0;
+	};
+
+	FSocket *							m_Socket;
+	TSharedPtr<FInternetAddr>			m_RelayAddress;
+	uint16								m_ArenaId;
+
+	TArray<FPendingLaunch>				m_Launches;
+	uint32								m_NextLaunchId;
+
+	TArray<FBroadcastHuman>				m_Humans;
+	uint32								m_Sequence;
+	float								m_TimeToSend;
+
+	uint64								m_NumPackets;
+	uint64								m_NumBytes;
+	double								m_PackSeconds;
+};
@@ -0,0 +1,236 @@
+#include "CombatClock.h"
+#include "GameFramework/PlayerController.h"
+#include "GameFramework/GameStateBase.h"
+#include "Engine/World.h"
+#include "UnrealNetwork.h"
+
+static FAutoConsoleCommandWithWorld CombatClockStatsCommand(
+	TEXT( "swa.ClockStats" ),
+	TEXT( "Logs server time offset, round trip and jitter of the local player's combat clock." ),
+	FConsoleCommandWithWorldDelegate::CreateLambda( []( UWorld * World )
+	{
+		if( UCombatClockComponent * Clock = UCombatClockComponent::Find( World ) )
+			Clock->LogStats();
+		else
+			UE_LOG( LogTemp, Display, TEXT( "No combat clock, server time is exact here: %.4f" ), UCombatClockComponent::GetServerTime( World ) );
+	} ) );
+
+namespace
+{
+	/* Server time is real time since the first call in the server process. World time is frozen for a frame,
+	dilated and clamped on hitches, so pongs and combat events stamped with it would disagree with a client
+	estimate built on platform seconds */
+	double ServerClockTime()
+	{
+		static const double Epoch = FPlatformTime::Seconds();
+		return FPlatformTime::Seconds() - Epoch;
+	}
+
+	/* Replicated world time, only used until the first sample arrives */
+	double ServerWorldTime( const UWorld * World )
+	{
+		const AGameStateBase * GameState = World ? World->GetGameState() : nullptr;
+		return GameState ? GameState->GetServerWorldTimeSeconds() : 0.0;
+	}
+}
+
+UCombatClockComponent::UCombatClockComponent() :
+	PingInterval( 0.5f ),
+	FastPingInterval( 0.1f ),
+	FastPingCount( 8 ),
+	SampleWindow( 16 ),
+	MaxSlewRate( 0.05f ),
+	SnapThreshold( 0.25f ),
+	InterpolationDelay( 0.05f ),
+	JitterDelayScale( 3.f ),
+	MaxInterpolationDelay( 0.25f ),
+	DelaySlewRate( 0.25f ),
+	MaxExtrapolation( 0.1f ),
+	m_WorldTimeToServerTime( 0.0 ),
+	m_LocalEpoch( 0.0 ),
+	m_Offset( 0.0 ),
+	m_TargetOffset( 0.0 ),
+	m_NextSample( 0 ),
+	m_NumSamples( 0 ),
+	m_RoundTripTime( 0.f ),
+	m_LastRoundTripTime( 0.f ),
+	m_Jitter( 0.f ),
+	m_PingTimer( 0.f ),
+	m_InterpolationDelay( 0.f ),
+	m_LastServerTime( 0.0 )
+{
+	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.bStartWithTickEnabled = false;
+
+	SetIsReplicated( true );
+}
+
+UCombatClockComponent * UCombatClockComponent::AddTo( APlayerController * PlayerController )
+{
+	if( !PlayerController || !PlayerController->HasAuthority() )
+		return nullptr;
+
+	if( UCombatClockComponent * Clock = PlayerController->FindComponentByClass<UCombatClockComponent>() )
+		return Clock;
+
+	UCombatClockComponent * Clock = NewObject<UCombatClockComponent>( PlayerController, TEXT( "CombatClock" ) );
+	Clock->m_WorldTimeToServerTime = ServerClockTime() - PlayerController->GetWorld()->GetTimeSeconds();
+	Clock->RegisterComponent();
+
+	return Clock;
+}
+
+UCombatClockComponent * UCombatClockComponent::Find( const UWorld * World )
+{
+	if( !World || World->GetNetMode() != NM_Client )
+		return nullptr;
+
+	APlayerController * PlayerController = World->GetFirstPlayerController();
+
+	return PlayerController ? PlayerController->FindComponentByClass<UCombatClockComponent>() : nullptr;
+}
+
+double UCombatClockComponent::GetServerTime( const UWorld * World )
+{
+	if( !World )
+		return 0.0;
+
+	if( World->GetNetMode() != NM_Client )
+		return ServerClockTime();
+
+	const UCombatClockComponent * Clock = Find( World );
+
+	return Clock ? Clock->GetServerTime() : ServerWorldTime( World );
+}
+
+float UCombatClockComponent::GetRoundTripTime( const UWorld * World )
+{
+	const UCombatClockComponent * Clock = Find( World );
+
+	return Clock ? Clock->GetRoundTripTime() : 0.f;
+}
+
+float UCombatClockComponent::GetJitter( const UWorld * World )
+{
+	const UCombatClockComponent * Clock = Find( World );
+
+	return Clock ? Clock->GetJitter() : 0.f;
+}
+
+void UCombatClockComponent::GetLifetimeReplicatedProps( TArray<FLifetimeProperty> & OutLifetimeProps ) const
+{
+	Super::GetLifetimeReplicatedProps( OutLifetimeProps );
+
+	DOREPLIFETIME_CONDITION( UCombatClockComponent, m_WorldTimeToServerTime, COND_InitialOnly );
+}
+
+void UCombatClockComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	m_LocalEpoch = FPlatformTime::Seconds();
+	m_Samples.SetNum( FMath::Max( SampleWindow, 1 ) );
+	m_InterpolationDelay = InterpolationDelay;
+
+	/* Only the owning client measures, server just answers pings */
+	const APlayerController * PlayerController = Cast<APlayerController>( GetOwner() );
+	SetComponentTickEnabled( PlayerController && PlayerController->IsLocalController() && GetOwnerRole() != ROLE_Authority );
+}
+
+void UCombatClockComponent::TickComponent( float DeltaTime, ELevelTick TickType, FActorComponentTickFunction * ThisTickFunction )
+{
+	Super::TickComponent( DeltaTime, TickType, ThisTickFunction );
+
+	m_PingTimer -= DeltaTime;
+	if( m_PingTimer <= 0.f )
+	{
+		m_PingTimer = m_NumSamples < FastPingCount ? FastPingInterval : PingInterval;
+		Server_Ping( float( FPlatformTime::Seconds() - m_LocalEpoch ), m_RoundTripTime, m_Jitter );
+	}
+
+	if( !HasEstimate() )
+		return;
+
+	const double Error = m_TargetOffset - m_Offset;
+	const double MaxStep = MaxSlewRate * DeltaTime;
+
+	m_Offset = FMath::Abs( Error ) > SnapThreshold ? m_TargetOffset : m_Offset + FMath::Clamp( Error, -MaxStep, MaxStep );
+
+	const float TargetDelay = FMath::Clamp( InterpolationDelay + JitterDelayScale * m_Jitter, InterpolationDelay, MaxInterpolationDelay );
+	m_InterpolationDelay = FMath::FInterpConstantTo( m_InterpolationDelay, TargetDelay, DeltaTime, DelaySlewRate );
+}
+
+double UCombatClockComponent::GetServerTime() const
+{
+	if( GetOwnerRole() == ROLE_Authority )
+		return ServerClockTime();
+
+	/* World time mapped with the offset of login, drifts by server hitches since then until a sample replaces it */
+	if( !HasEstimate() )
+		return FMath::Max( ServerWorldTime( GetWorld() ) + m_WorldTimeToServerTime, m_LastServerTime );
+
+	m_LastServerTime = FMath::Max( FPlatformTime::Seconds() + m_Offset, m_LastServerTime );
+
+	return m_LastServerTime;
+}
+
+void UCombatClockComponent::Server_Ping_Implementation( float ClientTime, float RoundTripTime, float Jitter )
+{
+	/* Client's own estimates, so server knows the connection for rewinding */
+	m_RoundTripTime = RoundTripTime;
+	m_Jitter = Jitter;
+
+	Client_Pong( ClientTime, ServerClockTime() );
+}
+
+void UCombatClockComponent::Client_Pong_Implementation( float ClientTime, double ServerTime )
+{
+	const double Now = FPlatformTime::Seconds();
+	const float RoundTripTime = float( Now - m_LocalEpoch ) - ClientTime;
+
+	if( RoundTripTime < 0.f || m_Samples.Num() == 0 )
+		return;
+
+	/* Server stamped the reply about half a round trip ago */
+	FSample & Sample = m_Samples[ m_NextSample ];
+	Sample.RoundTripTime = RoundTripTime;
+	Sample.Offset = ServerTime + RoundTripTime * 0.5 - Now;
+
+	m_NextSample = ( m_NextSample + 1 ) % m_Samples.Num();
+
+	if( m_NumSamples == 0 )
+	{
+		m_RoundTripTime = RoundTripTime;
+		m_Offset = Sample.Offset;
+	}
+	else
+	{
+		m_RoundTripTime += ( RoundTripTime - m_RoundTripTime ) * 0.125f;
+		m_Jitter += ( FMath::Abs( RoundTripTime - m_LastRoundTripTime ) - m_Jitter ) / 16.f;
+	}
+
+	m_LastRoundTripTime = RoundTripTime;
+	m_NumSamples = FMath::Min( m_NumSamples + 1, m_Samples.Num() );
+
+	const FSample * Best = &m_Samples[ 0 ];
+	for( int32 i = 1; i < m_NumSamples; ++i )
+	{
+		if( m_Samples[ i ].RoundTripTime < Best->RoundTripTime )
+			Best = &m_Samples[ i ];
+	}
+
+	m_TargetOffset = Best->Offset;
+}
+
+void UCombatClockComponent::LogStats() const
+{
+	UE_LOG( LogTemp, Display, TEXT( "Combat clock of %s: server time %.4f, offset %.4f ( target %.4f ), round trip %.1f ms, jitter %.1f ms, interpolation delay %.1f ms, %d samples" ),
+			*GetNameSafe( GetOwner() ),
+			GetServerTime(),
+			m_Offset,
+			m_TargetOffset,
+			m_RoundTripTime * 1000.f,
+			m_Jitter * 1000.f,
+			m_InterpolationDelay * 1000.f,
+			m_NumSamples );
+}
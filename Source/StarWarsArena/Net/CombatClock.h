@@ -0,0 +1,150 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "CombatClock.generated.h"
+
+class APlayerController;
+
+/**
+* Server clock estimate of one connection, lives on its player controller ( added by the game mode on login ).
+* Owning client pings the server with unreliable RPCs. Of the last SampleWindow samples the one with the lowest
+* round trip gives the offset, since queueing delay only ever adds to a sample. Jitter is smoothed round trip
+* variation as in RFC 3550. Offset corrections are slewed and server time never goes backwards on a client.
+* Server time is the server's platform seconds since its first use, real time like the client's estimate. World time
+* is frozen within a frame and clamped on hitches, so it is only the fallback before the first sample, mapped onto
+* server time with an offset replicated once when the clock is added. On server itself it is exact.
+*/
+UCLASS( NotPlaceable, Transient, Config = Game )
+class STARWARSARENA_API UCombatClockComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	UCombatClockComponent();
+
+	virtual void						GetLifetimeReplicatedProps( TArray<FLifetimeProperty>& OutLifetimeProps ) const override;
+
+	/* Server only. Adds the clock to a newly logged in player, does nothing if it already has one */
+	static UCombatClockComponent *		AddTo( APlayerController * PlayerController );
+
+	/* Clock of the first local player, null on server and before login */
+	static UCombatClockComponent *		Find( const UWorld * World );
+
+	/* Monotonic server time. Exact on server, estimated on clients, mapped world time until the first sample arrives */
+	static double						GetServerTime( const UWorld * World );
+
+	/* Round trip and jitter of the local player's connection in seconds, reported by the client on server */
+	static float						GetRoundTripTime( const UWorld * World );
+
+	static float						GetJitter( const UWorld * World );
+
+	virtual void						TickComponent( float DeltaTime, ELevelTick TickType, FActorComponentTickFunction * ThisTickFunction ) override;
+
+	/* Monotonic estimate of server time on this machine */
+	double								GetServerTime() const;
+
+	/* Converts a server timestamp to local platform seconds, for measuring time since a replicated event */
+	double								ServerToLocalTime( double ServerTime ) const					{ return ServerTime - m_Offset; }
+
+	float								GetRoundTripTime() const										{ return m_RoundTripTime; }
+
+	float								GetJitter() const												{ return m_Jitter; }
+
+	bool								HasEstimate() const												{ return m_NumSamples > 0; }
+
+	/* Delay remote combat state is played back with, InterpolationDelay plus JitterDelayScale times jitter */
+	float								GetInterpolationDelay() const									{ return m_InterpolationDelay; }
+
+	float								GetMaxExtrapolation() const										{ return MaxExtrapolation; }
+
+	void								LogStats() const;
+
+protected:
+	virtual void						BeginPlay() override;
+
+	/* Seconds between pings once synchronized */
+	UPROPERTY( Config, EditDefaultsOnly, Category = "Clock" )
+	float								PingInterval;
+
+	/* First pings go faster, so a fresh client has a good estimate within a second */
+	UPROPERTY( Config, EditDefaultsOnly, Category = "Clock" )
+	float								FastPingInterval;
+
+	UPROPERTY( Config, EditDefaultsOnly, Category = "Clock" )
+	int32								FastPingCount;
+
+	/* Number of recent samples the lowest round trip is picked from */
+	UPROPERTY( Config, EditDefaultsOnly, Category = "Clock" )
+	int32								SampleWindow;
+
+	/* Seconds of offset correction per second of time. Errors larger than SnapThreshold are applied at once */
+	UPROPERTY( Config, EditDefaultsOnly, Category = "Clock" )
+	float								MaxSlewRate;
+
+	UPROPERTY( Config, EditDefaultsOnly, Category = "Clock" )
+	float								SnapThreshold;
+
+	/* Interpolation delay on a connection without jitter */
+	UPROPERTY( Config, EditDefaultsOnly, Category = "Interpolation" )
+	float								InterpolationDelay;
+
+	UPROPERTY( Config, EditDefaultsOnly, Category = "Interpolation" )
+	float								JitterDelayScale;
+
+	UPROPERTY( Config, EditDefaultsOnly, Category = "Interpolation" )
+	float								MaxInterpolationDelay;
+
+	/* Seconds of delay change per second. Below 1, so render time keeps moving forward while delay grows */
+	UPROPERTY( Config, EditDefaultsOnly, Category = "Interpolation" )
+	float								DelaySlewRate;
+
+	/* Seconds remote transforms are extrapolated past the newest sample */
+	UPROPERTY( Config, EditDefaultsOnly, Category = "Interpolation" )
+	float								MaxExtrapolation;
+
+private:
+	/* Client send time is local platform seconds since BeginPlay, small enough for a float */
+	UFUNCTION( Server, Unreliable, WithValidation )
+	void								Server_Ping( float ClientTime, float RoundTripTime, float Jitter );
+	void								Server_Ping_Implementation( float ClientTime, float RoundTripTime, float Jitter );
+	bool								Server_Ping_Validate( float ClientTime, float RoundTripTime, float Jitter ) { return true; }
+
+	UFUNCTION( Client, Unreliable )
+	void								Client_Pong( float ClientTime, double ServerTime );
+	void								Client_Pong_Implementation( float ClientTime, double ServerTime );
+
+	struct FSample
+	{
+		float							RoundTripTime;
+		double							Offset;
+	};
+
+	/* Server time minus server world time when the clock was added, maps replicated world time for the fallback */
+	UPROPERTY( Replicated )
+	double								m_WorldTimeToServerTime;
+
+	/* Local platform seconds BeginPlay happened at */
+	double								m_LocalEpoch;
+
+	/* Server time minus local platform seconds, applied and target */
+	double								m_Offset;
+	double								m_TargetOffset;
+
+	TArray<FSample>						m_Samples;
+	int32								m_NextSample;
+	int32								m_NumSamples;
+
+	float								m_RoundTripTime;
+	float								m_LastRoundTripTime;
+	float								m_Jitter;
+
+	float								m_PingTimer;
+
+	float								m_InterpolationDelay;
+
+	/* Last returned server time, keeps it monotonic while offset is slewed back */
+	mutable double						m_LastServerTime;
+};
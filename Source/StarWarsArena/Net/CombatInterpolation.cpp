@@ -0,0 +1,100 @@
+#include "CombatInterpolation.h"
+#include "CombatClock.h"
+#include "Engine/World.h"
+
+static TAutoConsoleVariable<int32> CVarCombatInterpolation(
+	TEXT( "swa.CombatInterpolation" ),
+	1,
+	TEXT( "Remote combat state on clients.\n" )
+	TEXT( " 0: apply on arrival\n" )
+	TEXT( " 1: play at server time minus jitter sized interpolation delay" ) );
+
+bool CombatInterpolation::IsActive( const UWorld * World )
+{
+	if( CVarCombatInterpolation.GetValueOnGameThread() <= 0 )
+		return false;
+
+	const UCombatClockComponent * Clock = UCombatClockComponent::Find( World );
+
+	return Clock && Clock->HasEstimate();
+}
+
+double CombatInterpolation::GetRenderTime( const UWorld * World )
+{
+	const UCombatClockComponent * Clock = UCombatClockComponent::Find( World );
+
+	return Clock ? Clock->GetServerTime() - Clock->GetInterpolationDelay() : UCombatClockComponent::GetServerTime( World );
+}
+
+float CombatInterpolation::GetMaxExtrapolation()
+{
+	return GetDefault<UCombatClockComponent>()->GetMaxExtrapolation();
+}
+
+void FTransformInterpolationBuffer::Add( double ServerTime, const FTransform & Transform )
+{
+	int32 Index = m_Samples.Num();
+	while( Index > 0 && m_Samples[ Index - 1 ].Time > ServerTime )
+		--Index;
+
+	/* Older than everything in a full buffer, nothing to interpolate it with */
+	if( Index == 0 && m_Samples.Num() == Capacity )
+		return;
+
+	if( m_Samples.Num() == Capacity )
+	{
+		m_Samples.RemoveAt( 0, 1, false );
+		--Index;
+	}
+
+	m_Samples.Insert( FTimedTransform{ ServerTime, Transform }, Index );
+}
+
+bool FTransformInterpolationBuffer::Sample( double RenderTime, float MaxExtrapolation, FTransform & OutTransform )
+{
+	if( m_Samples.Num() == 0 )
+		return false;
+
+	/* Two samples at or before render time are kept, the older one gives velocity for extrapolation */
+	while( m_Samples.Num() > 2 && m_Samples[ 2 ].Time <= RenderTime )
+		m_Samples.RemoveAt( 0, 1, false );
+
+	const int32 Last = m_Samples.Num() - 1;
+
+	if( RenderTime <= m_Samples[ 0 ].Time )
+	{
+		OutTransform = m_Samples[ 0 ].Transform;
+		return true;
+	}
+
+	if( RenderTime < m_Samples[ Last ].Time )
+	{
+		const int32 FromIndex = m_Samples[ 1 ].Time <= RenderTime ? 1 : 0;
+		const FTimedTransform & From = m_Samples[ FromIndex ];
+		const FTimedTransform & To = m_Samples[ FromIndex + 1 ];
+		const float Alpha = float( ( RenderTime - From.Time ) / ( To.Time - From.Time ) );
+
+		OutTransform.SetLocation( FMath::Lerp( From.Transform.GetLocation(), To.Transform.GetLocation(), Alpha ) );
+		OutTransform.SetRotation( FQuat::Slerp( From.Transform.GetRotation(), To.Transform.GetRotation(), Alpha ) );
+		OutTransform.SetScale3D( To.Transform.GetScale3D() );
+		return true;
+	}
+
+	/* Newest sample is behind render time, samples are late or lost. Continue the last step for a short while */
+	OutTransform = m_Samples[ Last ].Transform;
+
+	if( Last > 0 && MaxExtrapolation > 0.f )
+	{
+		const FTimedTransform & Prev = m_Samples[ Last - 1 ];
+		const FTimedTransform & Newest = m_Samples[ Last ];
+		const float StepTime = float( Newest.Time - Prev.Time );
+
+		if( StepTime > KINDA_SMALL_NUMBER )
+		{
+			const float ExtrapolationTime = FMath::Min( float( RenderTime - Newest.Time ), MaxExtrapolation );
+			OutTransform.AddToTranslation( ( Newest.Transform.GetLocation() - Prev.Transform.GetLocation() ) * ( ExtrapolationTime / StepTime ) );
+		}
+	}
+
+	return true;
+}
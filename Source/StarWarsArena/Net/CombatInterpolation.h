@@ -0,0 +1,89 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class UWorld;
+
+/**
+* Remote humans and sabers on clients play server stamped combat events at render time,
+* which is server time minus an interpolation delay sized by the connection's jitter ( see UCombatClockComponent ).
+* Events arriving unevenly are then played as evenly as the server produced them.
+* swa.CombatInterpolation 0 applies everything on arrival.
+*/
+namespace CombatInterpolation
+{
+	/* True on clients with a synchronized combat clock and interpolation enabled */
+	STARWARSARENA_API bool				IsActive( const UWorld * World );
+
+	/* Server time remote state is shown at */
+	STARWARSARENA_API double			GetRenderTime( const UWorld * World );
+
+	/* How far past the newest sample transforms are extrapolated when samples are late or lost */
+	STARWARSARENA_API float				GetMaxExtrapolation();
+}
+
+/* Server stamped transforms of a remote actor, sampled at render time */
+class STARWARSARENA_API FTransformInterpolationBuffer
+{
+public:
+	static const int32					Capacity = 16;
+
+	/* Samples out of order are inserted by time, the oldest one is dropped when full */
+	void								Add( double ServerTime, const FTransform & Transform );
+
+	/* Interpolates between samples around RenderTime or extrapolates from the newest two for at most MaxExtrapolation.
+	Drops samples no longer needed. False if empty */
+	bool								Sample( double RenderTime, float MaxExtrapolation, FTransform & OutTransform );
+
+	void								Reset()																{ m_Samples.Reset(); }
+
+	bool								IsEmpty() const														{ return m_Samples.Num() == 0; }
+
+	/* Server time of the newest sample, zero if empty */
+	double								GetNewestTime() const												{ return m_Samples.Num() > 0 ? m_Samples.Last().Time : 0.0; }
+
+private:
+	struct FTimedTransform
+	{
+		double							Time;
+		FTransform						Transform;
+	};
+
+	TArray<FTimedTransform, TInlineAllocator<Capacity>>	m_Samples;
+};
+
+/* Server stamped discrete events of a remote actor, popped in order once render time reaches them */
+template<typename EventType>
+class TCombatEventQueue
+{
+public:
+	void								Push( double ServerTime, const EventType & Event )
+	{
+		int32 Index = m_Events.Num();
+		while( Index > 0 && m_Events[ Index - 1 ].Key > ServerTime )
+			--Index;
+
+		m_Events.Insert( TPairInitializer<double, EventType>( ServerTime, Event ), Index );
+	}
+
+	/* Oldest event due at RenderTime. Pass MAX_dbl to drain */
+	bool								PopDue( double RenderTime, EventType & OutEvent )
+	{
+		if( m_Events.Num() == 0 || m_Events[ 0 ].Key > RenderTime )
+			return false;
+
+		OutEvent = m_Events[ 0 ].Value;
+		m_Events.RemoveAt( 0, 1, false );
+
+		return true;
+	}
+
+	void								Reset()																{ m_Events.Reset(); }
+
+	bool								IsEmpty() const														{ return m_Events.Num() == 0; }
+
+private:
+	TArray<TPair<double, EventType>, TInlineAllocator<4>>	m_Events;
+};
@@ -0,0 +1,162 @@
+#include "CombatRelayCommandlet.h"
+#include "CombatBroadcast.h"
+#include "Sockets.h"
+#include "SocketSubsystem.h"
+#include "Common/UdpSocketBuilder.h"
+
+namespace
+{
+	struct FDelayedPacket
+	{
+		double							ReleaseTime = 0.0;
+		uint16							ArenaId = 0;
+		TArray<uint8>					Data;
+	};
+
+	struct FSpectator
+	{
+		TSharedPtr<FInternetAddr>		Address;
+		uint16							ArenaId = 0;
+		double							LastSeen = 0.0;
+	};
+}
+
+UCombatRelayCommandlet::UCombatRelayCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = false;
+	LogToConsole = true;
+}
+
+int32 UCombatRelayCommandlet::Main( const FString & Params )
+{
+	int32 IngestPort = 7790;
+	int32 SpectatorPort = 7791;
+	float Delay = 2.f;
+	float Timeout = 10.f;
+	int32 MaxSpectators = 4096;
+
+	FParse::Value( *Params, TEXT( "Ingest=" ), IngestPort );
+	FParse::Value( *Params, TEXT( "Spectators=" ), SpectatorPort );
+	FParse::Value( *Params, TEXT( "Delay=" ), Delay );
+	FParse::Value( *Params, TEXT( "Timeout=" ), Timeout );
+	FParse::Value( *Params, TEXT( "MaxSpectators=" ), MaxSpectators );
+
+	ISocketSubsystem * SocketSubsystem = ISocketSubsystem::Get( PLATFORM_SOCKETSUBSYSTEM );
+
+	FSocket * IngestSocket = FUdpSocketBuilder( TEXT( "CombatRelayIngest" ) ).AsNonBlocking().BoundToPort( IngestPort ).WithReceiveBufferSize( 1024 * 1024 ).Build();
+	FSocket * SpectatorSocket = FUdpSocketBuilder( TEXT( "CombatRelaySpectators" ) ).AsNonBlocking().BoundToPort( SpectatorPort ).WithSendBufferSize( 4 * 1024 * 1024 ).Build();
+
+	if( !IngestSocket || !SpectatorSocket )
+	{
+		UE_LOG( LogTemp, Error, TEXT( "Combat relay : can not bind ports %d and %d." ), IngestPort, SpectatorPort );
+		return 1;
+	}
+
+	UE_LOG( LogTemp, Display, TEXT( "Combat relay : ingest on %d, spectators on %d, %.1f s delay." ), IngestPort, SpectatorPort, Delay );
+
+	TArray<FDelayedPacket> Queue;
+	TMap<FString, FSpectator> Spectators;
+
+	uint8 Buffer[ 2048 ];
+	int32 BytesRead = 0;
+	TSharedRef<FInternetAddr> Sender = SocketSubsystem->CreateInternetAddr();
+
+	uint64 NumIn = 0, NumOut = 0, NumRejected = 0, BytesOut = 0;
+	double LastStatsTime = FPlatformTime::Seconds();
+
+	while( !GIsRequestingExit )
+	{
+		const double Now = FPlatformTime::Seconds();
+
+		/* Servers */
+		while( IngestSocket->RecvFrom( Buffer, sizeof( Buffer ), BytesRead, *Sender ) && BytesRead > 0 )
+		{
+			uint16 ArenaId;
+			if( !CombatBroadcast::PeekPacket( Buffer, BytesRead, ArenaId ) )
+			{
+				++NumRejected;
+				continue;
+			}
+
+			FDelayedPacket & Packet = Queue[ Queue.AddDefaulted() ];
+			Packet.ReleaseTime = Now + Delay;
+			Packet.ArenaId = ArenaId;
+			Packet.Data.Append( Buffer, BytesRead );
+			++NumIn;
+		}
+
+		/* Subscriptions, renewed by spectators every few seconds */
+		while( SpectatorSocket->RecvFrom( Buffer, sizeof( Buffer ), BytesRead, *Sender ) && BytesRead > 0 )
+		{
+			uint16 ArenaId;
+			if( !CombatBroadcast::ReadSubscribe( Buffer, BytesRead, ArenaId ) )
+				continue;
+
+			const FString Key = Sender->ToString( true );
+			FSpectator * Spectator = Spectators.Find( Key );
+
+			if( !Spectator )
+			{
+				if( Spectators.Num() >= MaxSpectators )
+					continue;
+
+				Spectator = &Spectators.Add( Key );
+				Spectator->Address = SocketSubsystem->CreateInternetAddr();
+				uint32 Ip = 0;
+				Sender->GetIp( Ip );
+				Spectator->Address->SetIp( Ip );
+				Spectator->Address->SetPort( Sender->GetPort() );
+			}
+
+			Spectator->ArenaId = ArenaId;
+			Spectator->LastSeen = Now;
+		}
+
+		/* Queue is in arrival order, so released packets are at its front */
+		int32 NumReleased = 0;
+		while( NumReleased < Queue.Num() && Queue[ NumReleased ].ReleaseTime <= Now )
+		{
+			const FDelayedPacket & Packet = Queue[ NumReleased++ ];
+
+			for( const TPair<FString, FSpectator> & Pair : Spectators )
+			{
+				if( Pair.Value.ArenaId != Packet.ArenaId )
+					continue;
+
+				int32 BytesSent = 0;
+				if( SpectatorSocket->SendTo( Packet.Data.GetData(), Packet.Data.Num(), BytesSent, *Pair.Value.Address ) )
+				{
+					++NumOut;
+					BytesOut += BytesSent;
+				}
+			}
+		}
+
+		if( NumReleased > 0 )
+			Queue.RemoveAt( 0, NumReleased, false );
+
+		for( auto It = Spectators.CreateIterator(); It; ++It )
+		{
+			if( Now - It.Value().LastSeen > Timeout )
+				It.RemoveCurrent();
+		}
+
+		if( Now - LastStatsTime >= 10.0 )
+		{
+			UE_LOG( LogTemp, Display, TEXT( "Combat relay : %d spectators, %llu packets in, %llu out ( %llu KB ), %llu rejected, %d queued." ),
+					Spectators.Num(), NumIn, NumOut, BytesOut / 1024, NumRejected, Queue.Num() );
+			LastStatsTime = Now;
+		}
+
+		FPlatformProcess::Sleep( 0.001f );
+	}
+
+	IngestSocket->Close();
+	SpectatorSocket->Close();
+	SocketSubsystem->DestroySocket( IngestSocket );
+	SocketSubsystem->DestroySocket( SpectatorSocket );
+
+	return 0;
+}
@@ -0,0 +1,24 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "CombatRelayCommandlet.generated.h"
+
+/**
+* Fan-out relay of the spectator combat stream, runs as its own process next to or away from the server:
+*	UE4Editor-Cmd StarWarsArena -run=CombatRelay -Ingest=7790 -Spectators=7791 -Delay=2
+* Game servers send packets to the ingest port. Spectators subscribe on the spectator port to one arena and get
+* its packets from there, held back by Delay seconds. Silent spectators are dropped after Timeout seconds.
+*/
+UCLASS()
+class UCombatRelayCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UCombatRelayCommandlet();
+
+	virtual int32						Main( const FString & Params ) override;
+};
@@ -0,0 +1,112 @@
+#include "NetPacking.h"
+#include "HAL/IConsoleManager.h"
+
+namespace
+{
+	struct FPackedPropertyCounter
+	{
+		uint64							NumWrites = 0;
+		uint64							PackedBits = 0;
+		uint64							RawBits = 0;
+	};
+
+	FPackedPropertyCounter				GCounters[ int32( ENetPackedProperty::Count ) ];
+
+	const TCHAR * PropertyName( ENetPackedProperty Property )
+	{
+		switch( Property )
+		{
+			case ENetPackedProperty::HumanStats :		return TEXT( "FHumanStats" );
+			case ENetPackedProperty::HumanSnapshot :	return TEXT( "FHumanCombatSnapshot" );
+			case ENetPackedProperty::SaberState :		return TEXT( "FSaberNetState" );
+			default :									return TEXT( "Unknown" );
+		}
+	}
+
+	/* Bits SerializeIntPacked writes for the value, one byte per started 7 bits */
+	int32 PackedIntBits( uint32 Value )
+	{
+		int32 NumBytes = 1;
+		while( Value >= 0x80 )
+		{
+			Value >>= 7;
+			++NumBytes;
+		}
+		return NumBytes * 8;
+	}
+}
+
+int32 NetPacking::SerializeStat( FArchive & Ar, int32 & Value )
+{
+	uint8 bSmall = Value >= 0 && Value < 128;
+	Ar.SerializeBits( &bSmall, 1 );
+
+	if( bSmall )
+	{
+		uint32 Small = Ar.IsSaving() ? uint32( Value ) : 0;
+		Ar.SerializeInt( Small, 128 );
+		Value = int32( Small );
+
+		return 1 + 7;
+	}
+
+	/* Zigzag keeps small negative deltas short */
+	uint32 ZigZag = Ar.IsSaving() ? ( uint32( Value ) << 1 ) ^ uint32( Value >> 31 ) : 0;
+	Ar.SerializeIntPacked( ZigZag );
+	Value = int32( ZigZag >> 1 ) ^ -int32( ZigZag & 1 );
+
+	return 1 + PackedIntBits( ZigZag );
+}
+
+int32 NetPacking::SerializeQuantized( FArchive & Ar, float & Value, float Max, int32 NumBits )
+{
+	const uint32 MaxQuantized = ( 1u << NumBits ) - 1;
+
+	uint32 Quantized = 0;
+	if( Ar.IsSaving() )
+		Quantized = Max > 0.f ? uint32( FMath::RoundToInt( FMath::Clamp( Value / Max, 0.f, 1.f ) * MaxQuantized ) ) : 0;
+
+	Ar.SerializeInt( Quantized, MaxQuantized + 1 );
+
+	if( Ar.IsLoading() )
+		Value = float( Quantized ) / MaxQuantized * Max;
+
+	return NumBits;
+}
+
+void NetPacking::RecordWrite( ENetPackedProperty Property, int32 PackedBits, int32 RawBits )
+{
+	FPackedPropertyCounter & Counter = GCounters[ int32( Property ) ];
+	++Counter.NumWrites;
+	Counter.PackedBits += PackedBits;
+	Counter.RawBits += RawBits;
+}
+
+void NetPacking::LogStats()
+{
+	for( int32 i = 0; i < int32( ENetPackedProperty::Count ); ++i )
+	{
+		const FPackedPropertyCounter & Counter = GCounters[ i ];
+		const double Saved = Counter.RawBits > 0 ? 100.0 * ( 1.0 - double( Counter.PackedBits ) / Counter.RawBits ) : 0.0;
+
+		UE_LOG( LogTemp, Log, TEXT( "%-22s : %llu writes, %llu bytes packed, %llu bytes unpacked, %.1f%% saved" ),
+				PropertyName( ENetPackedProperty( i ) ), Counter.NumWrites, ( Counter.PackedBits + 7 ) / 8, ( Counter.RawBits + 7 ) / 8, Saved );
+	}
+}
+
+void NetPacking::ResetStats()
+{
+	for( FPackedPropertyCounter & Counter : GCounters )
+		Counter = FPackedPropertyCounter();
+}
+
+static FAutoConsoleCommand NetPackingStatsCommand(
+	TEXT( "swa.NetPackingStats" ),
+	TEXT( "Logs bytes written by packed combat properties against their unpacked size. Argument 'reset' clears the counters." ),
+	FConsoleCommandWithArgsDelegate::CreateLambda( []( const TArray<FString> & Args )
+	{
+		NetPacking::LogStats();
+
+		if( Args.Num() > 0 && Args[ 0 ] == TEXT( "reset" ) )
+			NetPacking::ResetStats();
+	} ) );
@@ -0,0 +1,34 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/* Replicated structs with custom NetSerialize, counted separately */
+enum class ENetPackedProperty : uint8
+{
+	HumanStats,
+	HumanSnapshot,
+	SaberState,
+	Count
+};
+
+/**
+* Bit packing helpers for combat replication and counters of what packing saves.
+* Counters compare bits actually written against the size of the unpacked properties,
+* swa.NetPackingStats logs them.
+*/
+namespace NetPacking
+{
+	/* 1 bit flag, then 7 bits for 0..127 or a zigzag packed int for anything else ( negative deltas ) */
+	STARWARSARENA_API int32			SerializeStat( FArchive & Ar, int32 & Value );
+
+	/* Value in [0, Max] as an unsigned integer of NumBits bits */
+	STARWARSARENA_API int32			SerializeQuantized( FArchive & Ar, float & Value, float Max, int32 NumBits );
+
+	STARWARSARENA_API void			RecordWrite( ENetPackedProperty Property, int32 PackedBits, int32 RawBits );
+
+	STARWARSARENA_API void			LogStats();
+
+	STARWARSARENA_API void			ResetStats();
+}
@@ -1,18 +1,38 @@
-#define BLADE_CHANNEL				ECC_GameTraceChannel1    // Saber blade channel
-
 #include "Saber.h"
 #include "Human.h"
+#include "Combat/CombatManager.h"
+#include "Combat/CombatDebugDraw.h"
+#include "Net/NetPacking.h"
+#include "Net/CombatBroadcast.h"
+#include "Net/CombatClock.h"
+#include "Diagnostics/HitchWatchdog.h"
+#include "Diagnostics/CombatMemory.h"
+#include "Slicing/SliceManager.h"
+#include "StarWarsArenaGameState.h"
+#include "Engine/NetSerialization.h"
 #include "Components/BoxComponent.h"
 #include "Components/StaticMeshComponent.h"
+#include "Components/AudioComponent.h"
+#include "Materials/MaterialInstanceDynamic.h"
+#include "ProceduralMeshComponent.h"
 #include "Animation/AnimInstance.h"
 #include "Kismet/GameplayStatics.h"
 
+namespace
+{
+	/* Distance a ricocheting saber is moved off the surface it hit */
+	const float RicochetSkinDistance = 2.f;
+}
+
 ASaber::ASaber() :
 	m_Alpha( 0.f ),
 	m_eState( ESaberState::ESS_Closed ),
+	m_eAttachment( ESaberAttachment::ESA_Free ),
+	m_bAttachPending( false ),
 	m_pHuman( nullptr ),
 	BladeThickness( 0.05f ),
 	BladeLength( 1.f ),
+	BladeExtensionParameter( TEXT( "BladeExtension" ) ),
 	m_fMaxFlyDistance( 0.f ),
 	OpeningSpeed( 1.5f ),
 	ClosingSpeed( 2.0f ),
@@ -20,8 +40,34 @@ ASaber::ASaber() :
 	RotationSpeed( 35.f ),
 	FlySpeed( 20.f ),
 	ReturnSpeed( 30.f ),
-	MinDistanceToHuman( 80.f )
+	MinDistanceToHuman( 80.f ),
+	FlightCollisionRadius( 8.f ),
+	MaxRicochets( 2 ),
+	StickAngle( 30.f ),
+	StickDepth( 0.35f ),
+	StickDuration( 2.f ),
+	HumSound( nullptr ),
+	SwingSound( nullptr ),
+	ClashSound( nullptr ),
+	HitSound( nullptr ),
+	TurnOnSound( nullptr ),
+	TurnOffSound( nullptr ),
+	HumMaxAngularSpeed( 720.f ),
+	HumPitchRange( 1.f, 1.4f ),
+	HumVolumeRange( 0.6f, 1.f ),
+	m_PrevBladeRotation( FQuat::Identity ),
+	m_HumIntensity( 0.f ),
+	m_bReducedFidelity( false ),
+	m_BladeMaterial( nullptr ),
+	m_bMaterialExtension( false ),
+	m_AppliedBladeFraction( -1.f ),
+	m_FlightStep( FTransform::Identity ),
+	m_FlyDirection( FVector::ForwardVector ),
+	m_bFollowAim( true ),
+	m_NumRicochets( 0 )
 {
+	COMBAT_LLM_SCOPE( ECombatMemory::Sabers );
+
 	bReplicates = true;
 	bReplicateMovement = true;
 
@@ -29,10 +75,10 @@ ASaber::ASaber() :
 
 	Hilt = CreateDefaultSubobject< UStaticMeshComponent >( TEXT( "Hilt" ) );
 	RootComponent = Hilt;
+	/* Flight collision is swept asynchronously, see IssueFlightTrace. Hilt never needs overlap updates */
 	Hilt->SetCollisionResponseToAllChannels( ECollisionResponse::ECR_Ignore );
-	Hilt->SetCollisionResponseToChannel( ECC_WorldStatic, ECR_Overlap );
-
-	Hilt->OnComponentBeginOverlap.AddDynamic( this, &ASaber::HiltOverlap );
+	Hilt->SetCollisionEnabled( ECollisionEnabled::NoCollision );
+	Hilt->bGenerateOverlapEvents = false;
 
 	Blade = CreateDefaultSubobject< UStaticMeshComponent >( TEXT( "Blade" ) );
 	Blade->AttachToComponent( RootComponent, FAttachmentTransformRules::KeepRelativeTransform );
@@ -40,7 +86,14 @@ ASaber::ASaber() :
 	Blade->SetCollisionResponseToAllChannels( ECollisionResponse::ECR_Ignore );
 	Blade->SetCollisionResponseToChannel( BLADE_CHANNEL, ECollisionResponse::ECR_Overlap );
 
-	Blade->OnComponentBeginOverlap.AddDynamic( this, &ASaber::BladeOverlap );
+	/* Blade hits are queried in batch by ACombatManager, blade only has to be found by other queries.
+	Collision is enabled only while the blade is fully out, see UpdateBladeCollision */
+	Blade->bGenerateOverlapEvents = false;
+	Blade->SetCollisionEnabled( ECollisionEnabled::NoCollision );
+
+	HumAudio = CreateDefaultSubobject< UAudioComponent >( TEXT( "HumAudio" ) );
+	HumAudio->SetupAttachment( Blade );
+	HumAudio->bAutoActivate = false;
 }
 
 void ASaber::GetLifetimeReplicatedProps( TArray<FLifetimeProperty> & OutLifetimeProps ) const
@@ -48,8 +101,7 @@ void ASaber::GetLifetimeReplicatedProps( TArray<FLifetimeProperty> & OutLifetime
 	Super::GetLifetimeReplicatedProps( OutLifetimeProps );
 
 	//DOREPLIFETIME( ASaber, m_pHuman );
-	DOREPLIFETIME( ASaber, m_Alpha );
-	DOREPLIFETIME( ASaber, m_eState );
+	DOREPLIFETIME( ASaber, m_NetState );
 	DOREPLIFETIME( ASaber, m_fMaxFlyDistance );
 	//DOREPLIFETIME( ASaber, OpeningSpeed );
 	//DOREPLIFETIME( ASaber, ClosingSpeed );
@@ -57,86 +109,267 @@ void ASaber::GetLifetimeReplicatedProps( TArray<FLifetimeProperty> & OutLifetime
 	//DOREPLIFETIME( ASaber, BladeLength );
 }
 
+void ASaber::PreReplication( IRepChangedPropertyTracker & ChangedPropertyTracker )
+{
+	m_NetState.BladeFraction = GetBladeFraction();
+	m_NetState.State = m_eState;
+	m_NetState.Attachment = m_eAttachment;
+
+	Super::PreReplication( ChangedPropertyTracker );
+}
+
+void ASaber::OnRep_NetState()
+{
+	m_Alpha = m_NetState.BladeFraction * BladeLength;
+	UpdateBladeExtension();
+
+	/* Usually Multicast_SetSaberState was here first and this does nothing */
+	if( m_NetState.State != m_eState )
+		Multicast_SetSaberState_Implementation( m_NetState.State );
+
+	/* Stuck transform is the last flight sample, it arrives here even if its unreliable multicast was lost */
+	if( m_NetState.State == ESaberState::ESS_Stuck && m_TransformBuffer.GetNewestTime() < m_NetState.StuckServerTime )
+		Multicast_UpdateTransform_Implementation( FTransform( m_NetState.StuckRotation, m_NetState.StuckLocation ), true, m_NetState.StuckServerTime );
+
+	m_eAttachment = m_NetState.Attachment;
+	ApplyAttachment();
+}
+
+void ASaber::OnRep_Human()
+{
+	ApplyAttachment();
+}
+
+void ASaber::SetAttachment( ESaberAttachment NewAttachment )
+{
+	m_eAttachment = NewAttachment;
+	ApplyAttachment();
+}
+
+void ASaber::ApplyAttachment()
+{
+	static const FName HandSlot( TEXT( "SaberHand" ) );
+	static const FName BeltSlot( TEXT( "SaberBelt" ) );
+
+	m_bAttachPending = false;
+
+	if( m_eAttachment == ESaberAttachment::ESA_Free )
+	{
+		if( GetAttachParentActor() )
+			DetachFromActor( FDetachmentTransformRules::KeepWorldTransform );
+
+		return;
+	}
+
+	if( !m_pHuman )
+		return;
+
+	/* Attachment arrives as soon as server caught the saber, its last flight samples play up to InterpolationDelay later.
+	Attaching now would cut the return short, so it waits until render time passes the newest sample */
+	if( !HasAuthority() && !m_TransformBuffer.IsEmpty() && CombatInterpolation::IsActive( GetWorld() ) &&
+		CombatInterpolation::GetRenderTime( GetWorld() ) < m_TransformBuffer.GetNewestTime() )
+	{
+		m_bAttachPending = true;
+		return;
+	}
+
+	const FName SlotName = m_eAttachment == ESaberAttachment::ESA_Hand ? HandSlot : BeltSlot;
+	USkeletalMeshComponent * Mesh = m_pHuman->GetMesh();
+
+	if( RootComponent->GetAttachParent() == Mesh && RootComponent->GetAttachSocketName() == SlotName )
+		return;
+
+	AttachToComponent( Mesh, FAttachmentTransformRules( EAttachmentRule::SnapToTarget, true ), SlotName );
+
+	/* Flight is over, samples left behind must not move the attached saber */
+	m_TransformBuffer.Reset();
+}
+
+void ASaber::FollowReplicatedTransform()
+{
+	if( m_TransformBuffer.IsEmpty() || GetAttachParentActor() )
+		return;
+
+	FTransform Transform;
+	if( m_TransformBuffer.Sample( CombatInterpolation::GetRenderTime( GetWorld() ), CombatInterpolation::GetMaxExtrapolation(), Transform ) )
+		SetActorLocationAndRotation( Transform.GetLocation(), Transform.GetRotation() );
+}
+
+bool FSaberNetState::NetSerialize( FArchive & Ar, UPackageMap * Map, bool & bOutSuccess )
+{
+	int32 NumBits = NetPacking::SerializeQuantized( Ar, BladeFraction, 1.f, 8 );
+	int32 RawBits = 32 + 8 + 8;
+
+	uint32 PackedState = uint32( State );
+	Ar.SerializeInt( PackedState, 8 );
+	State = ESaberState( PackedState );
+	NumBits += 3;
+
+	uint32 PackedAttachment = uint32( Attachment );
+	Ar.SerializeInt( PackedAttachment, 4 );
+	Attachment = ESaberAttachment( PackedAttachment );
+	NumBits += 2;
+
+	if( State == ESaberState::ESS_Stuck )
+	{
+		SerializePackedVector<10, 24>( StuckLocation, Ar );
+		StuckRotation.SerializeCompressedShort( Ar );
+		Ar << StuckServerTime;
+		NumBits += 3 * 24 + 3 * 16 + 64;
+		RawBits += 3 * 32 + 3 * 32 + 64;
+	}
+
+	if( Ar.IsSaving() )
+		NetPacking::RecordWrite( ENetPackedProperty::SaberState, NumBits, RawBits );
+
+	bOutSuccess = true;
+	return true;
+}
+
 void ASaber::BeginPlay()
 {
+	COMBAT_LLM_SCOPE( ECombatMemory::Sabers );
+
 	Super::BeginPlay();
 	
 	bReplicates = true;
 	bReplicateMovement = false;
 
+	/* Blade is at full length, extension is drawn by the material if it has BladeExtensionParameter */
+	Blade->SetRelativeScale3D( FVector( BladeThickness, BladeThickness, BladeLength ) );
+
+	if( GetNetMode() != NM_DedicatedServer )
+		m_BladeMaterial = Blade->CreateDynamicMaterialInstance( 0 );
+
+	/* Materials without the parameter would pop the full blade in and out, those get the blade scaled instead */
+	float DefaultExtension = 0.f;
+	m_bMaterialExtension = m_BladeMaterial && m_BladeMaterial->GetScalarParameterValue( BladeExtensionParameter, DefaultExtension );
+
+	UpdateBladeExtension();
+	UpdateBladeCollision();
+
 	SetSaberState( ESaberState::ESS_Closing );
-	UpdateTransform( GetTransform() );
+
+	if( ACombatManager * CombatManager = ACombatManager::Get( GetWorld() ) )
+		CombatManager->RegisterSaber( this );
+}
+
+void ASaber::EndPlay( const EEndPlayReason::Type EndPlayReason )
+{
+	if( ACombatManager * CombatManager = ACombatManager::Get( GetWorld(), false ) )
+		CombatManager->UnregisterSaber( this );
+
+	Super::EndPlay( EndPlayReason );
 }
 
 void ASaber::Tick(float DeltaTime)
 {
+	HITCH_TIMER( GetWorld(), EHitchTimer::Saber );
+	COMBAT_LLM_SCOPE( ECombatMemory::Sabers );
+
 	Super::Tick(DeltaTime);
 
+	if( GetNetMode() != NM_DedicatedServer && !m_bReducedFidelity )
+		UpdateHum( DeltaTime );
+
+	/* Blade of a reduced saber jumps with replicated state */
+	const bool bInterpolateBlade = HasAuthority() || !m_bReducedFidelity;
+
+	/* State may already be Opened, buffered flight is played to its end before the saber goes to the hand */
+	if( m_bAttachPending )
+	{
+		FollowReplicatedTransform();
+		ApplyAttachment();
+	}
+
 	switch ( m_eState )
 	{
 		/* Opening/closing saber */
 		case ESaberState::ESS_Opening :
 		{
+			if( !bInterpolateBlade )
+				break;
+
 			m_Alpha = FMath::Clamp( m_Alpha + DeltaTime * OpeningSpeed, 0.f, BladeLength );
+			UpdateBladeExtension();
 
-			if( m_Alpha >= BladeLength )
+			/* Every machine interpolates on its own, server finishes the state */
+			if( HasAuthority() && m_Alpha >= BladeLength )
 				SetSaberState( ESaberState::ESS_Opened );
 
-			UpdateTransform( GetTransform() );
-
 			break;
 		}
 
 		case ESaberState::ESS_Closing :
 		{
+			if( !bInterpolateBlade )
+				break;
+
 			m_Alpha = FMath::Clamp( m_Alpha - DeltaTime * ClosingSpeed, 0.f, BladeLength );
+			UpdateBladeExtension();
 
-			if( m_Alpha <= 0.f )
+			if( HasAuthority() && m_Alpha <= 0.f )
 				SetSaberState( ESaberState::ESS_Closed );
 
-			UpdateTransform( GetTransform() );
-
 			break;
 		}
 
 		/* Saber throw */
 		case ESaberState::ESS_Flying :
 		{
+			if( !HasAuthority() )
+			{
+				FollowReplicatedTransform();
+				break;
+			}
+
 			if( !m_pHuman )
 			{
 				UE_LOG( LogTemp, Error, TEXT( "%s : saber does not have human attached, but State is Flying." ), *GetName() );
 				return;
 			}
 
-			FVector FlyDirection = m_pHuman->GetControlRotation().Vector();
+			if( m_bFollowAim )
+				m_FlyDirection = m_pHuman->GetControlRotation().Vector();
 
-			if( FVector::Distance( GetActorLocation(), m_pHuman->GetActorLocation() ) < m_fMaxFlyDistance )
-			{
-				FTransform NewTransform( GetActorTransform() );
-				
-				NewTransform.SetLocation( GetActorLocation() + FlyDirection * FlySpeed );
-				NewTransform.SetRotation( FQuat( GetActorRotation() ) * FQuat( RotationDirection * RotationSpeed ) );
-
-				DrawDebugLine(
-					GetWorld(), 
-					GetActorLocation(), NewTransform.GetLocation(), 
-					FColor::Green, 
-					false, 15.f, 0, 
-					5.f );
-
-				UpdateTransform( NewTransform, true );				
-			}
-			else
+			/* Step swept last frame is taken now, so a hit stops the saber exactly where it happened */
+			FTransform NewTransform = GetActorTransform();
+			if( m_FlightTrace.IsValid() && !ConsumeFlightTrace( NewTransform ) )
+				break;
+
+			COMBAT_DEBUG( GetWorld(), AddLine( ECombatDebugCategory::SaberPath, GetActorLocation(), NewTransform.GetLocation(), FColor::Green, 15.f ) );
+
+			UpdateTransform( NewTransform, true );
+
+			if( m_NumRicochets >= MaxRicochets || FVector::Distance( NewTransform.GetLocation(), m_pHuman->GetActorLocation() ) >= m_fMaxFlyDistance )
 			{
 				SetSaberState( ESaberState::ESS_Returning );
+				break;
 			}
-			
+
+			IssueFlightTrace( NewTransform, StepFlight( NewTransform, m_FlyDirection, FlySpeed, RotationDirection * RotationSpeed ) );
+
+			break;
+		}
+
+		case ESaberState::ESS_Stuck :
+		{
+			/* Saber does not move, clients play the flight up to the stuck transform of m_NetState */
+			if( !HasAuthority() )
+				FollowReplicatedTransform();
+
 			break;
 		}
 
 		/* Saber return */
 		case ESaberState::ESS_Returning :
 		{
+			if( !HasAuthority() )
+			{
+				FollowReplicatedTransform();
+				break;
+			}
+
 			if( !m_pHuman )
 			{
 				UE_LOG( LogTemp, Error, TEXT( "%s : saber does not have human attached, but State is Returning." ), *GetName() );
@@ -174,6 +407,115 @@ void ASaber::Tick(float DeltaTime)
 	}
 }
 
+void ASaber::IssueFlightTrace( const FTransform & From, const FTransform & To )
+{
+	m_FlightStep = To;
+
+	FCollisionQueryParams Params( FName( TEXT( "SaberFlight" ) ), false, this );
+	if( m_pHuman )
+		Params.AddIgnoredActor( m_pHuman );
+
+	/* Walls, characters and open blades of other sabers */
+	FCollisionObjectQueryParams ObjectParams;
+	ObjectParams.AddObjectTypesToQuery( ECC_WorldStatic );
+	ObjectParams.AddObjectTypesToQuery( ECC_WorldDynamic );
+	ObjectParams.AddObjectTypesToQuery( ECC_Pawn );
+
+	/* Runs on worker threads during this frame, result is taken next frame */
+	m_FlightTrace = GetWorld()->AsyncSweepByObjectType( EAsyncTraceType::Single, From.GetLocation(), To.GetLocation(), ObjectParams,
+														FCollisionShape::MakeSphere( FlightCollisionRadius ), Params );
+}
+
+bool ASaber::ConsumeFlightTrace( FTransform & OutTransform )
+{
+	FTraceDatum Datum;
+	const bool bReady = GetWorld()->QueryTraceData( m_FlightTrace, Datum );
+	m_FlightTrace = FTraceHandle();
+
+	/* Trace was dropped ( world paused or frame skipped ), the step is swept again from where the saber is */
+	if( !bReady )
+		return true;
+
+	for( const FHitResult & Hit : Datum.OutHits )
+	{
+		/* Sweep starting in touch with the wall just ricocheted off, the saber is already leaving it */
+		if( Hit.bStartPenetrating && FVector::DotProduct( Hit.ImpactNormal, m_FlyDirection ) >= 0.f )
+			continue;
+
+		if( Hit.bBlockingHit )
+			return HandleFlightHit( Hit, OutTransform );
+	}
+
+	OutTransform = m_FlightStep;
+	return true;
+}
+
+bool ASaber::HandleFlightHit( const FHitResult & Hit, FTransform & OutTransform )
+{
+	AActor * HitActor = Hit.GetActor();
+
+	COMBAT_DEBUG( GetWorld(), AddPoint( ECombatDebugCategory::SaberPath, Hit.ImpactPoint, FColor::Orange, 15.f ) );
+
+	/* Character damage is resolved by the blade query of ACombatManager, flight just ends there */
+	if( Cast<APawn>( HitActor ) )
+	{
+		UpdateTransform( FTransform( m_FlightStep.GetRotation(), Hit.Location ), true );
+		SetSaberState( ESaberState::ESS_Returning );
+		OnSaberFlightHit( HitActor, Hit.ImpactPoint, Hit.ImpactNormal, ESaberState::ESS_Returning );
+		return false;
+	}
+
+	/* Head-on into a wall sticks, glancing hits and other blades ricochet */
+	const bool bWall = !Cast<ASaber>( HitActor );
+	if( bWall && FVector::DotProduct( -m_FlyDirection, Hit.ImpactNormal ) >= FMath::Cos( FMath::DegreesToRadians( StickAngle ) ) )
+	{
+		StickInWall( Hit );
+		OnSaberFlightHit( HitActor, Hit.ImpactPoint, Hit.ImpactNormal, ESaberState::ESS_Stuck );
+		return false;
+	}
+
+	m_FlyDirection = FMath::GetReflectionVector( m_FlyDirection, Hit.ImpactNormal );
+	m_bFollowAim = false;
+	++m_NumRicochets;
+
+	/* Next sweep starts a skin away from the surface, a sphere touching it would be reported as blocked right away */
+	OutTransform = FTransform( m_FlightStep.GetRotation(), Hit.Location + Hit.ImpactNormal * RicochetSkinDistance );
+
+	OnSaberFlightHit( HitActor, Hit.ImpactPoint, Hit.ImpactNormal, ESaberState::ESS_Flying );
+	return true;
+}
+
+void ASaber::StickInWall( const FHitResult & Hit )
+{
+	/* Blade points into the wall, StickDepth of it inside */
+	FVector BladeStart, BladeEnd;
+	float BladeRadius;
+	const float BladeSize = GetBladeSegment( BladeStart, BladeEnd, BladeRadius ) ? FVector::Distance( BladeStart, BladeEnd ) : 0.f;
+
+	const FTransform StuckTransform( FRotationMatrix::MakeFromZ( -Hit.ImpactNormal ).ToQuat(),
+									 Hit.ImpactPoint + Hit.ImpactNormal * BladeSize * ( 1.f - StickDepth ) );
+
+	UpdateTransform( StuckTransform, true );
+
+	m_NetState.StuckLocation = StuckTransform.GetLocation();
+	m_NetState.StuckRotation = StuckTransform.Rotator();
+	m_NetState.StuckServerTime = UCombatClockComponent::GetServerTime( GetWorld() );
+
+	SetSaberState( ESaberState::ESS_Stuck );
+
+	GetWorldTimerManager().SetTimer( m_StuckTimer, FTimerDelegate::CreateUObject( this, &ASaber::SetSaberState, ESaberState::ESS_Returning ), StickDuration, false );
+}
+
+FTransform ASaber::StepFlight( const FTransform & Current, const FVector & FlyDirection, float Speed, const FRotator & Spin )
+{
+	FTransform NewTransform( Current );
+
+	NewTransform.SetLocation( Current.GetLocation() + FlyDirection * Speed );
+	NewTransform.SetRotation( Current.GetRotation() * FQuat( Spin ) );
+
+	return NewTransform;
+}
+
 void ASaber::SetSaberState( ESaberState NewState )
 {
 	if( HasAuthority() )
@@ -199,6 +541,14 @@ void ASaber::Multicast_SetSaberState_Implementation( ESaberState NewState )
 
 	m_eState = NewState;
 
+	if( NewState == ESaberState::ESS_Opening )
+		PlaySaberSound( ESaberSoundCategory::ESSC_Power );
+	/* Saber starts closing from BeginPlay with the blade already in */
+	else if( NewState == ESaberState::ESS_Closing && m_Alpha > 0.f )
+		PlaySaberSound( ESaberSoundCategory::ESSC_Power );
+
+	UpdateBladeCollision();
+
 	OnSaberChangeState( NewState );
 }
 
@@ -212,18 +562,141 @@ ESaberState ASaber::GetSaberState()
 	return m_eState;
 }
 
-void ASaber::HiltOverlap( UPrimitiveComponent* OverlappedComp, 
-						  AActor* OtherActor, 
-						  UPrimitiveComponent* OtherComp, 
-						  int32 OtherBodyIndex, 
-						  bool bFromSweep, 
-						  const FHitResult& SweepResult 
-						)
+bool ASaber::GetBladeSegment( FVector & OutStart, FVector & OutEnd, float & OutRadius ) const
 {
-	UE_LOG( LogTemp, Warning, TEXT( "%s saber's hilt overlapping %s." ), *GetName(), *OtherActor->GetName() );
-	
-	if( m_eState == ESaberState::ESS_Flying )
-		SetSaberState( ESaberState::ESS_Returning );
+	if( m_Alpha <= 0.f || !Blade->GetStaticMesh() )
+		return false;
+
+	/* Blade mesh is extended along its local Z and scaled to full length, segment follows the drawn part */
+	const FBox LocalBox = Blade->GetStaticMesh()->GetBoundingBox();
+	const FVector LocalCenter = LocalBox.GetCenter();
+	const FTransform & BladeTransform = Blade->GetComponentTransform();
+	const float TipZ = FMath::Lerp( LocalBox.Min.Z, LocalBox.Max.Z, GetBladeFraction() );
+
+	OutStart = BladeTransform.TransformPosition( FVector( LocalCenter.X, LocalCenter.Y, LocalBox.Min.Z ) );
+	OutEnd = BladeTransform.TransformPosition( FVector( LocalCenter.X, LocalCenter.Y, TipZ ) );
+	OutRadius = LocalBox.GetExtent().X * BladeTransform.GetScale3D().X;
+
+	return true;
+}
+
+void ASaber::ResetForRound()
+{
+	GetWorldTimerManager().ClearAllTimersForObject( this );
+
+	/* Alpha goes first, so closing does not play the turn off sound */
+	m_Alpha = 0.f;
+	m_fMaxFlyDistance = 0.f;
+	m_TransformBuffer.Reset();
+	m_bAttachPending = false;
+	m_FlightTrace = FTraceHandle();
+	Multicast_SetSaberState_Implementation( ESaberState::ESS_Closed );
+
+	UpdateBladeExtension();
+
+	if( HumAudio->IsPlaying() )
+		HumAudio->Stop();
+	m_HumIntensity = 0.f;
+}
+
+void ASaber::PlaySaberSound( ESaberSoundCategory Category, float VolumeMultiplier )
+{
+	ASaberAudioManager * AudioManager = ASaberAudioManager::Get( GetWorld() );
+	if( !AudioManager )
+		return;
+
+	USoundBase * Sound = nullptr;
+
+	switch( Category )
+	{
+		case ESaberSoundCategory::ESSC_Swing :	Sound = SwingSound; break;
+		case ESaberSoundCategory::ESSC_Clash :	Sound = ClashSound; break;
+		case ESaberSoundCategory::ESSC_Hit :	Sound = HitSound; break;
+		case ESaberSoundCategory::ESSC_Power :	Sound = m_eState == ESaberState::ESS_Closing ? TurnOffSound : TurnOnSound; break;
+		default : break;
+	}
+
+	AudioManager->Play( Category, Sound, Blade->GetComponentLocation(), Blade, VolumeMultiplier );
+}
+
+void ASaber::SetReducedFidelity( bool bReduced, float TickInterval )
+{
+	if( HasAuthority() )
+		return;
+
+	m_bReducedFidelity = bReduced;
+	SetActorTickInterval( bReduced ? TickInterval : 0.f );
+
+	if( bReduced && HumAudio->IsPlaying() )
+	{
+		HumAudio->Stop();
+		m_HumIntensity = 0.f;
+	}
+}
+
+void ASaber::UpdateBladeExtension()
+{
+	const float Fraction = GetBladeFraction();
+	if( Fraction == m_AppliedBladeFraction )
+		return;
+
+	/* Only flips visibility at the ends, no transform or overlap update while igniting */
+	if( m_AppliedBladeFraction < 0.f || ( Fraction > 0.f ) != ( m_AppliedBladeFraction > 0.f ) )
+		Blade->SetVisibility( Fraction > 0.f );
+
+	m_AppliedBladeFraction = Fraction;
+
+	if( m_bMaterialExtension )
+	{
+		m_BladeMaterial->SetScalarParameterValue( BladeExtensionParameter, Fraction );
+	}
+	else if( m_BladeMaterial && Fraction > 0.f )
+	{
+		/* Local only, collision is off until the blade is fully out and the server never scales */
+		Blade->SetRelativeScale3D( FVector( BladeThickness, BladeThickness, BladeLength * Fraction ) );
+	}
+}
+
+void ASaber::UpdateBladeCollision()
+{
+	/* Other queries only see the blade when it is fully out, partial blade is covered by GetBladeSegment */
+	const bool bFullBlade = m_eState == ESaberState::ESS_Opened || m_eState == ESaberState::ESS_Flying ||
+							m_eState == ESaberState::ESS_Returning || m_eState == ESaberState::ESS_Stuck;
+
+	Blade->SetCollisionEnabled( bFullBlade ? ECollisionEnabled::QueryOnly : ECollisionEnabled::NoCollision );
+}
+
+void ASaber::UpdateHum( float DeltaTime )
+{
+	if( !HumSound || m_Alpha <= 0.f )
+	{
+		if( HumAudio->IsPlaying() )
+			HumAudio->Stop();
+
+		m_HumIntensity = 0.f;
+		m_PrevBladeRotation = Blade->GetComponentQuat();
+		return;
+	}
+
+	if( !HumAudio->IsPlaying() )
+	{
+		HumAudio->SetSound( HumSound );
+		HumAudio->Play();
+	}
+
+	/* Angle between blade rotations of two frames, blade moves with the hand socket and throw updates */
+	const FQuat BladeRotation = Blade->GetComponentQuat();
+	const float AngularSpeed = DeltaTime > 0.f ? FMath::RadiansToDegrees( BladeRotation.AngularDistance( m_PrevBladeRotation ) ) / DeltaTime : 0.f;
+	m_PrevBladeRotation = BladeRotation;
+
+	const float TargetIntensity = FMath::Clamp( AngularSpeed / FMath::Max( HumMaxAngularSpeed, 1.f ), 0.f, 1.f );
+	m_HumIntensity = FMath::FInterpTo( m_HumIntensity, TargetIntensity, DeltaTime, 10.f );
+
+	/* Hum fades in together with the blade */
+	const float BladeFactor = BladeLength > 0.f ? m_Alpha / BladeLength : 1.f;
+
+	HumAudio->SetPitchMultiplier( FMath::Lerp( HumPitchRange.X, HumPitchRange.Y, m_HumIntensity ) );
+	HumAudio->SetVolumeMultiplier( FMath::Lerp( HumVolumeRange.X, HumVolumeRange.Y, m_HumIntensity ) * BladeFactor );
 }
 
 void ASaber::BladeOverlap( UPrimitiveComponent* OverlappedComp, 
@@ -237,6 +710,8 @@ void ASaber::BladeOverlap( UPrimitiveComponent* OverlappedComp,
 	if( HasAuthority() )
 		Multicast_BladeOverlap( OtherActor );
 
+	PlaySaberSound( ESaberSoundCategory::ESSC_Hit );
+
 	AHuman * OtherHuman = Cast<AHuman>( OtherActor );
 	if( OtherHuman )
 	{
@@ -249,21 +724,47 @@ void ASaber::BladeOverlap( UPrimitiveComponent* OverlappedComp,
 	}
 	else
 	{
+		/* Sliceable objects are cut along the swing, the cut itself runs on workers */
+		UProceduralMeshComponent * ProcMesh = Cast<UProceduralMeshComponent>( OtherComp );
+		ACombatManager * CombatManager = ACombatManager::Get( GetWorld(), false );
+		FPlane SweepPlane;
+
+		if( ProcMesh && CombatManager && CombatManager->GetBladeSweepPlane( this, SweepPlane ) )
+		{
+			if( ASliceManager * SliceManager = ASliceManager::Get( GetWorld() ) )
+				SliceManager->RequestSlice( ProcMesh, FVector( SweepPlane ) * SweepPlane.W, FVector( SweepPlane ) );
+		}
+
 		OnBladeOverlapCPP( EBladeOverlapResult::EBOR_StaticMesh );
 	}
 }
 
+void ASaber::BladeClash( ASaber * OtherSaber, const FBladeClashResult & Clash, bool bInstigator )
+{
+	if( HasAuthority() && bInstigator )
+		Multicast_BladeClash( OtherSaber );
+
+	/* Both sabers of a clash are reported, one voice per clash is enough */
+	if( bInstigator )
+		PlaySaberSound( ESaberSoundCategory::ESSC_Clash, FMath::Clamp( Clash.RelativeVelocity.Size() / 500.f, 0.5f, 1.f ) );
+
+	OnBladeOverlapCPP( EBladeOverlapResult::EBOR_BladeClash );
+	OnBladeClash( Clash.ContactPoint, Clash.Normal, Clash.RelativeVelocity );
+}
+
 void ASaber::UpdateTransform( FTransform NewTransfrom, bool bUpdatePosition )
 {
 	if( HasAuthority() )
-		Multicast_UpdateTransform( NewTransfrom, bUpdatePosition );
+		Multicast_UpdateTransform( NewTransfrom, bUpdatePosition, UCombatClockComponent::GetServerTime( GetWorld() ) );
 	else
 		Server_UpdateTransform( NewTransfrom, bUpdatePosition );
 }
 
 void ASaber::Server_UpdateTransform_Implementation( FTransform NewTransfrom, bool bUpdatePosition )
-{	
-	Multicast_UpdateTransform( NewTransfrom, bUpdatePosition );
+{
+	HITCH_EVENT( GetWorld(), EHitchEvent::SaberTransform, this );
+
+	Multicast_UpdateTransform( NewTransfrom, bUpdatePosition, UCombatClockComponent::GetServerTime( GetWorld() ) );
 }
 
 bool ASaber::Server_UpdateTransform_Validate( FTransform NewTransfrom, bool bUpdatePosition )
@@ -271,13 +772,17 @@ bool ASaber::Server_UpdateTransform_Validate( FTransform NewTransfrom, bool bUpd
 	return true;
 }
 
-void ASaber::Multicast_UpdateTransform_Implementation( FTransform NewTransfrom, bool bUpdatePosition )
+void ASaber::Multicast_UpdateTransform_Implementation( FTransform NewTransfrom, bool bUpdatePosition, double ServerTime )
 {
+	if( bUpdatePosition && !HasAuthority() && CombatInterpolation::IsActive( GetWorld() ) )
+	{
+		m_TransformBuffer.Add( ServerTime, NewTransfrom );
+		return;
+	}
+
 	//UE_LOG( LogTemp, Warning, TEXT( "Server running UpdateTransform with %s. bUpdatePosistion is %d" ), 
 	//		*NewTransfrom.GetLocation().ToString(), bUpdatePosition);
 
-	Blade->SetRelativeScale3D( FVector( BladeThickness, BladeThickness, m_Alpha ) );
-
 	if( bUpdatePosition )
 	{
 		SetActorLocation( NewTransfrom.GetLocation() );
@@ -287,6 +792,8 @@ void ASaber::Multicast_UpdateTransform_Implementation( FTransform NewTransfrom,
 
 void ASaber::Server_BladeOverlap_Implementation( AActor * OverlappedActor )
 {
+	HITCH_EVENT( GetWorld(), EHitchEvent::BladeOverlap, this, OverlappedActor );
+
 	Multicast_BladeOverlap( OverlappedActor );
 }
 
@@ -327,7 +834,10 @@ void ASaber::Multicast_BladeOverlap_Implementation( AActor * OverlappedActor )
 		else
 		{
 			TSubclassOf<UDamageType> DamageType;
-			UGameplayStatics::ApplyDamage( OtherHuman, m_pHuman->GetCurrentlyPlayingAttack().DealtDamage, m_pHuman->GetController(), this, DamageType );
+			const float AppliedDamage = UGameplayStatics::ApplyDamage( OtherHuman, m_pHuman->GetCurrentlyPlayingAttack().DealtDamage, m_pHuman->GetController(), this, DamageType );
+
+			if( AStarWarsArenaGameState * GameState = AStarWarsArenaGameState::Get( GetWorld() ) )
+				GameState->RecordDamage( m_pHuman, OtherHuman, FMath::RoundToInt( AppliedDamage ) );
 		}
 	}
 
@@ -339,6 +849,32 @@ bool ASaber::Multicast_BladeOverlap_Validate( AActor * OverlappedActor )
 	return true;
 }
 
+void ASaber::Multicast_BladeClash_Implementation( ASaber * OtherSaber )
+{
+	HITCH_EVENT( GetWorld(), EHitchEvent::BladeClash, this, OtherSaber );
+
+	AHuman * OtherHuman = OtherSaber ? OtherSaber->GetHuman() : nullptr;
+
+	if( !m_pHuman || !OtherHuman || OtherHuman == m_pHuman )
+		return;
+
+	EHumanState MyHumanState = m_pHuman->GetState();
+	EHumanState OtherHumanState = OtherHuman->GetState();
+
+	/* Clash is reported once per pair, so resolve it for whichever side attacks */
+	if( MyHumanState == EHumanState::EHS_Attacking )
+	{
+		if( OtherHumanState == EHumanState::EHS_Attacking )
+			m_pHuman->OnAttackAttackingEnemy( OtherHuman );
+		else if( OtherHumanState == EHumanState::EHS_Defending )
+			m_pHuman->OnAttackDefendingEnemy( OtherHuman );
+	}
+	else if( OtherHumanState == EHumanState::EHS_Attacking && MyHumanState == EHumanState::EHS_Defending )
+	{
+		OtherHuman->OnAttackDefendingEnemy( m_pHuman );
+	}
+}
+
 void ASaber::LaunchSaber( float MaxDistance )
 {
 	Server_LaunchSaber( MaxDistance );	
@@ -346,6 +882,8 @@ void ASaber::LaunchSaber( float MaxDistance )
 
 void ASaber::Server_LaunchSaber_Implementation( float NewMaxFlyDist )
 {
+	HITCH_EVENT( GetWorld(), EHitchEvent::SaberLaunch, this, m_pHuman );
+
 	if( !m_pHuman || !( m_eState == ESaberState::ESS_Opened || m_eState == ESaberState::ESS_Opening ) )
 	{
 		UE_LOG( LogTemp, Error, TEXT( "%s : saber does not have human attached, but LaucnSaber was called." ), *GetName() );
@@ -353,12 +891,23 @@ void ASaber::Server_LaunchSaber_Implementation( float NewMaxFlyDist )
 		return;
 	}
 	FTransform NewTrans( GetActorRotation(), m_pHuman->GetActorLocation() + m_pHuman->GetControlRotation().Vector() * MinDistanceToHuman );
-	Multicast_DetachSaber( NewTrans );
+	SetAttachment( ESaberAttachment::ESA_Free );
+	UpdateTransform( NewTrans, true );
 	
 	m_fMaxFlyDistance = NewMaxFlyDist;	
+	m_FlyDirection = m_pHuman->GetControlRotation().Vector();
+	m_bFollowAim = true;
+	m_NumRicochets = 0;
+	m_FlightTrace = FTraceHandle();
 	
 	SetSaberState( ESaberState::ESS_Flying );
 
+	if( AStarWarsArenaGameState * GameState = AStarWarsArenaGameState::Get( GetWorld() ) )
+		GameState->RecordSaberThrow( m_pHuman );
+
+	if( ACombatBroadcaster * Broadcaster = ACombatBroadcaster::Get( GetWorld(), false ) )
+		Broadcaster->RecordSaberLaunch( m_pHuman, NewMaxFlyDist );
+
 	OnSaberThrown();
 }
 
@@ -368,17 +917,23 @@ void ASaber::StopSaber()
 }
 
 void ASaber::Server_StopSaber_Implementation()
+{
+	HITCH_EVENT( GetWorld(), EHitchEvent::SaberStop, this, m_pHuman );
+
+	Recall();
+}
+
+void ASaber::Recall()
 {
 	if( m_eState == ESaberState::ESS_Flying )
 	{
 		m_fMaxFlyDistance = 0.f;
 	}
+	else if( m_eState == ESaberState::ESS_Stuck )
+	{
+		GetWorldTimerManager().ClearTimer( m_StuckTimer );
+		SetSaberState( ESaberState::ESS_Returning );
+	}
 
 	OnSaberReturnStart();
 }
-
-void ASaber::Multicast_DetachSaber_Implementation( FTransform NewTransform )
-{
-	DetachFromActor( FDetachmentTransformRules::KeepWorldTransform );
-	UpdateTransform( NewTransform, true );
-}
@@ -5,11 +5,19 @@
 #include "CoreMinimal.h"
 #include "Engine.h"
 #include "UnrealNetwork.h"
+#include "Combat/BladeClash.h"
+#include "Audio/SaberAudioManager.h"
+#include "Net/CombatInterpolation.h"
 #include "Saber.generated.h"
 
+#define BLADE_CHANNEL				ECC_GameTraceChannel1    // Saber blade channel
+
 class AHuman;
 class UBoxComponent;
 class UStaticMeshComponent;
+class UAudioComponent;
+class USoundBase;
+class UMaterialInstanceDynamic;
 
 UENUM( BlueprintType )
 enum class ESaberState : uint8
@@ -19,7 +27,17 @@ enum class ESaberState : uint8
 	ESS_Opening				UMETA( DisplayName = "Opening" ),
 	ESS_Closing				UMETA( DisplayName = "Closing" ),
 	ESS_Flying				UMETA( DisplayName = "Flying" ),
-	ESS_Returning			UMETA( DisplayName = "Returning" )
+	ESS_Returning			UMETA( DisplayName = "Returning" ),
+	ESS_Stuck				UMETA( DisplayName = "Stuck" )		// Thrown saber stuck in a wall, returns after StickDuration
+};
+
+/* Where saber is held. Replicated as state, so late joining clients see it where it is */
+UENUM( BlueprintType )
+enum class ESaberAttachment : uint8
+{
+	ESA_Free				UMETA( DisplayName = "Free" ),
+	ESA_Hand				UMETA( DisplayName = "Hand" ),
+	ESA_Belt				UMETA( DisplayName = "Belt" )
 };
 
 UENUM( BlueprintType )
@@ -27,7 +45,54 @@ enum class EBladeOverlapResult : uint8
 {
 	EBOR_PlayerMesh			UMETA( DisplayName = "PlayerMesh" ),
 	EBOR_DamageCancel		UMETA( DisplayName = "DamageCancel" ),
-	EBOR_StaticMesh			UMETA( DisplayName = "StaticMesh" )
+	EBOR_StaticMesh			UMETA( DisplayName = "StaticMesh" ),
+	EBOR_BladeClash			UMETA( DisplayName = "BladeClash" )
+};
+
+/* Replicated blade state: alpha quantized to 8 bits of BladeLength, saber state in 3 bits and attachment in 2.
+Stuck saber also carries its wall transform and server time, sent once with the state change */
+USTRUCT()
+struct STARWARSARENA_API FSaberNetState
+{
+	GENERATED_BODY()
+
+	/* Blade alpha divided by BladeLength, 0..1 */
+	UPROPERTY()
+	float BladeFraction = 0.f;
+
+	UPROPERTY()
+	ESaberState State = ESaberState::ESS_Closed;
+
+	UPROPERTY()
+	ESaberAttachment Attachment = ESaberAttachment::ESA_Free;
+
+	/* Only serialized while State is Stuck */
+	UPROPERTY()
+	FVector StuckLocation = FVector::ZeroVector;
+
+	UPROPERTY()
+	FRotator StuckRotation = FRotator::ZeroRotator;
+
+	UPROPERTY()
+	double StuckServerTime = 0.0;
+
+	bool operator==( const FSaberNetState & other ) const
+	{
+		return State == other.State && Attachment == other.Attachment && FMath::RoundToInt( BladeFraction * 255.f ) == FMath::RoundToInt( other.BladeFraction * 255.f ) &&
+			( State != ESaberState::ESS_Stuck || StuckServerTime == other.StuckServerTime );
+	}
+
+	bool NetSerialize( FArchive & Ar, UPackageMap * Map, bool & bOutSuccess );
+};
+
+template<>
+struct TStructOpsTypeTraits<FSaberNetState> : public TStructOpsTypeTraitsBase2<FSaberNetState>
+{
+	enum
+	{
+		WithNetSerializer = true,
+		WithIdenticalViaEquality = true
+	};
 };
 
 UCLASS()
@@ -40,17 +105,32 @@ public:
 
 	virtual void						GetLifetimeReplicatedProps( TArray<FLifetimeProperty>& OutLifetimeProps ) const override;
 
+	/* Server packs alpha and state into m_NetState */
+	virtual void						PreReplication( IRepChangedPropertyTracker & ChangedPropertyTracker ) override;
+
 	UFUNCTION( BlueprintCallable, Category = "Saber", Meta = ( DisplayName = "SetSaberState" ) )
 	void								SetSaberState( ESaberState NewState );
 
 	UFUNCTION( BlueprintPure, Category = "Saber", Meta = ( DisplayName = "GetSaberState" ) )
 	ESaberState							GetSaberState();
 
+	/* Extended part of the blade, 0 closed to 1 fully opened */
+	float								GetBladeFraction() const							{ return BladeLength > 0.f ? FMath::Clamp( m_Alpha / BladeLength, 0.f, 1.f ) : 0.f; }
+
+	/* One frame of thrown flight: Speed along FlyDirection and Spin applied to rotation */
+	static FTransform					StepFlight( const FTransform & Current, const FVector & FlyDirection, float Speed, const FRotator & Spin );
+
 	UFUNCTION( BlueprintCallable, Meta = ( DisplayName = "LaunchSaber" ) )
 	void								LaunchSaber( float fMaxDistance );
 
 	UFUNCTION( BlueprintCallable, Meta = ( DisplayName = "LaunchSaber" ) )
 	void								StopSaber();
+
+	/* Server only. Flying saber turns back, stuck one leaves the wall. Used by StopSaber and force powers */
+	void								Recall();
+
+	/* Flying or stuck, away from its human until it starts returning */
+	bool								IsThrown() const									{ return m_eState == ESaberState::ESS_Flying || m_eState == ESaberState::ESS_Stuck; }
 	
 	UFUNCTION( BlueprintCallable, Meta = ( DisplayName = "SetHuman" ) )
 	void								SetHuman( AHuman * NewHuman )						{ m_pHuman = NewHuman; }
@@ -58,8 +138,28 @@ public:
 	UFUNCTION( BlueprintCallable, Meta = ( DisplayName = "GetHuman" ) )
 	AHuman *							GetHuman()											{ return m_pHuman; }	
 
+	/* Server sets replicated attachment. Clients only apply it locally, as round reset does on every machine */
+	void								SetAttachment( ESaberAttachment NewAttachment );
+
+	ESaberAttachment					GetAttachment() const								{ return m_eAttachment; }
+
+	/* Returns world space blade segment and its radius. False if blade is not extended */
+	bool								GetBladeSegment( FVector & OutStart, FVector & OutEnd, float & OutRadius ) const;
+
+	/* Closes blade and stops flight without RPCs, called on every machine by AHuman round reset */
+	void								ResetForRound();
+
+	/* Set by significance manager for distant or off screen sabers. On machines without authority the blade
+	follows replicated state without interpolating, hum stops and the tick runs at TickInterval */
+	void								SetReducedFidelity( bool bReduced, float TickInterval );
+
+	/* Plays sound of the category on a pooled voice following the blade. Does nothing on dedicated server */
+	UFUNCTION( BlueprintCallable, Category = "Audio", Meta = ( DisplayName = "PlaySaberSound" ) )
+	void								PlaySaberSound( ESaberSoundCategory Category, float VolumeMultiplier = 1.f );
+
 protected:
 	virtual void						BeginPlay() override;
+	virtual void						EndPlay( const EEndPlayReason::Type EndPlayReason ) override;
 	virtual void						Tick(float DeltaTime) override;
 	
 	UPROPERTY( BlueprintReadWrite, EditAnywhere, Meta = ( DisplayName = "Handle" ) )
@@ -68,6 +168,40 @@ protected:
 	UPROPERTY( BlueprintReadWrite, EditAnywhere, Meta = ( DisplayName = "Blade" ) )
 	UStaticMeshComponent *				Blade;
 
+	/* Idle hum, the only audio component saber owns. One-shots go through ASaberAudioManager */
+	UPROPERTY( VisibleAnywhere, BlueprintReadOnly, Category = "Audio", Meta = ( DisplayName = "HumAudio" ) )
+	UAudioComponent *					HumAudio;
+
+	UPROPERTY( EditDefaultsOnly, Category = "Audio", Meta = ( DisplayName = "HumSound" ) )
+	USoundBase *						HumSound;
+
+	UPROPERTY( EditDefaultsOnly, Category = "Audio", Meta = ( DisplayName = "SwingSound" ) )
+	USoundBase *						SwingSound;
+
+	UPROPERTY( EditDefaultsOnly, Category = "Audio", Meta = ( DisplayName = "ClashSound" ) )
+	USoundBase *						ClashSound;
+
+	UPROPERTY( EditDefaultsOnly, Category = "Audio", Meta = ( DisplayName = "HitSound" ) )
+	USoundBase *						HitSound;
+
+	UPROPERTY( EditDefaultsOnly, Category = "Audio", Meta = ( DisplayName = "TurnOnSound" ) )
+	USoundBase *						TurnOnSound;
+
+	UPROPERTY( EditDefaultsOnly, Category = "Audio", Meta = ( DisplayName = "TurnOffSound" ) )
+	USoundBase *						TurnOffSound;
+
+	/* Blade angular speed in degrees per second at which hum reaches maximum pitch and volume */
+	UPROPERTY( EditDefaultsOnly, Category = "Audio", Meta = ( DisplayName = "HumMaxAngularSpeed" ) )
+	float								HumMaxAngularSpeed;
+
+	/* Hum pitch at rest ( X ) and at HumMaxAngularSpeed ( Y ) */
+	UPROPERTY( EditDefaultsOnly, Category = "Audio", Meta = ( DisplayName = "HumPitchRange" ) )
+	FVector2D							HumPitchRange;
+
+	/* Hum volume at rest ( X ) and at HumMaxAngularSpeed ( Y ) */
+	UPROPERTY( EditDefaultsOnly, Category = "Audio", Meta = ( DisplayName = "HumVolumeRange" ) )
+	FVector2D							HumVolumeRange;
+
 	/* Turning on speed of saber blade */
 	UPROPERTY( Replicated, BlueprintReadWrite, EditAnywhere, Meta = ( DisplayName = "OpeningSpeed" ) )
 	float								OpeningSpeed;
@@ -76,13 +210,18 @@ protected:
 	UPROPERTY( Replicated, BlueprintReadWrite, EditAnywhere, Meta = ( DisplayName = "ClosingSpeed" ) )
 	float								ClosingSpeed;
 
-	/* Blade thickness. This parameter will set blade's scale to (BladeThickness, BladeThickness, Z). Z depends on SaberState */
+	/* Blade thickness. Blade's scale is set once to (BladeThickness, BladeThickness, BladeLength) */
 	UPROPERTY( Replicated, BlueprintReadWrite, EditDefaultsOnly, Meta = ( DisplayName = "BladeThickness" ) )
 	float								BladeThickness;
 
 	/* Length of the blade, from 0 to 1 */
 	UPROPERTY( Replicated, BlueprintReadWrite, EditDefaultsOnly, Meta = ( DisplayName = "BladeLength" ) )
 	float								BladeLength;
+
+	/* Scalar parameter of the blade material getting the extended part 0..1. Material hides the rest of the blade,
+	materials without it get the blade scaled on clients */
+	UPROPERTY( EditDefaultsOnly, Category = "Saber", Meta = ( DisplayName = "BladeExtensionParameter" ) )
+	FName								BladeExtensionParameter;
 	
 	/* How to position saber when it was thrown in first frame */
 	UPROPERTY( BlueprintReadWrite, EditDefaultsOnly, Meta = ( DisplayName = "StartingTransform" ) )
@@ -111,6 +250,26 @@ protected:
 	/* At what distance saber is counted as returned */
 	UPROPERTY( BlueprintReadWrite, EditDefaultsOnly, Meta = ( DisplayName = "MinDistanceToHuman" ) )
 	float								MinDistanceToHuman;
+
+	/* Radius of the sphere swept along thrown saber's flight */
+	UPROPERTY( BlueprintReadWrite, EditDefaultsOnly, Category = "Flight", Meta = ( DisplayName = "FlightCollisionRadius" ) )
+	float								FlightCollisionRadius;
+
+	/* Bounces off walls and blades before the saber gives up and returns, the last one still bounces */
+	UPROPERTY( BlueprintReadWrite, EditDefaultsOnly, Category = "Flight", Meta = ( DisplayName = "MaxRicochets" ) )
+	int32								MaxRicochets;
+
+	/* Saber hitting a wall closer to head-on than this angle in degrees sticks, otherwise it ricochets */
+	UPROPERTY( BlueprintReadWrite, EditDefaultsOnly, Category = "Flight", Meta = ( DisplayName = "StickAngle" ) )
+	float								StickAngle;
+
+	/* Part of the blade inside the wall when stuck, 0..1 */
+	UPROPERTY( BlueprintReadWrite, EditDefaultsOnly, Category = "Flight", Meta = ( DisplayName = "StickDepth" ) )
+	float								StickDepth;
+
+	/* Seconds stuck saber waits before returning. Stopping the saber returns it at once */
+	UPROPERTY( BlueprintReadWrite, EditDefaultsOnly, Category = "Flight", Meta = ( DisplayName = "StickDuration" ) )
+	float								StickDuration;
 	
 	UPROPERTY( BlueprintReadWrite, EditDefaultsOnly, Category = "Attacks", Meta = ( DisplayName = "BaseDamage" ) )
 	int32								BaseDamage = 10;
@@ -128,9 +287,22 @@ protected:
 	UFUNCTION( BlueprintImplementableEvent, Category = "Saber", Meta = ( DisplayName = "OnSaberReturnStart" ) )
 	void								OnSaberReturnStart();
 
+	/* Server only. Thrown saber hit something at ImpactPoint and ricocheted, stuck or started returning */
+	UFUNCTION( BlueprintImplementableEvent, Category = "Saber", Meta = ( DisplayName = "OnSaberFlightHit" ) )
+	void								OnSaberFlightHit( AActor * HitActor, FVector ImpactPoint, FVector ImpactNormal, ESaberState NewState );
+
 	UFUNCTION( BlueprintImplementableEvent, Category = "Saber", Meta = ( DisplayName = "OnBladeOverlapCPP" ) )
 	void								OnBladeOverlapCPP( EBladeOverlapResult Result );
+
+	/* Called when blade starts touching blade of another human.
+	@param Normal points from other blade to this one
+	@param RelativeVelocity is velocity of this blade relative to other one at contact point */
+	UFUNCTION( BlueprintImplementableEvent, Category = "Saber", Meta = ( DisplayName = "OnBladeClash" ) )
+	void								OnBladeClash( FVector ContactPoint, FVector Normal, FVector RelativeVelocity );
 private:
+	/* Combat manager runs blade queries for the saber and reports overlaps through BladeOverlap */
+	friend class ACombatManager;
+
 	/* Set saber state */
 	UFUNCTION( Server, Reliable, WithValidation )
 	void								Server_SetSaberState( ESaberState NewState );
@@ -148,10 +320,17 @@ private:
 	void								Server_UpdateTransform_Implementation( FTransform NewTransfrom, bool bUpdatePosition = false );
 	bool								Server_UpdateTransform_Validate( FTransform NewTransfrom, bool bUpdatePosition = false );
 
-	UFUNCTION( NetMulticast, Reliable, WithValidation )
-	void								Multicast_UpdateTransform( FTransform NewTransfrom, bool bUpdatePosition = false );
-	void								Multicast_UpdateTransform_Implementation( FTransform NewTransfrom, bool bUpdatePosition = false );
-	bool								Multicast_UpdateTransform_Validate( FTransform NewTransfrom, bool bUpdatePosition = false ) { return true; }
+	/* Sent every flight frame, a lost one is covered by interpolation. Clients buffer it and follow at render time */
+	UFUNCTION( NetMulticast, Unreliable, WithValidation )
+	void								Multicast_UpdateTransform( FTransform NewTransfrom, bool bUpdatePosition, double ServerTime );
+	void								Multicast_UpdateTransform_Implementation( FTransform NewTransfrom, bool bUpdatePosition, double ServerTime );
+	bool								Multicast_UpdateTransform_Validate( FTransform NewTransfrom, bool bUpdatePosition, double ServerTime ) { return true; }
+
+	/* Flight transforms from server, sampled by clients at interpolation render time */
+	FTransformInterpolationBuffer		m_TransformBuffer;
+
+	/* Clients only show flight, server simulates it */
+	void								FollowReplicatedTransform();
 
 	//void UpdateTransformOnServer( FTransform NewTransform, bool bUpdatePosition = false );
 
@@ -166,10 +345,11 @@ private:
 	void								Multicast_BladeOverlap_Implementation( AActor * OverlappedActor );
 	bool								Multicast_BladeOverlap_Validate( AActor * OverlappedActor );
 
+	/* On blade clash with another saber */
 	UFUNCTION( NetMulticast, Reliable, WithValidation )
-	void								Multicast_DetachSaber( FTransform NewTransform );
-	void								Multicast_DetachSaber_Implementation( FTransform NewTransform );
-	bool								Multicast_DetachSaber_Validate( FTransform NewTransform ) { return true; }
+	void								Multicast_BladeClash( ASaber * OtherSaber );
+	void								Multicast_BladeClash_Implementation( ASaber * OtherSaber );
+	bool								Multicast_BladeClash_Validate( ASaber * OtherSaber ) { return true; }
 
 	UFUNCTION( Server, Reliable, WithValidation )
 	void								Server_LaunchSaber( float NewMaxFlyDist );
@@ -183,27 +363,62 @@ private:
 
 	/* Updates saber's transform on server.
 	* @param NewTransform - new transform to set
-	* @param bUpdatePosition - if true, Location and Rotation will be updated. Otherwise only scale will be updated.
+	* @param bUpdatePosition - if true, Location and Rotation will be updated. Blade extension is local and never sent.
 	*/
 	void								UpdateTransform( FTransform NewTransfrom, bool bUpdatePosition = false );
-	UPROPERTY( Replicated )
+	UPROPERTY( ReplicatedUsing = OnRep_Human )
 	AHuman *							m_pHuman;
-	UPROPERTY( Replicated )
+	/* Alpha and state are replicated through m_NetState */
 	float								m_Alpha;
 	UPROPERTY( Replicated )
 	float								m_fMaxFlyDistance;
 
-	UPROPERTY( Replicated )
 	ESaberState							m_eState;
-	
+
+	/* Replicated through m_NetState */
+	ESaberAttachment					m_eAttachment;
+
+	/* Client got the attachment while buffered flight is still being played, it attaches once render time passes the flight */
+	bool								m_bAttachPending;
+
+	UPROPERTY( ReplicatedUsing = OnRep_NetState )
+	FSaberNetState						m_NetState;
+
 	UFUNCTION()
-	void HiltOverlap( UPrimitiveComponent* OverlappedComp,
-						  AActor* OtherActor,
-						  UPrimitiveComponent* OtherComp,
-						  int32 OtherBodyIndex,
-						  bool bFromSweep,
-						  const FHitResult& SweepResult );
+	void								OnRep_NetState();
+
+	/* Attachment may arrive before the human is relevant */
+	UFUNCTION()
+	void								OnRep_Human();
+
+	/* Attaches to the socket of m_eAttachment or detaches, does nothing if already there.
+	On clients attaching waits until the buffered flight has been played */
+	void								ApplyAttachment();
 	
+	/* Server flight collision. Every flight frame sweeps the step of the next frame asynchronously,
+	so the saber moves along a path that is already known to be free or stops at the exact hit */
+	void								IssueFlightTrace( const FTransform & From, const FTransform & To );
+
+	/* Takes last frame's sweep. True if flight goes on from OutTransform ( free step or ricochet ) */
+	bool								ConsumeFlightTrace( FTransform & OutTransform );
+
+	bool								HandleFlightHit( const FHitResult & Hit, FTransform & OutTransform );
+
+	/* Server only. Sticks the blade into the wall and returns after StickDuration */
+	void								StickInWall( const FHitResult & Hit );
+
+	FTraceHandle						m_FlightTrace;
+
+	/* Transform at the end of the traced step */
+	FTransform							m_FlightStep;
+
+	/* Follows owner's aim until the first ricochet */
+	FVector								m_FlyDirection;
+	bool								m_bFollowAim;
+	int32								m_NumRicochets;
+
+	FTimerHandle						m_StuckTimer;
+
 	UFUNCTION()
 	void BladeOverlap( UPrimitiveComponent* OverlappedComp,
 						  AActor* OtherActor,
@@ -212,4 +427,32 @@ private:
 						  bool bFromSweep,
 						  const FHitResult& SweepResult );
 
+	/* Reported by combat manager for both sabers of a clash. Only instigator resolves it on server */
+	void BladeClash( ASaber * OtherSaber, const FBladeClashResult & Clash, bool bInstigator );
+
+	/* Pushes blade fraction to the blade material. Without the material parameter clients scale the blade locally */
+	void								UpdateBladeExtension();
+
+	/* Blade can be found by queries only while fully out */
+	void								UpdateBladeCollision();
+
+	/* Starts, stops and modulates hum from blade angular velocity */
+	void								UpdateHum( float DeltaTime );
+
+	FQuat								m_PrevBladeRotation;
+
+	/* Smoothed 0..1 hum intensity */
+	float								m_HumIntensity;
+
+	bool								m_bReducedFidelity;
+
+	UPROPERTY( Transient )
+	UMaterialInstanceDynamic *			m_BladeMaterial;
+
+	/* Blade material has BladeExtensionParameter, otherwise extension falls back to blade scale */
+	bool								m_bMaterialExtension;
+
+	/* Fraction last pushed to the material, negative before the first push */
+	float								m_AppliedBladeFraction;
+
 };
@@ -0,0 +1,329 @@
+#include "MeshSlicer.h"
+#include "GeomTools.h"
+
+namespace
+{
+	FProcMeshVertex InterpolateVertex( const FProcMeshVertex & A, const FProcMeshVertex & B, float Alpha )
+	{
+		FProcMeshVertex Result;
+		Result.Position = FMath::Lerp( A.Position, B.Position, Alpha );
+		Result.Normal = FMath::Lerp( A.Normal, B.Normal, Alpha ).GetSafeNormal();
+		Result.Tangent.TangentX = FMath::Lerp( A.Tangent.TangentX, B.Tangent.TangentX, Alpha ).GetSafeNormal();
+		Result.Tangent.bFlipTangentY = A.Tangent.bFlipTangentY;
+		Result.UV0 = FMath::Lerp( A.UV0, B.UV0, Alpha );
+		Result.Color = FMath::Lerp( FLinearColor( A.Color ), FLinearColor( B.Color ), Alpha ).ToFColor( false );
+		return Result;
+	}
+
+	int32 AddVertex( FProcMeshSection & Section, const FProcMeshVertex & Vertex )
+	{
+		Section.SectionLocalBox += Vertex.Position;
+		return Section.ProcVertexBuffer.Add( Vertex );
+	}
+
+	/* Copies base vertex to the half once, later triangles reuse it */
+	int32 RemapVertex( const FProcMeshSection & Base, int32 BaseIndex, FProcMeshSection & Half, TArray<int32> & Remap )
+	{
+		if( Remap[ BaseIndex ] == INDEX_NONE )
+			Remap[ BaseIndex ] = AddVertex( Half, Base.ProcVertexBuffer[ BaseIndex ] );
+
+		return Remap[ BaseIndex ];
+	}
+
+	/* Clipped triangle is convex and keeps winding of the original one, a fan is enough */
+	void AddPolygon( FProcMeshSection & Section, const int32 * Indices, int32 Num )
+	{
+		for( int32 i = 1; i + 1 < Num; ++i )
+		{
+			Section.ProcIndexBuffer.Add( Indices[ 0 ] );
+			Section.ProcIndexBuffer.Add( Indices[ i ] );
+			Section.ProcIndexBuffer.Add( Indices[ i + 1 ] );
+		}
+	}
+
+	void SliceSection( const FProcMeshSection & Section, const FPlane & Plane, FProcMeshSection & Kept, FProcMeshSection & Debris, TArray<FUtilEdge3D> & ClipEdges )
+	{
+		const TArray<FProcMeshVertex> & Vertices = Section.ProcVertexBuffer;
+		const TArray<uint32> & Indices = Section.ProcIndexBuffer;
+
+		Kept.bEnableCollision = Debris.bEnableCollision = Section.bEnableCollision;
+		Kept.bSectionVisible = Debris.bSectionVisible = Section.bSectionVisible;
+
+		TArray<float> Distances;
+		Distances.SetNumUninitialized( Vertices.Num() );
+		for( int32 i = 0; i < Vertices.Num(); ++i )
+			Distances[ i ] = Plane.PlaneDot( Vertices[ i ].Position );
+
+		TArray<int32> KeptRemap;
+		TArray<int32> DebrisRemap;
+		KeptRemap.Init( INDEX_NONE, Vertices.Num() );
+		DebrisRemap.Init( INDEX_NONE, Vertices.Num() );
+
+		for( int32 t = 0; t + 2 < Indices.Num(); t += 3 )
+		{
+			const int32 Triangle[ 3 ] = { int32( Indices[ t ] ), int32( Indices[ t + 1 ] ), int32( Indices[ t + 2 ] ) };
+			const bool bKeep[ 3 ] = { Distances[ Triangle[ 0 ] ] >= 0.f, Distances[ Triangle[ 1 ] ] >= 0.f, Distances[ Triangle[ 2 ] ] >= 0.f };
+
+			if( bKeep[ 0 ] == bKeep[ 1 ] && bKeep[ 1 ] == bKeep[ 2 ] )
+			{
+				FProcMeshSection & Half = bKeep[ 0 ] ? Kept : Debris;
+				TArray<int32> & Remap = bKeep[ 0 ] ? KeptRemap : DebrisRemap;
+
+				for( int32 k = 0; k < 3; ++k )
+					Half.ProcIndexBuffer.Add( RemapVertex( Section, Triangle[ k ], Half, Remap ) );
+
+				continue;
+			}
+
+			/* Walk edges in triangle order, both polygons keep its winding */
+			int32 KeptPolygon[ 4 ], DebrisPolygon[ 4 ];
+			int32 NumKept = 0, NumDebris = 0;
+			FVector CutPoints[ 2 ];
+			int32 NumCut = 0;
+
+			for( int32 k = 0; k < 3; ++k )
+			{
+				const int32 A = Triangle[ k ];
+				const int32 B = Triangle[ ( k + 1 ) % 3 ];
+
+				if( bKeep[ k ] )
+					KeptPolygon[ NumKept++ ] = RemapVertex( Section, A, Kept, KeptRemap );
+				else
+					DebrisPolygon[ NumDebris++ ] = RemapVertex( Section, A, Debris, DebrisRemap );
+
+				if( bKeep[ k ] != bKeep[ ( k + 1 ) % 3 ] )
+				{
+					const float Alpha = Distances[ A ] / ( Distances[ A ] - Distances[ B ] );
+					const FProcMeshVertex Cut = InterpolateVertex( Vertices[ A ], Vertices[ B ], Alpha );
+
+					KeptPolygon[ NumKept++ ] = AddVertex( Kept, Cut );
+					DebrisPolygon[ NumDebris++ ] = AddVertex( Debris, Cut );
+					CutPoints[ NumCut++ ] = Cut.Position;
+				}
+			}
+
+			AddPolygon( Kept, KeptPolygon, NumKept );
+			AddPolygon( Debris, DebrisPolygon, NumDebris );
+
+			FUtilEdge3D Edge;
+			Edge.V0 = CutPoints[ 0 ];
+			Edge.V1 = CutPoints[ 1 ];
+			ClipEdges.Add( Edge );
+		}
+	}
+
+	/**
+	* Ear clipping of a planar polygon. Triangles are emitted in engine winding for FaceNormal,
+	* that is ( C - A ) ^ ( B - A ) points along the normal.
+	*/
+	void TriangulatePolygon( const TArray<FVector> & Points, const FVector & FaceNormal, TArray<int32> & OutTriangles )
+	{
+		const int32 NumPoints = Points.Num();
+		if( NumPoints < 3 )
+			return;
+
+		/* Newell normal follows counter clockwise order, engine winding needs clockwise around the face normal */
+		FVector Newell = FVector::ZeroVector;
+		for( int32 i = 0; i < NumPoints; ++i )
+		{
+			const FVector & A = Points[ i ];
+			const FVector & B = Points[ ( i + 1 ) % NumPoints ];
+			Newell.X += ( A.Y - B.Y ) * ( A.Z + B.Z );
+			Newell.Y += ( A.Z - B.Z ) * ( A.X + B.X );
+			Newell.Z += ( A.X - B.X ) * ( A.Y + B.Y );
+		}
+
+		TArray<int32> Remaining;
+		Remaining.Reserve( NumPoints );
+		for( int32 i = 0; i < NumPoints; ++i )
+			Remaining.Add( ( Newell | FaceNormal ) > 0.f ? NumPoints - 1 - i : i );
+
+		int32 Index = 0;
+		int32 Attempts = 0;
+
+		while( Remaining.Num() > 2 && Attempts < Remaining.Num() )
+		{
+			const int32 Prev = ( Index + Remaining.Num() - 1 ) % Remaining.Num();
+			const int32 Next = ( Index + 1 ) % Remaining.Num();
+
+			const FVector & A = Points[ Remaining[ Prev ] ];
+			const FVector & B = Points[ Remaining[ Index ] ];
+			const FVector & C = Points[ Remaining[ Next ] ];
+
+			const FVector Cross = ( C - A ) ^ ( B - A );
+			const float Convexity = Cross | FaceNormal;
+
+			/* Collinear vertex adds nothing, drop it without a triangle */
+			if( Cross.SizeSquared() < KINDA_SMALL_NUMBER )
+			{
+				Remaining.RemoveAt( Index );
+				Index %= Remaining.Num();
+				Attempts = 0;
+				continue;
+			}
+
+			bool bEar = Convexity > 0.f;
+
+			for( int32 i = 0; bEar && i < Remaining.Num(); ++i )
+			{
+				if( i == Prev || i == Index || i == Next )
+					continue;
+
+				const FVector Bary = FMath::ComputeBaryCentric2D( Points[ Remaining[ i ] ], A, B, C );
+				bEar = !( Bary.X > KINDA_SMALL_NUMBER && Bary.Y > KINDA_SMALL_NUMBER && Bary.Z > KINDA_SMALL_NUMBER );
+			}
+
+			if( !bEar )
+			{
+				Index = Next;
+				++Attempts;
+				continue;
+			}
+
+			OutTriangles.Add( Remaining[ Prev ] );
+			OutTriangles.Add( Remaining[ Index ] );
+			OutTriangles.Add( Remaining[ Next ] );
+
+			Remaining.RemoveAt( Index );
+			Index %= Remaining.Num();
+			Attempts = 0;
+		}
+	}
+
+	void BuildCaps( const TArray<FUtilEdge3D> & ClipEdges, const FPlane & Plane, FMeshSliceResult & OutResult )
+	{
+		if( ClipEdges.Num() == 0 )
+			return;
+
+		/* Edge soup to closed loops in plane space */
+		TArray<FUtilEdge2D> Edges2D;
+		FUtilPoly2DSet PolySet;
+		FGeomTools::ProjectEdges( Edges2D, PolySet.PolyToWorld, ClipEdges, Plane );
+		FGeomTools::Buid2DPolysFromEdges( PolySet.Polys, Edges2D, FColor::White );
+
+		const FVector PlaneNormal( Plane.X, Plane.Y, Plane.Z );
+		const FVector CapTangent = PolySet.PolyToWorld.GetUnitAxis( EAxis::X );
+
+		TArray<FVector> Points;
+		TArray<int32> Triangles;
+
+		for( FUtilPoly2D & Polygon : PolySet.Polys )
+		{
+			FGeomTools::GeneratePlanarTilingPolyUVs( Polygon, 64.f );
+
+			Points.Reset();
+			for( const FUtilVertex2D & Vertex : Polygon.Verts )
+				Points.Add( PolySet.PolyToWorld.TransformPosition( FVector( Vertex.Pos.X, Vertex.Pos.Y, 0.f ) ) );
+
+			/* Kept half is on the positive side, its cap faces the debris */
+			Triangles.Reset();
+			TriangulatePolygon( Points, -PlaneNormal, Triangles );
+
+			const int32 KeptBase = OutResult.KeptCap.ProcVertexBuffer.Num();
+			const int32 DebrisBase = OutResult.DebrisCap.ProcVertexBuffer.Num();
+
+			for( int32 i = 0; i < Points.Num(); ++i )
+			{
+				FProcMeshVertex Vertex;
+				Vertex.Position = Points[ i ];
+				Vertex.UV0 = Polygon.Verts[ i ].UV;
+				Vertex.Color = FColor::White;
+				Vertex.Tangent.TangentX = CapTangent;
+
+				Vertex.Normal = -PlaneNormal;
+				AddVertex( OutResult.KeptCap, Vertex );
+
+				Vertex.Normal = PlaneNormal;
+				AddVertex( OutResult.DebrisCap, Vertex );
+			}
+
+			for( int32 t = 0; t + 2 < Triangles.Num(); t += 3 )
+			{
+				OutResult.KeptCap.ProcIndexBuffer.Add( KeptBase + Triangles[ t ] );
+				OutResult.KeptCap.ProcIndexBuffer.Add( KeptBase + Triangles[ t + 1 ] );
+				OutResult.KeptCap.ProcIndexBuffer.Add( KeptBase + Triangles[ t + 2 ] );
+
+				/* Opposite face, opposite winding */
+				OutResult.DebrisCap.ProcIndexBuffer.Add( DebrisBase + Triangles[ t ] );
+				OutResult.DebrisCap.ProcIndexBuffer.Add( DebrisBase + Triangles[ t + 2 ] );
+				OutResult.DebrisCap.ProcIndexBuffer.Add( DebrisBase + Triangles[ t + 1 ] );
+			}
+		}
+	}
+
+	/* Extreme vertices along 26 directions approximate the convex hull well enough for debris */
+	void BuildHull( const TArray<FProcMeshSection> & Sections, TArray<FVector> & OutHull )
+	{
+		static const int32 NumDirections = 26;
+		FVector Directions[ NumDirections ];
+		int32 NumBuilt = 0;
+
+		for( int32 X = -1; X <= 1; ++X )
+			for( int32 Y = -1; Y <= 1; ++Y )
+				for( int32 Z = -1; Z <= 1; ++Z )
+				{
+					if( X != 0 || Y != 0 || Z != 0 )
+						Directions[ NumBuilt++ ] = FVector( X, Y, Z ).GetSafeNormal();
+				}
+
+		float Best[ NumDirections ];
+		FVector BestPoints[ NumDirections ];
+		for( int32 d = 0; d < NumDirections; ++d )
+			Best[ d ] = -BIG_NUMBER;
+
+		for( const FProcMeshSection & Section : Sections )
+			for( const FProcMeshVertex & Vertex : Section.ProcVertexBuffer )
+				for( int32 d = 0; d < NumDirections; ++d )
+				{
+					const float Projection = Vertex.Position | Directions[ d ];
+					if( Projection > Best[ d ] )
+					{
+						Best[ d ] = Projection;
+						BestPoints[ d ] = Vertex.Position;
+					}
+				}
+
+		OutHull.Reset();
+		for( int32 d = 0; d < NumDirections; ++d )
+		{
+			if( Best[ d ] > -BIG_NUMBER )
+				OutHull.AddUnique( BestPoints[ d ] );
+		}
+	}
+}
+
+void MeshSlicer::Slice( const TArray<FProcMeshSection> & Sections, const FPlane & Plane, FMeshSliceResult & OutResult )
+{
+	OutResult = FMeshSliceResult();
+	OutResult.KeptSections.SetNum( Sections.Num() );
+	OutResult.DebrisSections.SetNum( Sections.Num() );
+
+	TArray<FUtilEdge3D> ClipEdges;
+	int32 NumKeptTriangles = 0;
+	int32 NumDebrisTriangles = 0;
+
+	for( int32 i = 0; i < Sections.Num(); ++i )
+	{
+		SliceSection( Sections[ i ], Plane, OutResult.KeptSections[ i ], OutResult.DebrisSections[ i ], ClipEdges );
+
+		NumKeptTriangles += OutResult.KeptSections[ i ].ProcIndexBuffer.Num() / 3;
+		NumDebrisTriangles += OutResult.DebrisSections[ i ].ProcIndexBuffer.Num() / 3;
+	}
+
+	/* Plane missed the mesh */
+	if( NumKeptTriangles == 0 || NumDebrisTriangles == 0 )
+		return;
+
+	BuildCaps( ClipEdges, Plane, OutResult );
+	OutResult.KeptCap.bEnableCollision = OutResult.DebrisCap.bEnableCollision = Sections[ 0 ].bEnableCollision;
+
+	TArray<FProcMeshSection> KeptWithCap( OutResult.KeptSections );
+	KeptWithCap.Add( OutResult.KeptCap );
+	BuildHull( KeptWithCap, OutResult.KeptHull );
+
+	TArray<FProcMeshSection> DebrisWithCap( OutResult.DebrisSections );
+	DebrisWithCap.Add( OutResult.DebrisCap );
+	BuildHull( DebrisWithCap, OutResult.DebrisHull );
+
+	OutResult.bSliced = true;
+}
@@ -0,0 +1,34 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ProceduralMeshComponent.h"
+
+/* Both halves of a sliced mesh. Positive side of the plane stays on the sliced component, negative side becomes debris */
+struct FMeshSliceResult
+{
+	TArray<FProcMeshSection>			KeptSections;
+	TArray<FProcMeshSection>			DebrisSections;
+
+	/* Caps closing the cut, separate sections so they can use the slice material */
+	FProcMeshSection					KeptCap;
+	FProcMeshSection					DebrisCap;
+
+	/* Extreme points of both halves for convex collision, at most 26 each */
+	TArray<FVector>						KeptHull;
+	TArray<FVector>						DebrisHull;
+
+	/* False if the plane missed the mesh, nothing should be applied then */
+	bool								bSliced = false;
+};
+
+/**
+* Plane cut and cap triangulation of procedural mesh sections.
+* Works on copies only and touches no UObject, so it runs on worker threads.
+*/
+namespace MeshSlicer
+{
+	/* Cuts sections by a plane in their local space */
+	STARWARSARENA_API void				Slice( const TArray<FProcMeshSection> & Sections, const FPlane & Plane, FMeshSliceResult & OutResult );
+}
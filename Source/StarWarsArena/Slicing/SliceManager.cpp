@@ -0,0 +1,390 @@
+#include "SliceManager.h"
+#include "MeshSlicer.h"
+#include "Objects/Saber.h"
+#include "Diagnostics/CombatMemory.h"
+#include "ProceduralMeshComponent.h"
+#include "Materials/MaterialInterface.h"
+#include "Engine/CollisionProfile.h"
+#include "Engine/World.h"
+#include "Async/Async.h"
+
+#include "EngineUtils.h"
+
+DECLARE_CYCLE_STAT( TEXT( "Apply cuts" ), STAT_SliceApply, STATGROUP_Slicing );
+DECLARE_DWORD_COUNTER_STAT( TEXT( "Cuts in flight" ), STAT_SliceJobsInFlight, STATGROUP_Slicing );
+DECLARE_DWORD_COUNTER_STAT( TEXT( "Live debris" ), STAT_SliceLiveDebris, STATGROUP_Slicing );
+
+static FAutoConsoleCommandWithWorld SliceStatsCommand(
+	TEXT( "swa.SliceStats" ),
+	TEXT( "Logs cuts, rejected cuts, recycled debris and average worker time of procedural mesh slicing." ),
+	FConsoleCommandWithWorldDelegate::CreateLambda( []( UWorld * World )
+	{
+		if( ASliceManager * SliceManager = ASliceManager::Get( World, false ) )
+			SliceManager->LogStats();
+	} ) );
+
+/* One cut. Worker only reads the plane and the section copies and writes the result */
+struct FSliceJob
+{
+	TWeakObjectPtr<UProceduralMeshComponent>	Target;
+
+	FPlane										LocalPlane;
+	FVector										WorldNormal = FVector::UpVector;
+
+	TArray<FProcMeshSection>					Sections;
+	FMeshSliceResult							Result;
+
+	double										WorkerSeconds = 0.0;
+	FThreadSafeBool								bDone;
+};
+
+namespace
+{
+	void AppendSection( FProcMeshSection & Dest, const FProcMeshSection & Source )
+	{
+		const int32 BaseIndex = Dest.ProcVertexBuffer.Num();
+
+		Dest.ProcVertexBuffer.Append( Source.ProcVertexBuffer );
+		for( uint32 Index : Source.ProcIndexBuffer )
+			Dest.ProcIndexBuffer.Add( BaseIndex + Index );
+
+		Dest.SectionLocalBox += Source.SectionLocalBox;
+	}
+
+	/* Replaces all sections of Mesh, cap is merged into section CapIndex or added after the last one */
+	void SetSections( UProceduralMeshComponent * Mesh, TArray<FProcMeshSection> & Sections, const FProcMeshSection & Cap, int32 CapIndex )
+	{
+		if( Sections.IsValidIndex( CapIndex ) )
+			AppendSection( Sections[ CapIndex ], Cap );
+		else
+			Sections.Add( Cap );
+
+		Mesh->ClearAllMeshSections();
+
+		for( int32 i = 0; i < Sections.Num(); ++i )
+			Mesh->SetProcMeshSection( i, Sections[ i ] );
+	}
+}
+
+ASliceManager::ASliceManager() :
+	MaxJobsInFlight( 8 ),
+	MaxAppliesPerFrame( 2 ),
+	MaxLiveDebris( 32 ),
+	DebrisLifetime( 10.f ),
+	DebrisShadowAge( 2.f ),
+	DebrisShrinkTime( 1.f ),
+	PressureLifetimeScale( 0.5f ),
+	DebrisImpulse( 150.f ),
+	MinSliceSize( 5.f ),
+	CapMaterial( TEXT( "/Game/Materials/SaberSlices.SaberSlices" ) ),
+	m_CapMaterial( nullptr ),
+	m_NumLiveDebris( 0 ),
+	m_NumSlices( 0 ),
+	m_NumRejected( 0 ),
+	m_NumRecycled( 0 ),
+	m_WorkerSeconds( 0.0 )
+{
+	bReplicates = false;
+	PrimaryActorTick.bCanEverTick = true;
+
+	RootComponent = CreateDefaultSubobject<USceneComponent>( TEXT( "Root" ) );
+}
+
+ASliceManager * ASliceManager::Get( UWorld * World, bool bSpawnIfMissing )
+{
+	if( !World || World->GetNetMode() == NM_DedicatedServer )
+		return nullptr;
+
+	for( TActorIterator<ASliceManager> It( World ); It; ++It )
+	{
+		if( !It->IsPendingKill() )
+			return *It;
+	}
+
+	if( !bSpawnIfMissing )
+		return nullptr;
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	SpawnParams.ObjectFlags |= RF_Transient;
+
+	return World->SpawnActor<ASliceManager>( SpawnParams );
+}
+
+void ASliceManager::BeginPlay()
+{
+	COMBAT_LLM_SCOPE( ECombatMemory::Slicing );
+
+	Super::BeginPlay();
+
+	m_CapMaterial = Cast<UMaterialInterface>( CapMaterial.TryLoad() );
+	if( !m_CapMaterial )
+		UE_LOG( LogTemp, Warning, TEXT( "Slice cap material %s not found, caps use default material." ), *CapMaterial.ToString() );
+
+	/* The only place debris components are allocated */
+	m_Debris.SetNum( FMath::Max( MaxLiveDebris, 1 ) );
+
+	for( FSliceDebris & Debris : m_Debris )
+	{
+		UProceduralMeshComponent * Component = NewObject<UProceduralMeshComponent>( this );
+		Component->bUseAsyncCooking = true;
+		Component->bUseComplexAsSimpleCollision = false;
+		Component->SetCollisionProfileName( UCollisionProfile::PhysicsActor_ProfileName );
+		/* Debris is not cut again and does not get in the way of players */
+		Component->SetCollisionResponseToChannel( BLADE_CHANNEL, ECollisionResponse::ECR_Ignore );
+		Component->SetCollisionResponseToChannel( ECC_Pawn, ECollisionResponse::ECR_Ignore );
+		Component->SetCollisionEnabled( ECollisionEnabled::NoCollision );
+		Component->SetVisibility( false );
+		Component->RegisterComponent();
+
+		Debris.Component = Component;
+	}
+}
+
+void ASliceManager::EndPlay( const EEndPlayReason::Type EndPlayReason )
+{
+	/* Workers still running hold their own reference to the job, the result is dropped */
+	m_Jobs.Reset();
+
+	LogStats();
+
+	Super::EndPlay( EndPlayReason );
+}
+
+bool ASliceManager::RequestSlice( UProceduralMeshComponent * Target, const FVector & PlanePosition, const FVector & PlaneNormal )
+{
+	COMBAT_LLM_SCOPE( ECombatMemory::Slicing );
+
+	if( !Target || Target->GetNumSections() == 0 )
+		return false;
+
+	const bool bInFlight = m_Jobs.ContainsByPredicate( [ Target ]( const TSharedPtr<FSliceJob, ESPMode::ThreadSafe> & Job )
+	{
+		return Job->Target == Target;
+	} );
+
+	if( bInFlight || m_Jobs.Num() >= MaxJobsInFlight || Target->Bounds.SphereRadius < MinSliceSize )
+	{
+		++m_NumRejected;
+		return false;
+	}
+
+	TSharedPtr<FSliceJob, ESPMode::ThreadSafe> Job = MakeShared<FSliceJob, ESPMode::ThreadSafe>();
+	Job->Target = Target;
+
+	/* Same plane transform as the engine's SliceProceduralMesh */
+	const FTransform & ComponentToWorld = Target->GetComponentTransform();
+	const FVector LocalPosition = ComponentToWorld.InverseTransformPosition( PlanePosition );
+	const FVector LocalNormal = ComponentToWorld.InverseTransformVectorNoScale( PlaneNormal ).GetSafeNormal();
+	Job->LocalPlane = FPlane( LocalPosition, LocalNormal );
+	Job->WorldNormal = PlaneNormal.GetSafeNormal();
+
+	Job->Sections.Reserve( Target->GetNumSections() );
+	for( int32 i = 0; i < Target->GetNumSections(); ++i )
+	{
+		const FProcMeshSection * Section = Target->GetProcMeshSection( i );
+		Job->Sections.Add( Section ? *Section : FProcMeshSection() );
+	}
+
+	m_Jobs.Add( Job );
+
+	Async<void>( EAsyncExecution::ThreadPool, [ Job ]()
+	{
+		COMBAT_LLM_SCOPE( ECombatMemory::Slicing );
+
+		const double StartTime = FPlatformTime::Seconds();
+		MeshSlicer::Slice( Job->Sections, Job->LocalPlane, Job->Result );
+		Job->WorkerSeconds = FPlatformTime::Seconds() - StartTime;
+		Job->bDone = true;
+	} );
+
+	return true;
+}
+
+void ASliceManager::Tick( float DeltaTime )
+{
+	COMBAT_LLM_SCOPE( ECombatMemory::Slicing );
+
+	Super::Tick( DeltaTime );
+
+	{
+		SCOPE_CYCLE_COUNTER( STAT_SliceApply );
+
+		/* Oldest finished cuts first, the rest wait so a slash through a stack is spread over frames */
+		int32 NumApplied = 0;
+		for( int32 i = 0; i < m_Jobs.Num() && NumApplied < MaxAppliesPerFrame; )
+		{
+			if( !m_Jobs[ i ]->bDone )
+			{
+				++i;
+				continue;
+			}
+
+			ApplySlice( *m_Jobs[ i ] );
+			m_Jobs.RemoveAt( i );
+			++NumApplied;
+		}
+	}
+
+	UpdateDebris();
+
+	SET_DWORD_STAT( STAT_SliceJobsInFlight, m_Jobs.Num() );
+	SET_DWORD_STAT( STAT_SliceLiveDebris, m_NumLiveDebris );
+}
+
+int32 ASliceManager::FindCapSection( UProceduralMeshComponent * Target ) const
+{
+	const int32 LastSection = Target->GetNumSections() - 1;
+
+	if( m_CapMaterial && LastSection >= 0 && Target->GetMaterial( LastSection ) == m_CapMaterial )
+		return LastSection;
+
+	return Target->GetNumSections();
+}
+
+void ASliceManager::ApplySlice( FSliceJob & Job )
+{
+	m_WorkerSeconds += Job.WorkerSeconds;
+
+	UProceduralMeshComponent * Target = Job.Target.Get();
+	if( !Target || Target->IsPendingKill() || !Job.Result.bSliced )
+		return;
+
+	++m_NumSlices;
+
+	FMeshSliceResult & Result = Job.Result;
+	const int32 CapIndex = FindCapSection( Target );
+
+	/* Debris first, it takes materials of the sections before the cap is added to Target */
+	const int32 DebrisIndex = AcquireDebris();
+	if( DebrisIndex != INDEX_NONE )
+	{
+		FSliceDebris & Debris = m_Debris[ DebrisIndex ];
+		UProceduralMeshComponent * Piece = Debris.Component;
+
+		Piece->SetWorldTransform( Target->GetComponentTransform() );
+		SetSections( Piece, Result.DebrisSections, Result.DebrisCap, CapIndex );
+
+		for( int32 i = 0; i < Piece->GetNumSections(); ++i )
+			Piece->SetMaterial( i, i == CapIndex && m_CapMaterial ? m_CapMaterial : Target->GetMaterial( i ) );
+
+		/* Body is created when async cooking finishes and starts simulating then, impulse waits for it */
+		Piece->BodyInstance.bSimulatePhysics = true;
+		Piece->AddCollisionConvexMesh( Result.DebrisHull );
+		Piece->SetCollisionEnabled( ECollisionEnabled::QueryAndPhysics );
+		Piece->SetCastShadow( true );
+		Piece->SetVisibility( true );
+
+		Debris.bActive = true;
+		Debris.SpawnTime = GetWorld()->GetTimeSeconds();
+		Debris.SpawnScale = Piece->GetComponentScale();
+		Debris.bCastsShadow = true;
+		Debris.PendingImpulse = -Job.WorldNormal * DebrisImpulse;
+		Debris.bImpulsePending = true;
+
+		++m_NumLiveDebris;
+	}
+
+	SetSections( Target, Result.KeptSections, Result.KeptCap, CapIndex );
+
+	if( m_CapMaterial )
+		Target->SetMaterial( CapIndex, m_CapMaterial );
+
+	if( !Target->bUseComplexAsSimpleCollision )
+	{
+		Target->ClearCollisionConvexMeshes();
+		Target->AddCollisionConvexMesh( Result.KeptHull );
+	}
+}
+
+int32 ASliceManager::AcquireDebris()
+{
+	int32 Oldest = INDEX_NONE;
+
+	for( int32 i = 0; i < m_Debris.Num(); ++i )
+	{
+		if( !m_Debris[ i ].bActive )
+			return i;
+
+		if( Oldest == INDEX_NONE || m_Debris[ i ].SpawnTime < m_Debris[ Oldest ].SpawnTime )
+			Oldest = i;
+	}
+
+	/* Pool is full, the oldest piece disappears a bit early */
+	if( Oldest != INDEX_NONE )
+	{
+		ReleaseDebris( m_Debris[ Oldest ] );
+		++m_NumRecycled;
+	}
+
+	return Oldest;
+}
+
+void ASliceManager::ReleaseDebris( FSliceDebris & Debris )
+{
+	UProceduralMeshComponent * Piece = Debris.Component;
+
+	Piece->SetSimulatePhysics( false );
+	Piece->BodyInstance.bSimulatePhysics = false;
+	Piece->SetCollisionEnabled( ECollisionEnabled::NoCollision );
+	Piece->SetVisibility( false );
+	Piece->ClearAllMeshSections();
+	Piece->ClearCollisionConvexMeshes();
+	Piece->SetWorldScale3D( FVector::OneVector );
+
+	if( Debris.bActive )
+		--m_NumLiveDebris;
+
+	Debris.bActive = false;
+	Debris.bImpulsePending = false;
+}
+
+void ASliceManager::UpdateDebris()
+{
+	if( m_NumLiveDebris == 0 )
+		return;
+
+	const float Now = GetWorld()->GetTimeSeconds();
+
+	/* Short lifetime once the pool is three quarters full, so recycling visible pieces stays rare */
+	const bool bUnderPressure = m_NumLiveDebris * 4 >= m_Debris.Num() * 3;
+	const float Lifetime = DebrisLifetime * ( bUnderPressure ? PressureLifetimeScale : 1.f );
+
+	for( FSliceDebris & Debris : m_Debris )
+	{
+		if( !Debris.bActive )
+			continue;
+
+		UProceduralMeshComponent * Piece = Debris.Component;
+		const float Age = Now - Debris.SpawnTime;
+
+		if( Age >= Lifetime )
+		{
+			ReleaseDebris( Debris );
+			continue;
+		}
+
+		if( Debris.bImpulsePending && Piece->IsSimulatingPhysics() )
+		{
+			Piece->AddImpulse( Debris.PendingImpulse, NAME_None, true );
+			Debris.bImpulsePending = false;
+		}
+
+		if( Debris.bCastsShadow && Age >= DebrisShadowAge )
+		{
+			Piece->SetCastShadow( false );
+			Debris.bCastsShadow = false;
+		}
+
+		const float ShrinkAlpha = ( Lifetime - Age ) / FMath::Max( DebrisShrinkTime, KINDA_SMALL_NUMBER );
+		if( ShrinkAlpha < 1.f )
+			Piece->SetWorldScale3D( Debris.SpawnScale * FMath::Max( ShrinkAlpha, 0.01f ) );
+	}
+}
+
+void ASliceManager::LogStats() const
+{
+	UE_LOG( LogTemp, Log, TEXT( "Slicing : %d cuts, %d rejected, %d debris recycled, %d of %d debris live, %.2f ms average on workers." ),
+			m_NumSlices, m_NumRejected, m_NumRecycled, m_NumLiveDebris, m_Debris.Num(),
+			m_NumSlices > 0 ? m_WorkerSeconds * 1000.0 / m_NumSlices : 0.0 );
+}
@@ -0,0 +1,138 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "UObject/SoftObjectPath.h"
+#include "SliceManager.generated.h"
+
+class UProceduralMeshComponent;
+class UMaterialInterface;
+struct FSliceJob;
+
+DECLARE_STATS_GROUP( TEXT( "Slicing" ), STATGROUP_Slicing, STATCAT_Advanced );
+
+/* One pooled debris piece */
+USTRUCT()
+struct FSliceDebris
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	UProceduralMeshComponent *			Component = nullptr;
+
+	bool								bActive = false;
+
+	/* World time the piece was cut off */
+	float								SpawnTime = 0.f;
+	FVector								SpawnScale = FVector::OneVector;
+	bool								bCastsShadow = true;
+
+	/* Velocity change applied once the cooked body starts simulating */
+	FVector								PendingImpulse = FVector::ZeroVector;
+	bool								bImpulsePending = false;
+};
+
+/**
+* Per-world manager of procedural mesh slicing.
+* The plane cut and cap triangulation run on thread pool workers on copies of the mesh sections,
+* finished cuts are applied on game thread a few per frame. The cut off half goes to a pooled
+* procedural mesh component - the pool is created in BeginPlay and the oldest piece is recycled
+* when it runs out. Debris loses shadows with age, shrinks and is released at the end of its lifetime,
+* lifetime gets shorter when the pool is almost full.
+* Slicing is cosmetic, every machine cuts on its own. Not spawned on dedicated server, Get returns null there.
+*/
+UCLASS( NotPlaceable, Transient, Config = Game )
+class STARWARSARENA_API ASliceManager : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	ASliceManager();
+
+	/* Returns manager of the world, spawning it on first use. Null on dedicated server */
+	static ASliceManager *				Get( UWorld * World, bool bSpawnIfMissing = true );
+
+	/* Queues a cut of Target by a world space plane. Positive side stays on Target, negative side becomes debris.
+	False if the cut was rejected - Target is too small, already being cut or too many cuts are in flight */
+	bool								RequestSlice( UProceduralMeshComponent * Target, const FVector & PlanePosition, const FVector & PlaneNormal );
+
+	virtual void						Tick( float DeltaTime ) override;
+
+	/* Cuts, rejected cuts, recycled debris and worker time since the manager started */
+	void								LogStats() const;
+
+protected:
+	virtual void						BeginPlay() override;
+	virtual void						EndPlay( const EEndPlayReason::Type EndPlayReason ) override;
+
+	UPROPERTY( Config )
+	int32								MaxJobsInFlight;
+
+	/* Finished cuts applied per frame, the rest wait for the next frame */
+	UPROPERTY( Config )
+	int32								MaxAppliesPerFrame;
+
+	/* Size of the debris pool */
+	UPROPERTY( Config )
+	int32								MaxLiveDebris;
+
+	/* Seconds a debris piece lives */
+	UPROPERTY( Config )
+	float								DebrisLifetime;
+
+	/* Debris stops casting shadows at this age */
+	UPROPERTY( Config )
+	float								DebrisShadowAge;
+
+	/* Last seconds of lifetime the piece shrinks to nothing */
+	UPROPERTY( Config )
+	float								DebrisShrinkTime;
+
+	/* Lifetime multiplier once the pool is three quarters full */
+	UPROPERTY( Config )
+	float								PressureLifetimeScale;
+
+	/* Velocity the debris gets away from the cut, cm/s */
+	UPROPERTY( Config )
+	float								DebrisImpulse;
+
+	/* Targets with a smaller bounds radius are not cut anymore */
+	UPROPERTY( Config )
+	float								MinSliceSize;
+
+	/* Material of the cut surface */
+	UPROPERTY( Config )
+	FSoftObjectPath						CapMaterial;
+
+private:
+	/* Game thread part of a finished cut */
+	void								ApplySlice( FSliceJob & Job );
+
+	/* Free piece, or the oldest live one */
+	int32								AcquireDebris();
+
+	void								ReleaseDebris( FSliceDebris & Debris );
+
+	/* Shadow, shrink and release of live debris */
+	void								UpdateDebris();
+
+	/* Slot where the cap of Target goes. Cap section of an earlier cut is reused, so sections do not pile up */
+	int32								FindCapSection( UProceduralMeshComponent * Target ) const;
+
+	TArray<TSharedPtr<FSliceJob, ESPMode::ThreadSafe>>	m_Jobs;
+
+	UPROPERTY()
+	TArray<FSliceDebris>				m_Debris;
+
+	UPROPERTY()
+	UMaterialInterface *				m_CapMaterial;
+
+	int32								m_NumLiveDebris;
+
+	int32								m_NumSlices;
+	int32								m_NumRejected;
+	int32								m_NumRecycled;
+	double								m_WorkerSeconds;
+};
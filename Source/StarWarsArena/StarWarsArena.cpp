@@ -2,5 +2,15 @@
 
 #include "StarWarsArena.h"
 #include "Modules/ModuleManager.h"
+#include "Diagnostics/CombatMemory.h"
 
-IMPLEMENT_PRIMARY_GAME_MODULE( FDefaultGameModuleImpl, StarWarsArena, "StarWarsArena" );
+class FStarWarsArenaModule : public FDefaultGameModuleImpl
+{
+public:
+	virtual void StartupModule() override
+	{
+		CombatMemory::RegisterLLMTags();
+	}
+};
+
+IMPLEMENT_PRIMARY_GAME_MODULE( FStarWarsArenaModule, StarWarsArena, "StarWarsArena" );
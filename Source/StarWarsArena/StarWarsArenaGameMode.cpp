@@ -1,7 +1,136 @@
 // Fill out your copyright notice in the Description page of Project Settings.
 
 #include "StarWarsArenaGameMode.h"
+#include "StarWarsArenaGameState.h"
+#include "Human.h"
+#include "Net/CombatBroadcast.h"
+#include "Net/CombatClock.h"
+#include "Diagnostics/HitchWatchdog.h"
+#include "Diagnostics/CombatMemory.h"
+#include "AI/HumanBotManager.h"
+#include "GameFramework/GameSession.h"
+#include "Kismet/GameplayStatics.h"
+#include "HAL/PlatformMemory.h"
+#include "GameFramework/PlayerStart.h"
+#include "TimerManager.h"
+#include "Misc/CommandLine.h"
 
+#include "EngineUtils.h"
 
+AStarWarsArenaGameMode::AStarWarsArenaGameMode() :
+	bFreeForAll( false ),
+	MaxArenaPlayers( 64 ),
+	m_RoundNumber( 0 ),
+	m_BroadcastArena( 0 ),
+	m_NumStartBots( 0 ),
+	m_bLogMemoryReport( false )
+{
+	GameStateClass = AStarWarsArenaGameState::StaticClass();
+}
 
+void AStarWarsArenaGameMode::InitGame( const FString & MapName, const FString & Options, FString & ErrorMessage )
+{
+	Super::InitGame( MapName, Options, ErrorMessage );
 
+	if( UGameplayStatics::HasOption( Options, TEXT( "FFA" ) ) )
+		bFreeForAll = true;
+
+	/* Spectator stream goes to a relay, ?Broadcast=host:port?BroadcastArena=N */
+	m_BroadcastRelay = UGameplayStatics::ParseOption( Options, TEXT( "Broadcast" ) );
+	m_BroadcastArena = UGameplayStatics::GetIntOption( Options, TEXT( "BroadcastArena" ), 0 );
+
+	m_NumStartBots = FMath::Max( UGameplayStatics::GetIntOption( Options, TEXT( "Bots" ), 0 ), 0 );
+
+	/* Session is spawned by Super::InitGame */
+	if( bFreeForAll && GameSession )
+	{
+		GameSession->MaxPlayers = FMath::Clamp( MaxArenaPlayers, 2, 64 );
+		UE_LOG( LogTemp, Log, TEXT( "%s : free-for-all arena for up to %d players." ), *GetName(), GameSession->MaxPlayers );
+	}
+}
+
+void AStarWarsArenaGameMode::StartPlay()
+{
+	Super::StartPlay();
+
+	for( TActorIterator<APlayerStart> It( GetWorld() ); It; ++It )
+		m_PlayerStarts.Add( *It );
+
+	m_RoundNumber = 1;
+
+	AHitchWatchdog::Get( GetWorld() );
+
+	/* Budgets are checked on dedicated servers, -CombatMemoryReport checks and logs the report anywhere */
+	m_bLogMemoryReport = FParse::Param( FCommandLine::Get(), TEXT( "CombatMemoryReport" ) );
+
+	const float MemoryCheckInterval = GetDefault<UCombatMemorySettings>()->CheckInterval;
+	if( MemoryCheckInterval > 0.f && ( m_bLogMemoryReport || GetNetMode() == NM_DedicatedServer ) )
+		GetWorldTimerManager().SetTimer( m_MemoryCheckTimer, this, &AStarWarsArenaGameMode::CheckCombatMemory, MemoryCheckInterval, true );
+
+	if( !m_BroadcastRelay.IsEmpty() )
+	{
+		if( ACombatBroadcaster * Broadcaster = ACombatBroadcaster::Get( GetWorld() ) )
+			Broadcaster->StartBroadcast( m_BroadcastRelay, uint16( m_BroadcastArena ) );
+	}
+
+	if( m_NumStartBots > 0 )
+	{
+		if( AHumanBotManager * BotManager = AHumanBotManager::Get( GetWorld() ) )
+			BotManager->SpawnBots( m_NumStartBots );
+	}
+
+	if( GetNetMode() != NM_DedicatedServer )
+		return;
+
+	const FPlatformMemoryStats MemoryStats = FPlatformMemory::GetStats();
+
+	UE_LOG( LogTemp, Display, TEXT( "Dedicated server ready in %.2f s, resident memory %.1f MB ( peak %.1f MB )." ),
+			FPlatformTime::Seconds() - GStartTime,
+			MemoryStats.UsedPhysical / ( 1024.f * 1024.f ),
+			MemoryStats.PeakUsedPhysical / ( 1024.f * 1024.f ) );
+}
+
+void AStarWarsArenaGameMode::PostLogin( APlayerController * NewPlayer )
+{
+	Super::PostLogin( NewPlayer );
+
+	UCombatClockComponent::AddTo( NewPlayer );
+}
+
+void AStarWarsArenaGameMode::CheckCombatMemory()
+{
+	const FCombatMemoryReport Report = CombatMemory::Measure( GetWorld() );
+
+	if( m_bLogMemoryReport )
+		CombatMemory::LogReport( Report );
+
+	CombatMemory::CheckBudgets( Report );
+}
+
+void AStarWarsArenaGameMode::StartNewRound()
+{
+	const double StartTime = FPlatformTime::Seconds();
+
+	/* Humans keep their actors, channels and sabers. Only state is reset and replicated */
+	int32 NumHumans = 0;
+	for( TActorIterator<AHuman> It( GetWorld() ); It; ++It )
+	{
+		AHuman * Human = *It;
+		if( Human->IsPendingKill() )
+			continue;
+
+		const FTransform StartTransform = m_PlayerStarts.Num() > 0 && m_PlayerStarts[ NumHumans % m_PlayerStarts.Num() ]
+										? m_PlayerStarts[ NumHumans % m_PlayerStarts.Num() ]->GetActorTransform()
+										: Human->GetActorTransform();
+
+		Human->ResetForRound( FTransform( StartTransform.GetRotation(), StartTransform.GetLocation() ) );
+		++NumHumans;
+	}
+
+	++m_RoundNumber;
+
+	UE_LOG( LogTemp, Log, TEXT( "%s : round %d started, %d humans reset in %.3f ms." ),
+			*GetName(), m_RoundNumber, NumHumans, ( FPlatformTime::Seconds() - StartTime ) * 1000.0 );
+
+	OnRoundStarted( m_RoundNumber );
+}
@@ -6,6 +6,8 @@
 #include "GameFramework/GameModeBase.h"
 #include "StarWarsArenaGameMode.generated.h"
 
+class APlayerStart;
+
 /**
  * 
  */
@@ -14,7 +16,54 @@ class STARWARSARENA_API AStarWarsArenaGameMode : public AGameModeBase
 {
 	GENERATED_BODY()
 	
-	
-	
-	
+public:
+	AStarWarsArenaGameMode();
+
+	virtual void					InitGame( const FString & MapName, const FString & Options, FString & ErrorMessage ) override;
+
+	/* Dedicated server logs its startup time and resident memory here, to see how many processes fit on a host */
+	virtual void					StartPlay() override;
+
+	/* Gives the new player its combat clock */
+	virtual void					PostLogin( APlayerController * NewPlayer ) override;
+
+	/* Resets every human and saber in place and moves humans to player starts. No actors are spawned or destroyed */
+	UFUNCTION( Exec, BlueprintCallable, Category = "Arena", Meta = ( DisplayName = "StartNewRound" ) )
+	void							StartNewRound();
+
+	UFUNCTION( BlueprintPure, Category = "Arena", Meta = ( DisplayName = "GetRoundNumber" ) )
+	int32							GetRoundNumber() const										{ return m_RoundNumber; }
+
+protected:
+	/* Called after all humans were reset */
+	UFUNCTION( BlueprintImplementableEvent, Category = "Arena", Meta = ( DisplayName = "OnRoundStarted" ) )
+	void							OnRoundStarted( int32 RoundNumber );
+
+	/* Free-for-all arena instead of 1v1 duel. Can also be enabled with ?FFA in travel URL */
+	UPROPERTY( Config, BlueprintReadOnly, EditDefaultsOnly, Category = "Arena", Meta = ( DisplayName = "bFreeForAll" ) )
+	bool							bFreeForAll;
+
+	/* Player limit of free-for-all arena */
+	UPROPERTY( Config, BlueprintReadOnly, EditDefaultsOnly, Category = "Arena", Meta = ( DisplayName = "MaxArenaPlayers", ClampMin = "2", ClampMax = "64" ) )
+	int32							MaxArenaPlayers;
+
+private:
+	/* Measures combat memory of the arena and warns about exceeded budgets, logs the whole report with -CombatMemoryReport */
+	void							CheckCombatMemory();
+
+	/* Gathered once in StartPlay, so round turnover does not allocate */
+	UPROPERTY()
+	TArray<APlayerStart *>			m_PlayerStarts;
+
+	int32							m_RoundNumber;
+
+	/* Combat broadcast relay and arena id from the travel URL, no broadcast if empty */
+	FString							m_BroadcastRelay;
+	int32							m_BroadcastArena;
+
+	/* Bots spawned when play starts, ?Bots=N in travel URL */
+	int32							m_NumStartBots;
+
+	FTimerHandle					m_MemoryCheckTimer;
+	bool							m_bLogMemoryReport;
 };
@@ -0,0 +1,154 @@
+#include "StarWarsArenaGameState.h"
+#include "Human.h"
+#include "GameFramework/PlayerState.h"
+#include "Engine/World.h"
+#include "UnrealNetwork.h"
+
+void FPlayerCombatStats::PostReplicatedAdd( const FPlayerCombatStatsArray & InArraySerializer )
+{
+	if( InArraySerializer.Owner )
+		InArraySerializer.Owner->OnPlayerCombatStatsChanged.Broadcast( *this );
+}
+
+void FPlayerCombatStats::PostReplicatedChange( const FPlayerCombatStatsArray & InArraySerializer )
+{
+	if( InArraySerializer.Owner )
+		InArraySerializer.Owner->OnPlayerCombatStatsChanged.Broadcast( *this );
+}
+
+void FPlayerCombatStats::PreReplicatedRemove( const FPlayerCombatStatsArray & InArraySerializer )
+{
+}
+
+AStarWarsArenaGameState::AStarWarsArenaGameState()
+{
+	m_CombatStats.Owner = this;
+}
+
+void AStarWarsArenaGameState::GetLifetimeReplicatedProps( TArray<FLifetimeProperty> & OutLifetimeProps ) const
+{
+	Super::GetLifetimeReplicatedProps( OutLifetimeProps );
+
+	DOREPLIFETIME( AStarWarsArenaGameState, m_CombatStats );
+}
+
+AStarWarsArenaGameState * AStarWarsArenaGameState::Get( UWorld * World )
+{
+	return World ? World->GetGameState<AStarWarsArenaGameState>() : nullptr;
+}
+
+void AStarWarsArenaGameState::RemovePlayerState( APlayerState * PlayerState )
+{
+	if( HasAuthority() )
+	{
+		const int32 Index = m_CombatStats.Items.IndexOfByPredicate( [ PlayerState ]( const FPlayerCombatStats & Entry )
+		{
+			return Entry.PlayerState == PlayerState;
+		} );
+
+		if( Index != INDEX_NONE )
+		{
+			m_CombatStats.Items.RemoveAtSwap( Index );
+			m_CombatStats.MarkArrayDirty();
+		}
+	}
+
+	Super::RemovePlayerState( PlayerState );
+}
+
+FPlayerCombatStats * AStarWarsArenaGameState::FindOrAddEntry( AHuman * Human )
+{
+	if( !HasAuthority() || !Human || !Human->PlayerState )
+		return nullptr;
+
+	for( FPlayerCombatStats & Entry : m_CombatStats.Items )
+	{
+		if( Entry.PlayerState == Human->PlayerState )
+			return &Entry;
+	}
+
+	FPlayerCombatStats & Entry = m_CombatStats.Items[ m_CombatStats.Items.AddDefaulted() ];
+	Entry.PlayerState = Human->PlayerState;
+	m_CombatStats.MarkItemDirty( Entry );
+
+	return &Entry;
+}
+
+void AStarWarsArenaGameState::MarkChanged( FPlayerCombatStats & Entry )
+{
+	m_CombatStats.MarkItemDirty( Entry );
+
+	/* Server does not get replication callbacks */
+	OnPlayerCombatStatsChanged.Broadcast( Entry );
+}
+
+void AStarWarsArenaGameState::RecordDamage( AHuman * Attacker, AHuman * Victim, int32 Damage )
+{
+	if( Damage <= 0 )
+		return;
+
+	if( FPlayerCombatStats * Entry = FindOrAddEntry( Attacker ) )
+	{
+		Entry->DamageDealt += Damage;
+		MarkChanged( *Entry );
+	}
+
+	if( FPlayerCombatStats * Entry = FindOrAddEntry( Victim ) )
+	{
+		Entry->DamageTaken += Damage;
+		MarkChanged( *Entry );
+	}
+}
+
+void AStarWarsArenaGameState::RecordBlock( AHuman * Attacker, AHuman * Defender )
+{
+	if( FPlayerCombatStats * Entry = FindOrAddEntry( Attacker ) )
+	{
+		++Entry->AttacksBlocked;
+		MarkChanged( *Entry );
+	}
+
+	if( FPlayerCombatStats * Entry = FindOrAddEntry( Defender ) )
+	{
+		++Entry->Blocks;
+		MarkChanged( *Entry );
+	}
+}
+
+void AStarWarsArenaGameState::RecordClash( AHuman * Human, AHuman * Enemy )
+{
+	if( FPlayerCombatStats * Entry = FindOrAddEntry( Human ) )
+	{
+		++Entry->Clashes;
+		MarkChanged( *Entry );
+	}
+
+	if( FPlayerCombatStats * Entry = FindOrAddEntry( Enemy ) )
+	{
+		++Entry->Clashes;
+		MarkChanged( *Entry );
+	}
+}
+
+void AStarWarsArenaGameState::RecordSaberThrow( AHuman * Human )
+{
+	if( FPlayerCombatStats * Entry = FindOrAddEntry( Human ) )
+	{
+		++Entry->SaberThrows;
+		MarkChanged( *Entry );
+	}
+}
+
+bool AStarWarsArenaGameState::FindPlayerCombatStats( APlayerState * PlayerState, FPlayerCombatStats & OutStats ) const
+{
+	for( const FPlayerCombatStats & Entry : m_CombatStats.Items )
+	{
+		if( Entry.PlayerState == PlayerState )
+		{
+			OutStats = Entry;
+			return true;
+		}
+	}
+
+	return false;
+}
@@ -0,0 +1,125 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/GameStateBase.h"
+#include "Engine/NetSerialization.h"
+#include "StarWarsArenaGameState.generated.h"
+
+class AStarWarsArenaGameState;
+class APlayerState;
+class AHuman;
+
+/* Match combat statistics of one player */
+USTRUCT( BlueprintType )
+struct FPlayerCombatStats : public FFastArraySerializerItem
+{
+	GENERATED_BODY()
+
+	UPROPERTY( BlueprintReadOnly, Category = "Scoreboard", Meta = ( DisplayName = "PlayerState" ) )
+	APlayerState *						PlayerState = nullptr;
+
+	UPROPERTY( BlueprintReadOnly, Category = "Scoreboard", Meta = ( DisplayName = "DamageDealt" ) )
+	int32								DamageDealt = 0;
+
+	UPROPERTY( BlueprintReadOnly, Category = "Scoreboard", Meta = ( DisplayName = "DamageTaken" ) )
+	int32								DamageTaken = 0;
+
+	/* Enemy attacks stopped by defending */
+	UPROPERTY( BlueprintReadOnly, Category = "Scoreboard", Meta = ( DisplayName = "Blocks" ) )
+	int32								Blocks = 0;
+
+	/* Attacks of this player stopped by defending enemy */
+	UPROPERTY( BlueprintReadOnly, Category = "Scoreboard", Meta = ( DisplayName = "AttacksBlocked" ) )
+	int32								AttacksBlocked = 0;
+
+	/* Attack against attack */
+	UPROPERTY( BlueprintReadOnly, Category = "Scoreboard", Meta = ( DisplayName = "Clashes" ) )
+	int32								Clashes = 0;
+
+	UPROPERTY( BlueprintReadOnly, Category = "Scoreboard", Meta = ( DisplayName = "SaberThrows" ) )
+	int32								SaberThrows = 0;
+
+	void								PostReplicatedAdd( const struct FPlayerCombatStatsArray & InArraySerializer );
+	void								PostReplicatedChange( const struct FPlayerCombatStatsArray & InArraySerializer );
+	void								PreReplicatedRemove( const struct FPlayerCombatStatsArray & InArraySerializer );
+};
+
+/* Fast array of all players' stats, only entries marked dirty are sent */
+USTRUCT()
+struct FPlayerCombatStatsArray : public FFastArraySerializer
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	TArray<FPlayerCombatStats>			Items;
+
+	UPROPERTY( NotReplicated )
+	AStarWarsArenaGameState *			Owner = nullptr;
+
+	bool NetDeltaSerialize( FNetDeltaSerializeInfo & DeltaParms )
+	{
+		return FFastArraySerializer::FastArrayDeltaSerialize<FPlayerCombatStats, FPlayerCombatStatsArray>( Items, DeltaParms, *this );
+	}
+};
+
+template<>
+struct TStructOpsTypeTraits<FPlayerCombatStatsArray> : public TStructOpsTypeTraitsBase2<FPlayerCombatStatsArray>
+{
+	enum
+	{
+		WithNetDeltaSerializer = true
+	};
+};
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam( FOnPlayerCombatStatsChanged, const FPlayerCombatStats &, Stats );
+
+/**
+* Match scoreboard. Server records combat events at hit resolution points,
+* clients receive only entries that changed since the last update.
+*/
+UCLASS()
+class STARWARSARENA_API AStarWarsArenaGameState : public AGameStateBase
+{
+	GENERATED_BODY()
+
+public:
+	AStarWarsArenaGameState();
+
+	virtual void						GetLifetimeReplicatedProps( TArray<FLifetimeProperty>& OutLifetimeProps ) const override;
+
+	virtual void						RemovePlayerState( APlayerState * PlayerState ) override;
+
+	/* Returns game state of the world if it is an arena game state */
+	static AStarWarsArenaGameState *	Get( UWorld * World );
+
+	/// Server side recording, ignored on clients
+	void								RecordDamage( AHuman * Attacker, AHuman * Victim, int32 Damage );
+
+	void								RecordBlock( AHuman * Attacker, AHuman * Defender );
+
+	void								RecordClash( AHuman * Human, AHuman * Enemy );
+
+	void								RecordSaberThrow( AHuman * Human );
+
+	UFUNCTION( BlueprintPure, Category = "Scoreboard", Meta = ( DisplayName = "GetCombatStats" ) )
+	const TArray<FPlayerCombatStats> &	GetCombatStats() const								{ return m_CombatStats.Items; }
+
+	/* Returns stats of the player, false if player has no entry yet */
+	UFUNCTION( BlueprintPure, Category = "Scoreboard", Meta = ( DisplayName = "FindPlayerCombatStats" ) )
+	bool								FindPlayerCombatStats( APlayerState * PlayerState, FPlayerCombatStats & OutStats ) const;
+
+	/* Called on server and clients for every added or changed entry */
+	UPROPERTY( BlueprintAssignable, Category = "Scoreboard", Meta = ( DisplayName = "OnPlayerCombatStatsChanged" ) )
+	FOnPlayerCombatStatsChanged			OnPlayerCombatStatsChanged;
+
+private:
+	/* Entry of human's player, created on first event. Null for humans without player state or on clients */
+	FPlayerCombatStats *				FindOrAddEntry( AHuman * Human );
+
+	void								MarkChanged( FPlayerCombatStats & Entry );
+
+	UPROPERTY( Replicated )
+	FPlayerCombatStatsArray				m_CombatStats;
+};
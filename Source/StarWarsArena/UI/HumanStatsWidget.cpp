@@ -0,0 +1,87 @@
+#include "HumanStatsWidget.h"
+#include "Components/ProgressBar.h"
+#include "Curves/CurveFloat.h"
+
+void UHumanStatsWidget::SetHuman( AHuman * NewHuman )
+{
+	if( AHuman * OldHuman = m_Human.Get() )
+	{
+		OldHuman->OnStatsChanged.RemoveDynamic( this, &UHumanStatsWidget::HandleStatsChanged );
+		OldHuman->OnStateChanged.RemoveDynamic( this, &UHumanStatsWidget::HandleStateChanged );
+	}
+
+	m_Human = NewHuman;
+
+	if( !NewHuman )
+		return;
+
+	NewHuman->OnStatsChanged.AddDynamic( this, &UHumanStatsWidget::HandleStatsChanged );
+	NewHuman->OnStateChanged.AddDynamic( this, &UHumanStatsWidget::HandleStateChanged );
+
+	/* Initial values are shown without interpolation */
+	HandleStatsChanged( NewHuman, NewHuman->GetCurrentStats() );
+	m_InterpAlpha = 1.f;
+	SetBarPercents( m_ToPercents );
+
+	HandleStateChanged( NewHuman, NewHuman->GetState() );
+}
+
+void UHumanStatsWidget::NativeDestruct()
+{
+	SetHuman( nullptr );
+
+	Super::NativeDestruct();
+}
+
+void UHumanStatsWidget::NativeTick( const FGeometry & MyGeometry, float InDeltaTime )
+{
+	Super::NativeTick( MyGeometry, InDeltaTime );
+
+	/* Nothing to do between combat events */
+	if( m_InterpAlpha >= 1.f )
+		return;
+
+	m_InterpAlpha = InterpolationTime > 0.f ? FMath::Min( m_InterpAlpha + InDeltaTime / InterpolationTime, 1.f ) : 1.f;
+
+	const float Eased = InterpolationCurve ? InterpolationCurve->GetFloatValue( m_InterpAlpha ) : m_InterpAlpha;
+	SetBarPercents( FMath::Lerp( m_FromPercents, m_ToPercents, m_InterpAlpha >= 1.f ? 1.f : Eased ) );
+}
+
+void UHumanStatsWidget::HandleStatsChanged( AHuman * Human, const FHumanStats & NewStats )
+{
+	const FHumanStats MaxStats = Human->GetMaxStats();
+
+	m_FromPercents = m_ShownPercents;
+	m_ToPercents = FVector( MaxStats.HS_Health > 0 ? float( NewStats.HS_Health ) / MaxStats.HS_Health : 0.f,
+							MaxStats.HS_Stamina > 0 ? float( NewStats.HS_Stamina ) / MaxStats.HS_Stamina : 0.f,
+							MaxStats.HS_Force > 0 ? float( NewStats.HS_Force ) / MaxStats.HS_Force : 0.f );
+	m_InterpAlpha = 0.f;
+
+	if( InterpolationTime <= 0.f )
+	{
+		m_InterpAlpha = 1.f;
+		SetBarPercents( m_ToPercents );
+	}
+
+	OnStatsUpdated( NewStats, MaxStats );
+}
+
+void UHumanStatsWidget::HandleStateChanged( AHuman * Human, EHumanState NewState )
+{
+	OnStateUpdated( NewState );
+}
+
+void UHumanStatsWidget::SetBarPercents( const FVector & Percents )
+{
+	/* Progress bar invalidates its layout on every set, skip values that did not change */
+	if( HealthBar && Percents.X != m_ShownPercents.X )
+		HealthBar->SetPercent( Percents.X );
+
+	if( StaminaBar && Percents.Y != m_ShownPercents.Y )
+		StaminaBar->SetPercent( Percents.Y );
+
+	if( ForceBar && Percents.Z != m_ShownPercents.Z )
+		ForceBar->SetPercent( Percents.Z );
+
+	m_ShownPercents = Percents;
+}
@@ -0,0 +1,75 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Blueprint/UserWidget.h"
+#include "Human.h"
+#include "HumanStatsWidget.generated.h"
+
+class UProgressBar;
+class UCurveFloat;
+
+/**
+* Stats HUD driven by AHuman change delegates instead of per-frame property bindings.
+* Bars are only touched when stats change, or while they interpolate to new values.
+* Reparent Stats widget to this class and name its bars HealthBar, StaminaBar and ForceBar.
+*/
+UCLASS()
+class STARWARSARENA_API UHumanStatsWidget : public UUserWidget
+{
+	GENERATED_BODY()
+
+public:
+	/* Starts listening to the human, stops listening to the previous one */
+	UFUNCTION( BlueprintCallable, Category = "Stats", Meta = ( DisplayName = "SetHuman" ) )
+	void								SetHuman( AHuman * NewHuman );
+
+	UFUNCTION( BlueprintPure, Category = "Stats", Meta = ( DisplayName = "GetHuman" ) )
+	AHuman *							GetHuman() const									{ return m_Human.Get(); }
+
+protected:
+	virtual void						NativeDestruct() override;
+	virtual void						NativeTick( const FGeometry & MyGeometry, float InDeltaTime ) override;
+
+	UPROPERTY( BlueprintReadOnly, Category = "Stats", Meta = ( BindWidget, OptionalWidget = true ) )
+	UProgressBar *						HealthBar;
+
+	UPROPERTY( BlueprintReadOnly, Category = "Stats", Meta = ( BindWidget, OptionalWidget = true ) )
+	UProgressBar *						StaminaBar;
+
+	UPROPERTY( BlueprintReadOnly, Category = "Stats", Meta = ( BindWidget, OptionalWidget = true ) )
+	UProgressBar *						ForceBar;
+
+	/* Optional easing of bar interpolation, time and value from 0 to 1. Linear if not set */
+	UPROPERTY( EditAnywhere, BlueprintReadWrite, Category = "Stats", Meta = ( DisplayName = "InterpolationCurve" ) )
+	UCurveFloat *						InterpolationCurve;
+
+	/* Seconds bars take to reach new values. Zero sets them immediately */
+	UPROPERTY( EditAnywhere, BlueprintReadWrite, Category = "Stats", Meta = ( DisplayName = "InterpolationTime" ) )
+	float								InterpolationTime = 0.25f;
+
+	/* Called once per actual change, for texts and effects the bars do not cover */
+	UFUNCTION( BlueprintImplementableEvent, Category = "Stats", Meta = ( DisplayName = "OnStatsUpdated" ) )
+	void								OnStatsUpdated( const FHumanStats & NewStats, const FHumanStats & MaxStats );
+
+	UFUNCTION( BlueprintImplementableEvent, Category = "Stats", Meta = ( DisplayName = "OnStateUpdated" ) )
+	void								OnStateUpdated( EHumanState NewState );
+
+private:
+	UFUNCTION()
+	void								HandleStatsChanged( AHuman * Human, const FHumanStats & NewStats );
+
+	UFUNCTION()
+	void								HandleStateChanged( AHuman * Human, EHumanState NewState );
+
+	void								SetBarPercents( const FVector & Percents );
+
+	TWeakObjectPtr<AHuman>				m_Human;
+
+	/* Health, stamina and force bar percents interpolate from From to To, m_InterpAlpha >= 1 means bars are at rest */
+	FVector								m_FromPercents = FVector::ZeroVector;
+	FVector								m_ToPercents = FVector::ZeroVector;
+	FVector								m_ShownPercents = FVector::ZeroVector;
+	float								m_InterpAlpha = 1.f;
+};
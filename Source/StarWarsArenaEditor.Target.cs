@@ -9,6 +9,6 @@ public class StarWarsArenaEditorTarget : TargetRules
 	{
 		Type = TargetType.Editor;
 
-		ExtraModuleNames.AddRange( new string[] { "StarWarsArena" } );
+		ExtraModuleNames.AddRange( new string[] { "StarWarsArena", "StarWarsArenaTests" } );
 	}
 }
@@ -0,0 +1,24 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MoveSet.h"
+#include "BenchmarkMoveSet.generated.h"
+
+/* Move set filled from code instead of a blueprint, for benchmarks */
+UCLASS( NotBlueprintable, Transient )
+class UBenchmarkMoveSet : public UMoveSet
+{
+	GENERATED_BODY()
+
+public:
+	/* Fills attacks and runs BeginPlay, component has to be registered to its character */
+	void								Setup( const TArray<FAttackMontage> & Opening, const TMap<FName, FAttackMontage> & Further )
+	{
+		OpeningAttacks = Opening;
+		FurtherAttacks = Further;
+
+		BeginPlay();
+	}
+};
@@ -0,0 +1,306 @@
+#include "CombatPerf.h"
+#include "BenchmarkMoveSet.h"
+#include "Human.h"
+#include "Objects/Saber.h"
+#include "Combat/BladeClash.h"
+#include "Net/CombatBroadcast.h"
+#include "Animation/AnimMontage.h"
+#include "Engine/World.h"
+#include "GameFramework/Character.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "Math/RandomStream.h"
+#include "Serialization/BitWriter.h"
+#include "Serialization/BitReader.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#define COMBAT_PERF_FLAGS	( EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::PerfFilter )
+
+namespace
+{
+	/* Game world with one character owning a move set of 8 opening and all further attacks */
+	struct FMoveSetFixture
+	{
+		UWorld *							World = nullptr;
+		ACharacter *						Character = nullptr;
+		UBenchmarkMoveSet *					MoveSet = nullptr;
+		TArray<FAttackMontage>				Opening;
+
+		/* Not along an axis, so directions are relative to the facing */
+		static constexpr float				FacingYaw = 30.f;
+
+		FMoveSetFixture()
+		{
+			World = UWorld::CreateWorld( EWorldType::Game, false );
+			World->AddToRoot();
+
+			Character = World->SpawnActor<ACharacter>();
+			Character->SetActorRotation( FRotator( 0.f, FacingYaw, 0.f ) );
+			MoveSet = NewObject<UBenchmarkMoveSet>( Character );
+			MoveSet->RegisterComponent();
+
+			for( int32 i = 0; i < 8; ++i )
+				Opening.Add( FAttackMontage( NewObject<UAnimMontage>( World ), 10, 0, 10 ) );
+
+			TMap<FName, FAttackMontage> Further;
+			for( const TCHAR * Name : { TEXT( "Weak" ), TEXT( "Strong" ), TEXT( "WeakWeak" ), TEXT( "WeakStrong" ), TEXT( "StrongWeak" ), TEXT( "StrongStrong" ) } )
+				Further.Add( FName( Name ), FAttackMontage( NewObject<UAnimMontage>( World ), 20, 0, 20 ) );
+
+			MoveSet->Setup( Opening, Further );
+		}
+
+		~FMoveSetFixture()
+		{
+			World->RemoveFromRoot();
+			World->DestroyWorld( false );
+		}
+
+		/* Moves the character at Degrees clockwise from where it faces. Character's GetVelocity reads the movement component,
+		* only the velocity changes so timed loops do not pay for transform updates */
+		void SetMoveDirection( float Degrees )
+		{
+			Character->GetCharacterMovement()->Velocity = FRotator( 0.f, FacingYaw + Degrees, 0.f ).Vector() * 300.f;
+		}
+	};
+
+	/* Round trip through a bit writer and reader, as replication does it */
+	template<typename StructType>
+	bool NetRoundTrip( const StructType & Source, StructType & OutLoaded )
+	{
+		StructType Copy = Source;
+		bool bSuccess = true;
+
+		FBitWriter Writer( 256, true );
+		Copy.NetSerialize( Writer, nullptr, bSuccess );
+
+		FBitReader Reader( Writer.GetData(), Writer.GetNumBits() );
+		OutLoaded.NetSerialize( Reader, nullptr, bSuccess );
+
+		return bSuccess && !Reader.IsError();
+	}
+
+	TArray<FBladeCapsule> MakeBlades( int32 NumBlades, int32 Seed )
+	{
+		FRandomStream Random( Seed );
+		TArray<FBladeCapsule> Blades;
+
+		/* Duel sized cluster, about a third of pairs touch */
+		for( int32 i = 0; i < NumBlades; ++i )
+		{
+			FBladeCapsule Blade;
+			Blade.Start = Random.VRand() * 60.f;
+			Blade.End = Blade.Start + Random.VRand() * 110.f;
+			Blade.Radius = 2.5f;
+			Blade.StartVelocity = Random.VRand() * 100.f;
+			Blade.EndVelocity = Random.VRand() * 400.f;
+			Blades.Add( Blade );
+		}
+
+		return Blades;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST( FMoveSetOpeningBenchmark, "StarWarsArena.Perf.MoveSet.GetOpeningMontage", COMBAT_PERF_FLAGS )
+
+bool FMoveSetOpeningBenchmark::RunTest( const FString & Parameters )
+{
+	FMoveSetFixture Fixture;
+
+	/* Opening attacks are sorted clockwise from front, every 45 degrees picks the next one */
+	for( int32 i = 0; i < 8; ++i )
+	{
+		Fixture.SetMoveDirection( i * 45.f );
+		TestTrue( FString::Printf( TEXT( "Direction %d picks opening attack %d" ), i * 45, i ),
+				  Fixture.MoveSet->GetOpeningMontage().MontageAnimation == Fixture.Opening[ i ].MontageAnimation );
+	}
+
+	const double Ns = CombatPerf::Measure( 20000, [ &Fixture ]( int32 i )
+	{
+		Fixture.SetMoveDirection( ( i % 16 ) * 22.5f );
+		CombatPerf::Sink += Fixture.MoveSet->GetOpeningMontage().StaminaRequired;
+	} );
+
+	return CombatPerf::Report( *this, TEXT( "MoveSet.GetOpeningMontage" ), Ns );
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST( FMoveSetNextBenchmark, "StarWarsArena.Perf.MoveSet.GetNextMontage", COMBAT_PERF_FLAGS )
+
+bool FMoveSetNextBenchmark::RunTest( const FString & Parameters )
+{
+	FMoveSetFixture Fixture;
+	Fixture.SetMoveDirection( 90.f );
+
+	/* Opening, both single presses and all four double presses */
+	const float Presses[][ 2 ] = { { 0.1f, 0.f }, { 0.5f, 0.f }, { 0.1f, 0.1f }, { 0.1f, 0.5f }, { 0.5f, 0.1f }, { 0.5f, 0.5f } };
+	const FAttackMontage Current = Fixture.Opening[ 0 ];
+	const FAttackMontage None( nullptr, 0 );
+
+	TestTrue( TEXT( "No current attack picks an opening attack" ), Fixture.MoveSet->GetNextMontage( 0.1f, 0.f, None ).MontageAnimation == Fixture.Opening[ 2 ].MontageAnimation );
+
+	const double Ns = CombatPerf::Measure( 20000, [ & ]( int32 i )
+	{
+		const int32 Combo = i % 7;
+		const FAttackMontage & Playing = Combo == 6 ? None : Current;
+		const float * Press = Presses[ Combo % 6 ];
+
+		CombatPerf::Sink += Fixture.MoveSet->GetNextMontage( Press[ 0 ], Press[ 1 ], Playing ).DealtDamage;
+	} );
+
+	return CombatPerf::Report( *this, TEXT( "MoveSet.GetNextMontage" ), Ns );
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST( FHumanStatsAddBenchmark, "StarWarsArena.Perf.HumanStats.Add", COMBAT_PERF_FLAGS )
+
+bool FHumanStatsAddBenchmark::RunTest( const FString & Parameters )
+{
+	const FHumanStats Max( 100, 100, 100 );
+
+	TestTrue( TEXT( "Add clamps to max" ), FHumanStats( 90, 50, 10 ).Add( FHumanStats( 20, -60, -30 ), Max ) == FHumanStats( 100, 0, 0 ) );
+
+	FHumanStats Stats( 50, 50, 50 );
+	const double Ns = CombatPerf::Measure( 1000000, [ & ]( int32 i )
+	{
+		Stats = Stats.Add( FHumanStats( ( i & 15 ) - 8, ( i & 7 ) - 4, ( i & 3 ) - 2 ), Max );
+	} );
+
+	CombatPerf::Sink += Stats.HS_Health;
+
+	return CombatPerf::Report( *this, TEXT( "HumanStats.Add" ), Ns );
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST( FSaberFlightBenchmark, "StarWarsArena.Perf.Saber.StepFlight", COMBAT_PERF_FLAGS )
+
+bool FSaberFlightBenchmark::RunTest( const FString & Parameters )
+{
+	const FVector Direction = FRotator( -10.f, 45.f, 0.f ).Vector();
+	const FRotator Spin( 0.f, 0.f, 25.f );
+
+	const FTransform Stepped = ASaber::StepFlight( FTransform::Identity, Direction, 30.f, Spin );
+	TestTrue( TEXT( "Flight moves along direction" ), Stepped.GetLocation().Equals( Direction * 30.f, KINDA_SMALL_NUMBER ) );
+
+	FTransform Transform = FTransform::Identity;
+	const double Ns = CombatPerf::Measure( 200000, [ & ]( int32 i )
+	{
+		Transform = ASaber::StepFlight( Transform, Direction, 30.f, Spin );
+	} );
+
+	CombatPerf::Sink += uint32( Transform.GetLocation().X );
+
+	return CombatPerf::Report( *this, TEXT( "Saber.StepFlight" ), Ns );
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST( FBladeClashBenchmark, "StarWarsArena.Perf.BladeClash.TestPairs", COMBAT_PERF_FLAGS )
+
+bool FBladeClashBenchmark::RunTest( const FString & Parameters )
+{
+	const TArray<FBladeCapsule> Blades = MakeBlades( 32, 1337 );
+
+	TArray<TPair<int32, int32>> Pairs;
+	for( int32 i = 0; i < Blades.Num(); ++i )
+		for( int32 j = i + 1; j < Blades.Num(); ++j )
+			Pairs.Emplace( i, j );
+
+	TArray<FBladeClashResult> Clashes;
+	BladeClash::TestPairs( Blades, Pairs, Clashes );
+	TestTrue( TEXT( "Clustered blades clash" ), Clashes.Num() > 0 );
+
+	/* Per pair, the kernel is batched in lanes */
+	const double Ns = CombatPerf::Measure( 200, [ & ]( int32 i )
+	{
+		Clashes.Reset();
+		BladeClash::TestPairs( Blades, Pairs, Clashes );
+		CombatPerf::Sink += Clashes.Num();
+	} ) / Pairs.Num();
+
+	return CombatPerf::Report( *this, TEXT( "BladeClash.TestPairs" ), Ns );
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST( FCombatNetSerializeBenchmark, "StarWarsArena.Perf.NetSerialize", COMBAT_PERF_FLAGS )
+
+bool FCombatNetSerializeBenchmark::RunTest( const FString & Parameters )
+{
+	FHumanCombatSnapshot Snapshot;
+	Snapshot.Stats = FHumanStats( 73, 41, 58 );
+	Snapshot.State = EHumanState::EHS_Defending;
+	Snapshot.MoveMode = EHumanMoveMode::EHMM_Walk;
+
+	FSaberNetState SaberState;
+	SaberState.BladeFraction = 0.5f;
+	SaberState.State = ESaberState::ESS_Opening;
+	SaberState.Attachment = ESaberAttachment::ESA_Hand;
+
+	FHumanStats LoadedStats;
+	FHumanCombatSnapshot LoadedSnapshot;
+	FSaberNetState LoadedSaberState;
+
+	TestTrue( TEXT( "Stats round trip" ), NetRoundTrip( Snapshot.Stats, LoadedStats ) && LoadedStats == Snapshot.Stats );
+	TestTrue( TEXT( "Negative delta round trip" ), NetRoundTrip( FHumanStats( -25, 130, -40 ), LoadedStats ) && LoadedStats == FHumanStats( -25, 130, -40 ) );
+	TestTrue( TEXT( "Snapshot round trip" ), NetRoundTrip( Snapshot, LoadedSnapshot ) && LoadedSnapshot == Snapshot );
+	TestTrue( TEXT( "Saber state round trip" ), NetRoundTrip( SaberState, LoadedSaberState ) && LoadedSaberState == SaberState );
+
+	bool bPassed = true;
+
+	bPassed &= CombatPerf::Report( *this, TEXT( "NetSerialize.HumanStats" ), CombatPerf::Measure( 50000, [ & ]( int32 i )
+	{
+		CombatPerf::Sink += NetRoundTrip( Snapshot.Stats, LoadedStats ) ? 1 : 0;
+	} ) );
+
+	bPassed &= CombatPerf::Report( *this, TEXT( "NetSerialize.HumanCombatSnapshot" ), CombatPerf::Measure( 50000, [ & ]( int32 i )
+	{
+		CombatPerf::Sink += NetRoundTrip( Snapshot, LoadedSnapshot ) ? 1 : 0;
+	} ) );
+
+	bPassed &= CombatPerf::Report( *this, TEXT( "NetSerialize.SaberNetState" ), CombatPerf::Measure( 50000, [ & ]( int32 i )
+	{
+		CombatPerf::Sink += NetRoundTrip( SaberState, LoadedSaberState ) ? 1 : 0;
+	} ) );
+
+	return bPassed;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST( FCombatBroadcastBenchmark, "StarWarsArena.Perf.CombatBroadcast.Packet", COMBAT_PERF_FLAGS )
+
+bool FCombatBroadcastBenchmark::RunTest( const FString & Parameters )
+{
+	FRandomStream Random( 7 );
+	FCombatBroadcastPacket Packet;
+	Packet.ArenaId = 3;
+	Packet.Sequence = 1000;
+	Packet.ServerTime = 62.5f;
+
+	/* Full packet */
+	for( int32 i = 0; i < CombatBroadcast::MaxHumansPerPacket; ++i )
+	{
+		FBroadcastHuman Human;
+		Human.HumanId = i + 1;
+		Human.Location = Random.VRand() * 2000.f;
+		Human.Yaw = Random.FRandRange( -180.f, 180.f );
+		Human.Stats = FHumanStats( Random.RandRange( 0, 100 ), Random.RandRange( 0, 100 ), Random.RandRange( 0, 100 ) );
+		Human.State = i % 3 == 0 ? EHumanState::EHS_Attacking : EHumanState::EHS_Free;
+		Human.AttackId = Human.State == EHumanState::EHS_Attacking ? Random.GetUnsignedInt() : 0;
+		Human.SaberState = ESaberState::ESS_Opened;
+		Human.BladeFraction = 1.f;
+		Packet.Humans.Add( Human );
+	}
+
+	FBitWriter Writer( 0, true );
+	Packet.Serialize( Writer );
+
+	FCombatBroadcastPacket Loaded;
+	FBitReader Reader( Writer.GetData(), Writer.GetNumBits() );
+	TestTrue( TEXT( "Packet round trip" ), Loaded.Serialize( Reader ) && Loaded.Humans.Num() == Packet.Humans.Num() && Loaded.Sequence == Packet.Sequence );
+	AddInfo( FString::Printf( TEXT( "%d humans in %d bytes" ), Packet.Humans.Num(), int32( Writer.GetNumBytes() ) ) );
+
+	const double Ns = CombatPerf::Measure( 2000, [ & ]( int32 i )
+	{
+		FBitWriter PacketWriter( 0, true );
+		Packet.Serialize( PacketWriter );
+
+		FBitReader PacketReader( PacketWriter.GetData(), PacketWriter.GetNumBits() );
+		CombatPerf::Sink += Loaded.Serialize( PacketReader ) ? 1 : 0;
+	} );
+
+	return CombatPerf::Report( *this, TEXT( "CombatBroadcast.Packet" ), Ns );
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
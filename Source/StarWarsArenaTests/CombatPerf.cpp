@@ -0,0 +1,155 @@
+#include "CombatPerf.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Misc/CommandLine.h"
+#include "Misc/App.h"
+
+volatile uint32 CombatPerf::Sink = 0;
+
+namespace
+{
+	struct FPerfBaseline
+	{
+		bool							bLoaded = false;
+		double							Tolerance = 0.25;
+		TMap<FString, double>			Benchmarks;
+	};
+
+	/* Results of this run, all of them are written every time one is added */
+	TMap<FString, double>				GResults;
+
+	FString BaselinePath()
+	{
+		FString Path = FPaths::ProjectDir() / TEXT( "Source/StarWarsArenaTests/PerfBaseline.json" );
+		FParse::Value( FCommandLine::Get(), TEXT( "PerfBaseline=" ), Path );
+		return Path;
+	}
+
+	FString ResultsPath()
+	{
+		FString Path = FPaths::ProjectSavedDir() / TEXT( "Automation/CombatPerf.json" );
+		FParse::Value( FCommandLine::Get(), TEXT( "PerfJson=" ), Path );
+		return Path;
+	}
+
+	const FPerfBaseline & GetBaseline()
+	{
+		static FPerfBaseline Baseline;
+		if( Baseline.bLoaded )
+			return Baseline;
+
+		Baseline.bLoaded = true;
+
+		FString Text;
+		TSharedPtr<FJsonObject> Json;
+		if( FFileHelper::LoadFileToString( Text, *BaselinePath() ) && FJsonSerializer::Deserialize( TJsonReaderFactory<>::Create( Text ), Json ) && Json.IsValid() )
+		{
+			Json->TryGetNumberField( TEXT( "Tolerance" ), Baseline.Tolerance );
+
+			const TSharedPtr<FJsonObject> * Benchmarks;
+			if( Json->TryGetObjectField( TEXT( "Benchmarks" ), Benchmarks ) )
+			{
+				for( const auto & Entry : ( *Benchmarks )->Values )
+					Baseline.Benchmarks.Add( Entry.Key, Entry.Value->AsNumber() );
+			}
+		}
+
+		FParse::Value( FCommandLine::Get(), TEXT( "PerfTolerance=" ), Baseline.Tolerance );
+
+		return Baseline;
+	}
+
+	void WriteJson( const FString & Path, const TSharedRef<FJsonObject> & Json )
+	{
+		FString Text;
+		FJsonSerializer::Serialize( Json, TJsonWriterFactory<>::Create( &Text ) );
+
+		if( !FFileHelper::SaveStringToFile( Text, *Path ) )
+			UE_LOG( LogTemp, Warning, TEXT( "Combat perf : can not write %s" ), *Path );
+	}
+
+	void WriteResults()
+	{
+		const FPerfBaseline & Baseline = GetBaseline();
+
+		TSharedRef<FJsonObject> Benchmarks = MakeShareable( new FJsonObject() );
+		for( const auto & Result : GResults )
+		{
+			TSharedRef<FJsonObject> Entry = MakeShareable( new FJsonObject() );
+			Entry->SetNumberField( TEXT( "NsPerCall" ), Result.Value );
+
+			if( const double * BaselineNs = Baseline.Benchmarks.Find( Result.Key ) )
+			{
+				Entry->SetNumberField( TEXT( "BaselineNs" ), *BaselineNs );
+				Entry->SetNumberField( TEXT( "Ratio" ), *BaselineNs > 0.0 ? Result.Value / *BaselineNs : 0.0 );
+			}
+
+			Benchmarks->SetObjectField( Result.Key, Entry );
+		}
+
+		TSharedRef<FJsonObject> Json = MakeShareable( new FJsonObject() );
+		Json->SetStringField( TEXT( "Time" ), FDateTime::UtcNow().ToIso8601() );
+		Json->SetStringField( TEXT( "Machine" ), FPlatformProcess::ComputerName() );
+		Json->SetStringField( TEXT( "Configuration" ), EBuildConfigurations::ToString( FApp::GetBuildConfiguration() ) );
+		Json->SetNumberField( TEXT( "Tolerance" ), Baseline.Tolerance );
+		Json->SetObjectField( TEXT( "Benchmarks" ), Benchmarks );
+
+		WriteJson( ResultsPath(), Json );
+	}
+
+	void WriteBaseline()
+	{
+		TSharedRef<FJsonObject> Benchmarks = MakeShareable( new FJsonObject() );
+
+		/* Benchmarks not run this time keep their old value */
+		for( const auto & Entry : GetBaseline().Benchmarks )
+			Benchmarks->SetNumberField( Entry.Key, Entry.Value );
+
+		for( const auto & Result : GResults )
+			Benchmarks->SetNumberField( Result.Key, Result.Value );
+
+		TSharedRef<FJsonObject> Json = MakeShareable( new FJsonObject() );
+		Json->SetNumberField( TEXT( "Tolerance" ), GetBaseline().Tolerance );
+		Json->SetObjectField( TEXT( "Benchmarks" ), Benchmarks );
+
+		WriteJson( BaselinePath(), Json );
+	}
+}
+
+bool CombatPerf::Report( FAutomationTestBase & Test, const FString & Name, double NsPerCall )
+{
+	GResults.Add( Name, NsPerCall );
+	WriteResults();
+
+	if( FParse::Param( FCommandLine::Get(), TEXT( "PerfUpdateBaseline" ) ) )
+	{
+		WriteBaseline();
+		Test.AddInfo( FString::Printf( TEXT( "%s : %.2f ns, written to baseline" ), *Name, NsPerCall ) );
+		return true;
+	}
+
+	const FPerfBaseline & Baseline = GetBaseline();
+	const double * BaselineNs = Baseline.Benchmarks.Find( Name );
+
+	/* Numbers are machine specific, a missing entry is reported loudly but only a regression fails */
+	if( !BaselineNs || *BaselineNs <= 0.0 )
+	{
+		Test.AddWarning( FString::Printf( TEXT( "%s : %.2f ns, no baseline in %s. Record one with -PerfUpdateBaseline on the reference machine" ),
+										  *Name, NsPerCall, *BaselinePath() ) );
+		return true;
+	}
+
+	const double Limit = *BaselineNs * ( 1.0 + Baseline.Tolerance );
+	if( NsPerCall > Limit )
+	{
+		Test.AddError( FString::Printf( TEXT( "%s : %.2f ns, baseline %.2f ns, limit %.2f ns ( +%.0f%% )" ),
+										*Name, NsPerCall, *BaselineNs, Limit, Baseline.Tolerance * 100.0 ) );
+		return false;
+	}
+
+	Test.AddInfo( FString::Printf( TEXT( "%s : %.2f ns, baseline %.2f ns" ), *Name, NsPerCall, *BaselineNs ) );
+	return true;
+}
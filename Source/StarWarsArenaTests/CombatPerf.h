@@ -0,0 +1,48 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+
+/**
+* Timing and baseline check of combat microbenchmarks.
+* Every benchmark is measured as the median of several samples in nanoseconds per call. Report adds it to
+* Saved/Automation/CombatPerf.json ( -PerfJson=<file> ) and fails the test when it is slower than the baseline
+* in PerfBaseline.json next to this file by more than its Tolerance ( -PerfTolerance=0.25 overrides ).
+* A benchmark missing from the baseline only warns with its time. -PerfUpdateBaseline writes the measured
+* values as the new baseline instead of comparing, run it on the reference machine and commit the file.
+* Run headless: UE4Editor-Cmd StarWarsArena -ExecCmds="Automation RunTests StarWarsArena.Perf;Quit" -nullrhi -unattended
+*/
+namespace CombatPerf
+{
+	static const int32					NumSamples = 7;
+
+	/* Keeps results alive so the optimizer can not drop benchmark bodies */
+	extern volatile uint32				Sink;
+
+	/* Median time of Body in nanoseconds, Body is called Iterations times per sample after one warm up sample */
+	template<typename BodyType>
+	double Measure( int32 Iterations, BodyType && Body )
+	{
+		TArray<double> Samples;
+
+		for( int32 Sample = 0; Sample <= NumSamples; ++Sample )
+		{
+			const double StartTime = FPlatformTime::Seconds();
+
+			for( int32 i = 0; i < Iterations; ++i )
+				Body( i );
+
+			/* First sample warms caches up and is thrown away */
+			if( Sample > 0 )
+				Samples.Add( ( FPlatformTime::Seconds() - StartTime ) * 1000000000.0 / Iterations );
+		}
+
+		Samples.Sort();
+		return Samples[ Samples.Num() / 2 ];
+	}
+
+	/* Records the result and compares it with the baseline. False if it regressed, the test gets an error then */
+	bool								Report( FAutomationTestBase & Test, const FString & Name, double NsPerCall );
+}